@@ -111,6 +111,15 @@ namespace dnn
         */
         virtual void setWeights(const Blob &Wh, const Blob &Wx, const Blob &b) = 0;
 
+        /** @brief Specifies whether the first dimension of the input blob is interpreted as the timestamp dimension.
+
+        If the flag is set then the input @f$x@f$ is treated as a sequence @f$[x_0, \dots, x_{T-1}]@f$ stacked along the first axis,
+        all @f$T@f$ steps are computed by a single forward() call and the outputs contain @f$h_t@f$ and @f$c_t@f$ of each step.
+        In this case the optional inputs @f$h_{-1}@f$ and @f$c_{-1}@f$ don't have the timestamp dimension.
+        By default the flag is off and each forward() call makes exactly one step.
+        */
+        CV_EXPORTS_W virtual void setUseTimestampsDim(bool use = true) = 0;
+
         /** In common case it uses three inputs (@f$x_t@f$, @f$h_{t-1}@f$ and @f$c_{t-1}@f$) to compute compute two outputs (@f$h_t@f$ and @f$c_t@f$).
 
         @param input could contain three inputs: @f$x_t@f$, @f$h_{t-1}@f$ and @f$c_{t-1}@f$.
@@ -148,6 +157,14 @@ namespace dnn
         */
         CV_EXPORTS_W virtual void setWeights(const Blob &Whh, const Blob &Wxh, const Blob &bh, const Blob &Who, const Blob &bo) = 0;
 
+        /** @brief Specifies whether the first dimension of the input blob is interpreted as the timestamp dimension.
+
+        If the flag is set then all steps of the sequence @f$x@f$ stacked along the first axis are computed by a single forward() call
+        and the outputs contain @f$o_t@f$ and @f$h_t@f$ of each step, whereas the optional input @f$h_{-1}@f$ doesn't have the timestamp dimension.
+        By default the flag is off and each forward() call makes exactly one step.
+        */
+        CV_EXPORTS_W virtual void setUseTimestampsDim(bool use = true) = 0;
+
         /** Accepts two inputs @f$x_t@f$ and @f$h_{t-1}@f$ and compute two outputs @f$o_t@f$ and @f$h_t@f$.
 
         @param input could contain inputs @f$x_t@f$ and @f$h_{t-1}@f$.
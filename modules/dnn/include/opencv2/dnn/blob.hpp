@@ -131,6 +131,20 @@ namespace dnn
         */
         explicit Blob(InputArray image, int dstCn = -1);
 
+        /** @brief Fills 4-dimensional float blob by image or array of images in a single pass.
+         * @param image  8-bit or 32-bit float image with 1, 3 or 4 interleaved channels (or array of images of the same type).
+         * @param size   spatial size of the blob; images of other size are resized by bilinear interpolation.
+         *               If the size is empty then the size of the first image is used.
+         * @param mean   values subtracted from the blob channels.
+         * @param scale  multiplier applied after the mean subtraction.
+         * @param swapRB swaps the first and the third channels of 3- and 4-channel images, e.g. to convert BGR to RGB.
+         * @details Resizing, channel swap, normalization and packing of interleaved images into planes
+         * are done in one parallel sweep over the blob. The blob is reallocated only if its shape or type changes,
+         * so the input blob of the network, which was set by Net::setBlob(), can be filled directly.
+         */
+        void batchFromImages(InputArray image, Size size = Size(), const Scalar &mean = Scalar(),
+                             double scale = 1.0, bool swapRB = false);
+
         /** @brief Creates blob with specified @p shape and @p type. */
         void create(const BlobShape &shape, int type = CV_32F);
 
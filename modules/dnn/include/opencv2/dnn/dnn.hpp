@@ -104,6 +104,13 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
          */
         virtual void forward(std::vector<Blob*> &input, std::vector<Blob> &output) = 0;
 
+        /** @brief Returns estimated number of floating point operations which forward() makes for the allocated blobs.
+         *
+         * The estimate is reported by the network profiler, see Net::setProfiling().
+         * Default implementation returns 0 which means that the estimate is unknown.
+         */
+        virtual int64 getFLOPS(const std::vector<Blob*> &input, const std::vector<Blob> &output) const;
+
         /** @brief Returns index of input blob into the input array.
          *  @param inputName label of input blob
          *
@@ -124,6 +131,20 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
         virtual ~Layer();
     };
 
+    /** @brief Statistics of the layer collected by the network profiler.
+     *  @see Net::setProfiling()
+     */
+    struct CV_EXPORTS LayerProfile
+    {
+        int id;             //!< Identifier of the layer.
+        String name;        //!< Name of the layer.
+        String type;        //!< Type name of the layer.
+        int calls;          //!< Number of forward passes of the layer since profiling was enabled.
+        double time;        //!< Total time of these forward passes in milliseconds.
+        int64 flops;        //!< Estimated number of floating point operations of one forward pass, 0 if unknown.
+        size_t outputBytes; //!< Size of the output blobs in bytes.
+    };
+
     /** @brief This class allows to create and manipulate comprehensive artificial neural networks.
      *
      * Neural network is presented as directed acyclic graph (DAG), where vertices are Layer instances,
@@ -141,6 +162,14 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
         Net();  //!< Default constructor.
         ~Net(); //!< Destructor frees the net only if there aren't references to the net anymore.
 
+        /** @brief Creates a copy of the network which shares learned parameters with this one.
+         *
+         * The copy has the same layers and connections and its own layer instances and intermediate blobs,
+         * so both networks can run forward() simultaneously from different threads.
+         * Settings of memory usage, concurrency and fusion are copied too, whereas calibration and quantization states are not.
+         */
+        Net clone();
+
         /** @brief Adds new layer to the net.
          *  @param name   unique name of the adding layer.
          *  @param type   typename of the adding layer (type must be registered in LayerRegister).
@@ -194,6 +223,100 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
          */
         void setNetInputs(const std::vector<String> &inputBlobNames);
 
+        /** @brief Configures memory usage of intermediate blobs.
+         *  @param reuseBlobs    if true then memory of the blob is reused by other blobs as soon as all layers reading it were computed.
+         *  @param inPlaceLayers if true then element-wise layers (ReLU, TanH, Sigmoid, etc.) overwrite their input blob,
+         *                       if nobody else reads it.
+         *
+         * By default blobs reusing is disabled, so getBlob() returns output of any layer after forward(),
+         * and in-place computations are enabled.
+         * Outputs of the network (i. e. layer outputs which aren't connected to any other layer) are never reused,
+         * but contents of the other blobs are undefined after forward() if @p reuseBlobs is enabled.
+         * The network will be reallocated on the next forward() call.
+         */
+        void setMemoryReuse(bool reuseBlobs, bool inPlaceLayers = true);
+
+        /** @brief Sets the maximal number of layers which forward() computes simultaneously.
+         *
+         * If @p maxLayers is greater than 1 then independent branches of the network (like inception modules of GoogLeNet)
+         * are computed in parallel by cv::parallel_for_ workers. Layers use multithreading internally too,
+         * so small values are preferable to avoid oversubscription of CPU cores.
+         * By default @p maxLayers is 1, i. e. layers are computed one by one.
+         * @note Forward pass to the specified layer, forward(LayerId), always computes layers one by one.
+         */
+        void setMaxConcurrentLayers(int maxLayers);
+
+        /** @brief Enables or disables fusion of layers.
+         *
+         * If fusion is enabled (default) then activation layers (ReLU, TanH, Sigmoid, etc.) which directly follow
+         * convolution or fully connected layers are applied by these layers while their outputs are hot in cache,
+         * and the activation layers themselves only pass the data through.
+         * @note When fusion is enabled the output blob of a fused convolution or fully connected layer contains activated values.
+         * The network will be reallocated on the next forward() call.
+         */
+        void setLayersFusion(bool fusion);
+
+        /** @brief Saves learned parameters of all layers into the file of native format.
+         *
+         * Convert a model once: import it by any Importer and call this method.
+         * Later the file can be passed to createCaffeImporter() instead of .caffemodel, or read by readWeights().
+         */
+        void writeWeights(const String &path);
+
+        /** @brief Sets learned parameters of the layers from the file written by writeWeights().
+         *
+         * The file is memory mapped and blobs of the layers wrap the mapped pages without copying,
+         * so several processes loading the same file share one physical copy of the weights.
+         * Pages are mapped copy-on-write: a modified blob gets private copies of the touched pages and the file is never changed.
+         * The file is unmapped when all of these blobs are released.
+         * Parameters of layers which are absent in the file are left unchanged, the network will be reallocated
+         * on the next forward() call, what also requantizes weights of the layers switched to int8 by setQuantization().
+         */
+        void readWeights(const String &path);
+
+        /** @brief Enables or disables calibration for quantized computations.
+         *
+         * While calibration is enabled, forward() records ranges of inputs of convolution and fully connected layers.
+         * Run forward() on several representative inputs, then disable calibration and call setQuantization().
+         * Enabling of calibration resets previously recorded ranges.
+         */
+        void setCalibration(bool enable);
+
+        /** @brief Switches convolution and fully connected layers to int8 computations.
+         *
+         * Weights are quantized to int8 with a scale per output channel, inputs are quantized with the scale
+         * obtained during calibration, products are accumulated in int32. Layers which weren't calibrated stay in float.
+         * Blobs of the network remain float. If @p enable is false then float computations are restored.
+         * The network will be reallocated on the next forward() call.
+         * @see setCalibration()
+         */
+        void setQuantization(bool enable);
+
+        /** @brief Enables or disables per-layer profiling of forward passes.
+         *
+         * While profiling is enabled, forward() measures wall time of each computed layer.
+         * Enabling of profiling discards previously collected statistics. When profiling is disabled the network
+         * doesn't measure anything, but collected statistics are kept until the next enabling.
+         * @see getProfile(), writeProfileTrace()
+         */
+        void setProfiling(bool enable);
+
+        /** @brief Returns statistics of the layers in order of their addition to the network.
+         *
+         * Estimates of operations and sizes of outputs are computed for the current shapes of blobs.
+         * Outputs of different layers may share memory, see setMemoryReuse(),
+         * so the sum of LayerProfile::outputBytes may be greater than the actually allocated memory.
+         * Layers which were fused into their parents aren't computed and have zero LayerProfile::calls.
+         */
+        void getProfile(std::vector<LayerProfile> &profile);
+
+        /** @brief Writes each profiled forward pass of the layers into the file in Chrome trace event format.
+         *
+         * The file can be viewed in the chrome://tracing page of Chrome browser.
+         * Layers computed simultaneously (see setMaxConcurrentLayers()) are shown on different threads.
+         */
+        void writeProfileTrace(const String &path);
+
         /** @brief Runs forward pass for the whole network */
         void forward();
         /** @brief Runs forward pass to compute output of layer @p toLayer */
@@ -216,13 +339,14 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
          *  @param outputName descriptor of the updating layer output blob.
          *  @param blob new blob.
          *  @see connect(String, String) to know format of the descriptor.
-         *  @note If updating blob is not empty then @p blob must have the same shape,
-         *  because network reshaping is not implemented yet.
+         *  @note If shape of the network input blob changes then the network will be reallocated on the next forward() call.
+         *  Other updating blobs must keep their shapes.
          */
         void setBlob(String outputName, const Blob &blob);
         /** @brief Returns the layer output blob.
          *  @param outputName the descriptor of the returning layer output blob.
          *  @see connect(String, String)
+         *  @note Intermediate blobs could be overwritten during forward() if memory reuse is enabled, see setMemoryReuse().
          */
         Blob getBlob(String outputName);
 
@@ -248,6 +372,111 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
         Ptr<Impl> impl;
     };
 
+    /** @brief Thread-safe front-end which computes requests of many callers on a pool of network copies.
+     *
+     * Workers are copies of the network made by Net::clone(), so they share learned parameters and have own intermediate blobs.
+     * Requests passed to process() by concurrent callers are queued and stacked along the first (@p num) dimension
+     * into batches of up to @p maxBatchSize samples. A batch is computed as soon as it is full,
+     * or when the oldest request of the queue has waited for @p maxDelay milliseconds.
+     * Smaller batches are padded with zero samples up to @p maxBatchSize, so the workers keep the allocation of their blobs.
+     * Batches are computed by the threads which called process(), so the queue doesn't create its own threads.
+     */
+    class CV_EXPORTS InferenceQueue
+    {
+    public:
+
+        /** @brief Creates the queue.
+         *  @param net          the network, which is cloned for each worker. The network itself isn't used by the queue.
+         *  @param inputName    descriptor of the network input blob.
+         *  @param outputName   descriptor of the network output blob, its first dimension must be equal to the input one.
+         *  @param numWorkers   number of batches which can be computed simultaneously.
+         *  @param maxBatchSize maximal number of samples in the batch.
+         *  @param maxDelay     maximal time in milliseconds the request waits for other requests to fill the batch.
+         */
+        InferenceQueue(Net net, const String &inputName, const String &outputName,
+                       int numWorkers = 1, int maxBatchSize = 8, double maxDelay = 1.);
+
+        /** @brief Computes the network output for @p input.
+         *
+         * Blocks until the result is ready. Requests are batched only with requests whose shapes differ in the first dimension only.
+         * If an error happens during the computation of the batch then the exception is rethrown to the callers of all its requests.
+         * @returns the output blob, its first dimension is equal to the one of @p input.
+         */
+        Blob process(const Blob &input);
+
+    private:
+
+        struct Impl;
+        Ptr<Impl> impl;
+    };
+
+    /** @brief Computes the network for the stream of inputs, e.g. video frames, asynchronously.
+     *
+     * The stream owns @p numStages copies of the network made by Net::clone() and a thread for each of them.
+     * Consecutive requests are assigned to the copies in round-robin order, so the request is computed
+     * while the following ones are converted and computed by the other copies.
+     * Each copy has its own input blob, so the next input is written while the previous one is in use.
+     * Results become ready in the order of submission.
+     * Copies of the object refer to the same stream, its pending requests are completed when the last copy is destroyed.
+     */
+    class CV_EXPORTS AsyncForward
+    {
+    public:
+
+        /** @brief Result of the asynchronous forward pass. */
+        class CV_EXPORTS Future
+        {
+        public:
+            Future();
+
+            /** @brief Returns true if the future refers to the submitted request. */
+            bool valid() const;
+            /** @brief Returns true if the result is ready, i.e. get() doesn't block. */
+            bool ready() const;
+            /** @brief Waits for the result at most @p timeout milliseconds, forever if @p timeout is negative.
+             *  @returns ready().
+             */
+            bool wait(double timeout = -1) const;
+            /** @brief Waits for the result and returns the output blob.
+             *
+             * If an error happened during the forward pass then the exception is rethrown.
+             */
+            Blob get() const;
+
+        private:
+
+            struct State;
+            Ptr<State> state;
+            friend class AsyncForward;
+        };
+
+        /** @brief Creates the stream.
+         *  @param net        the network, which is cloned for each stage. The network itself isn't used by the stream.
+         *  @param inputName  descriptor of the network input blob.
+         *  @param outputName descriptor of the network output blob.
+         *  @param numStages  number of requests which can be computed simultaneously.
+         */
+        AsyncForward(Net net, const String &inputName, const String &outputName, int numStages = 2);
+
+        /** @brief Submits the forward pass of @p input.
+         *
+         * The blob is copied into the input blob of the next network copy, so it can be reused right after the call.
+         * Blocks while this copy computes the previous request assigned to it.
+         */
+        Future forward(const Blob &input);
+
+        /** @overload
+         *  @param images image or array of images, which are converted to the blob like Blob(InputArray) does.
+         *  The images are copied and the conversion is made by the stage thread.
+         */
+        Future forward(InputArray images);
+
+    private:
+
+        struct Impl;
+        Ptr<Impl> impl;
+    };
+
     /** @brief Small interface class for loading trained serialized models of different dnn-frameworks. */
     class Importer
     {
@@ -261,7 +490,8 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
 
     /** @brief Creates the importer of <a href="http://caffe.berkeleyvision.org">Caffe</a> framework network.
      *  @param prototxt   path to the .prototxt file with text description of the network architecture.
-     *  @param caffeModel path to the .caffemodel file with learned network.
+     *  @param caffeModel path to the .caffemodel file with learned network,
+     *                    or to the file written by Net::writeWeights(), which is memory mapped instead of parsing.
      *  @returns Pointer to the created importer, NULL in failure cases.
      */
     CV_EXPORTS Ptr<Importer> createCaffeImporter(const String &prototxt, const String &caffeModel = String());
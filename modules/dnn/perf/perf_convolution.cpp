@@ -77,4 +77,107 @@ PERF_TEST_P( ConvolutionPerfTest, perf, Combine(
     SANITY_CHECK_NOTHING();
 }
 
+enum {CONV_AUTO, CONV_IM2COL, CONV_WINOGRAD, CONV_DIRECT};
+CV_ENUM(ConvAlgo, CONV_AUTO, CONV_IM2COL, CONV_WINOGRAD, CONV_DIRECT);
+static const char *convAlgoNames[] = {"auto", "im2col", "winograd", "direct"};
+
+typedef tuple<Size, InpShapeNumOut, ConvAlgo> ConvAlgoParam; //kernel_size, inp shape, algorithm
+typedef TestBaseWithParam<ConvAlgoParam> ConvolutionAlgoPerfTest;
+
+PERF_TEST_P( ConvolutionAlgoPerfTest, perf, Combine(
+    Values(Size(3, 3), Size(5, 5)),
+    Values(make_pair(BlobShape(1,   3, 224, 224),  64),
+           make_pair(BlobShape(1,  64, 112, 112),  64),
+           make_pair(BlobShape(1, 256,  28,  28), 256)),
+    ConvAlgo::all())
+)
+{
+    RNG rng(0);
+
+    ConvAlgoParam params = GetParam();
+    int ksz     = get<0>(params).width;
+    BlobShape inpShape = get<1>(params).first;
+    int outCn   = get<1>(params).second;
+    String algo = convAlgoNames[(int)get<2>(params)];
+
+    int inpCn = inpShape[1];
+    Blob wgtBlob(BlobShape(outCn, inpCn, ksz, ksz)), biasBlob(BlobShape(outCn, 1, 1, 1));
+    Blob inpBlob(inpShape);
+    rng.fill(biasBlob.matRef(), RNG::UNIFORM, -1, +1);
+    rng.fill(wgtBlob.matRef(), RNG::UNIFORM, -1, +1);
+    rng.fill(inpBlob.matRef(), RNG::UNIFORM, -1, +1);
+
+    LayerParams lp;
+    lp.set("num_output", outCn);
+    lp.set("kernel_size", ksz);
+    lp.set("pad", ksz / 2);
+    lp.set("conv_algorithm", algo);
+    lp.blobs.reserve(2);
+    lp.blobs.push_back(wgtBlob);
+    lp.blobs.push_back(biasBlob);
+
+    std::vector<Blob*> inpBlobs(1, &inpBlob);
+    std::vector<Blob> outBlobs;
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+
+    Ptr<Layer> layer = cv::dnn::LayerFactory::createLayerInstance("Convolution", lp);
+    layer->allocate(inpBlobs, outBlobs);
+
+    declare.in(inpBlob.matRef(), wgtBlob.matRef(), WARMUP_RNG).out(outBlobs[0].matRef()).tbb_threads(cv::getNumThreads());
+
+    TEST_CYCLE_N(10)
+    {
+        layer->forward(inpBlobs, outBlobs);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef tuple<int, int> ConvBatchParam; //batch size, number of threads
+typedef TestBaseWithParam<ConvBatchParam> ConvolutionBatchPerfTest;
+
+PERF_TEST_P( ConvolutionBatchPerfTest, perf, Combine(
+    Values(1, 8, 32),
+    Values(1, 0)) //0 means all cores
+)
+{
+    RNG rng(0);
+
+    int batchSize = get<0>(GetParam());
+    int threads = get<1>(GetParam());
+
+    Blob wgtBlob(BlobShape(64, 32, 3, 3)), biasBlob(BlobShape(64, 1, 1, 1));
+    Blob inpBlob(BlobShape(batchSize, 32, 56, 56));
+    rng.fill(biasBlob.matRef(), RNG::UNIFORM, -1, +1);
+    rng.fill(wgtBlob.matRef(), RNG::UNIFORM, -1, +1);
+    rng.fill(inpBlob.matRef(), RNG::UNIFORM, -1, +1);
+
+    LayerParams lp;
+    lp.set("num_output", 64);
+    lp.set("kernel_size", 3);
+    lp.set("pad", 1);
+    lp.set("conv_algorithm", "im2col");
+    lp.blobs.reserve(2);
+    lp.blobs.push_back(wgtBlob);
+    lp.blobs.push_back(biasBlob);
+
+    std::vector<Blob*> inpBlobs(1, &inpBlob);
+    std::vector<Blob> outBlobs;
+
+    cv::setNumThreads((threads > 0) ? threads : cv::getNumberOfCPUs());
+
+    Ptr<Layer> layer = cv::dnn::LayerFactory::createLayerInstance("Convolution", lp);
+    layer->allocate(inpBlobs, outBlobs);
+
+    declare.in(inpBlob.matRef(), wgtBlob.matRef(), WARMUP_RNG).out(outBlobs[0].matRef()).tbb_threads(cv::getNumThreads());
+
+    TEST_CYCLE_N(10)
+    {
+        layer->forward(inpBlobs, outBlobs);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 }
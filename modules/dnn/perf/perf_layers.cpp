@@ -0,0 +1,160 @@
+#include "perf_precomp.hpp"
+
+namespace cvtest
+{
+
+using std::tr1::tuple;
+using std::tr1::get;
+using namespace perf;
+using namespace testing;
+using namespace cv;
+using namespace cv::dnn;
+
+//shapes of AlexNet and GoogLeNet layers
+static const BlobShape alexConv1(1,  96, 55, 55);
+static const BlobShape alexConv2(1, 256, 27, 27);
+static const BlobShape googConv2(1, 192, 56, 56);
+
+static Ptr<Layer> createLayer(const String &type, LayerParams &lp, Blob &inpBlob,
+                              std::vector<Blob*> &inpBlobs, std::vector<Blob> &outBlobs)
+{
+    RNG rng(0);
+    rng.fill(inpBlob.matRef(), RNG::UNIFORM, -1, +1);
+    inpBlobs.assign(1, &inpBlob);
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+
+    Ptr<Layer> layer = cv::dnn::LayerFactory::createLayerInstance(type, lp);
+    layer->allocate(inpBlobs, outBlobs);
+    return layer;
+}
+
+enum {POOL_MAX, POOL_AVE};
+CV_ENUM(PoolType, POOL_MAX, POOL_AVE);
+
+typedef tuple<BlobShape, PoolType, int> PoolingParam; //inp shape, pooling type, stride
+typedef TestBaseWithParam<PoolingParam> PoolingPerfTest;
+
+PERF_TEST_P( PoolingPerfTest, perf, Combine(
+    Values(alexConv1, alexConv2, googConv2),
+    PoolType::all(),
+    Values(1, 2))
+)
+{
+    BlobShape inpShape = get<0>(GetParam());
+    bool isMax = (int)get<1>(GetParam()) == POOL_MAX;
+    int stride = get<2>(GetParam());
+
+    LayerParams lp;
+    lp.set("pool", isMax ? "max" : "ave");
+    lp.set("kernel_size", 3);
+    lp.set("stride", stride);
+    lp.set("pad", 1);
+
+    Blob inpBlob(inpShape);
+    std::vector<Blob*> inpBlobs;
+    std::vector<Blob> outBlobs;
+    Ptr<Layer> layer = createLayer("Pooling", lp, inpBlob, inpBlobs, outBlobs);
+
+    declare.in(inpBlob.matRef(), WARMUP_RNG).out(outBlobs[0].matRef()).tbb_threads(cv::getNumThreads());
+
+    TEST_CYCLE_N(10)
+    {
+        layer->forward(inpBlobs, outBlobs);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+enum {LRN_CHANNELS, LRN_SPATIAL};
+CV_ENUM(LRNType, LRN_CHANNELS, LRN_SPATIAL);
+
+typedef tuple<BlobShape, LRNType> LRNParam; //inp shape, normalization region
+typedef TestBaseWithParam<LRNParam> LRNPerfTest;
+
+PERF_TEST_P( LRNPerfTest, perf, Combine(
+    Values(alexConv1, alexConv2),
+    LRNType::all())
+)
+{
+    BlobShape inpShape = get<0>(GetParam());
+    bool acrossChannels = (int)get<1>(GetParam()) == LRN_CHANNELS;
+
+    LayerParams lp;
+    lp.set("norm_region", acrossChannels ? "ACROSS_CHANNELS" : "WITHIN_CHANNEL");
+    lp.set("local_size", 5);
+    lp.set("alpha", 1e-4);
+    lp.set("beta", 0.75);
+
+    Blob inpBlob(inpShape);
+    std::vector<Blob*> inpBlobs;
+    std::vector<Blob> outBlobs;
+    Ptr<Layer> layer = createLayer("LRN", lp, inpBlob, inpBlobs, outBlobs);
+
+    declare.in(inpBlob.matRef(), WARMUP_RNG).out(outBlobs[0].matRef()).tbb_threads(cv::getNumThreads());
+
+    TEST_CYCLE_N(10)
+    {
+        layer->forward(inpBlobs, outBlobs);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef TestBaseWithParam<BlobShape> SoftmaxPerfTest;
+
+PERF_TEST_P( SoftmaxPerfTest, perf,
+    Values(BlobShape(1, 1000, 1, 1),   //classification
+           BlobShape(32, 1000, 1, 1),  //batch of classifications
+           BlobShape(1, 21, 128, 128)) //segmentation
+)
+{
+    LayerParams lp;
+
+    Blob inpBlob(GetParam());
+    std::vector<Blob*> inpBlobs;
+    std::vector<Blob> outBlobs;
+    Ptr<Layer> layer = createLayer("Softmax", lp, inpBlob, inpBlobs, outBlobs);
+
+    declare.in(inpBlob.matRef(), WARMUP_RNG).out(outBlobs[0].matRef()).tbb_threads(cv::getNumThreads());
+
+    TEST_CYCLE_N(10)
+    {
+        layer->forward(inpBlobs, outBlobs);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef tuple<Size, int> BatchFromImagesParam; //blob size, number of images
+typedef TestBaseWithParam<BatchFromImagesParam> BatchFromImagesPerfTest;
+
+PERF_TEST_P( BatchFromImagesPerfTest, perf, Combine(
+    Values(Size(640, 480), Size(224, 224)),
+    Values(1, 8))
+)
+{
+    Size size = get<0>(GetParam());
+    int numImages = get<1>(GetParam());
+
+    std::vector<Mat> images(numImages);
+    for (int i = 0; i < numImages; i++)
+    {
+        images[i].create(480, 640, CV_8UC3);
+        randu(images[i], 0, 256);
+    }
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+
+    Blob blob;
+    declare.tbb_threads(cv::getNumThreads());
+
+    TEST_CYCLE_N(10)
+    {
+        blob.batchFromImages(images, size, Scalar(104, 117, 123), 1.0, true);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}
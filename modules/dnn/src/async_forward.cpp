@@ -0,0 +1,322 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "precomp.hpp"
+#include "threading.hpp"
+
+namespace cv
+{
+namespace dnn
+{
+
+struct AsyncForward::Future::State
+{
+    State() : done(false), failed(false) {}
+
+    Monitor monitor;
+    bool done, failed;
+    Blob output;
+    cv::Exception error;
+
+    bool wait(double timeoutMs)
+    {
+        int64 deadline = getTickCount() + (int64)(timeoutMs * 1e-3 * getTickFrequency());
+
+        monitor.lock();
+        while (!done)
+        {
+            if (timeoutMs < 0)
+            {
+                monitor.wait();
+                continue;
+            }
+
+            int64 delay = deadline - getTickCount();
+            if (delay <= 0)
+                break;
+            monitor.wait(delay * 1000. / getTickFrequency());
+        }
+        bool res = done;
+        monitor.unlock();
+        return res;
+    }
+
+    void finish(const Blob &_output, bool _failed, const cv::Exception &_error)
+    {
+        monitor.lock();
+        output = _output;
+        failed = _failed;
+        if (failed)
+            error = _error;
+        done = true;
+        monitor.notifyAll();
+        monitor.unlock();
+    }
+};
+
+AsyncForward::Future::Future() {}
+
+bool AsyncForward::Future::valid() const
+{
+    return !state.empty();
+}
+
+bool AsyncForward::Future::ready() const
+{
+    return wait(0);
+}
+
+bool AsyncForward::Future::wait(double timeout) const
+{
+    CV_Assert(valid());
+    return state->wait(timeout);
+}
+
+Blob AsyncForward::Future::get() const
+{
+    CV_Assert(valid());
+    state->wait(-1);
+    if (state->failed)
+        throw state->error;
+    return state->output;
+}
+
+typedef AsyncForward::Future::State AsyncState;
+
+//network copy with own input buffer and thread
+struct AsyncStage
+{
+    AsyncStage() : fromImages(false), busy(false), stop(false) {}
+
+    Net net;
+    String inputName, outputName;
+
+    //written by the submitter while the stage is idle
+    Blob input;
+    std::vector<Mat> images;
+    bool fromImages;
+    Ptr<AsyncState> state, previous;
+
+    Monitor monitor;
+    bool busy, stop;
+    Thread thread;
+
+    void compute(const Ptr<AsyncState> &current, const Ptr<AsyncState> &prev)
+    {
+        Blob output;
+        bool failed = false;
+        cv::Exception error;
+        try
+        {
+            //conversion of images overlaps with computations of other stages
+            if (fromImages)
+                input = Blob(images);
+
+            net.setBlob(inputName, input);
+            net.forward();
+
+            //the output is copied because the stage overwrites it by the next request
+            Blob out = net.getBlob(outputName);
+            output.fill(out.shape(), out.type(), out.ptr(), true);
+        }
+        catch (const cv::Exception &e)
+        {
+            failed = true;
+            error = e;
+        }
+        catch (const std::exception &e)
+        {
+            failed = true;
+            error = cv::Exception(Error::StsError, e.what(), CV_Func, __FILE__, __LINE__);
+        }
+        catch (...)
+        {
+            //nothing may escape the thread of the stage, otherwise the future is never finished
+            failed = true;
+            error = cv::Exception(Error::StsError, "Unknown exception in the forward pass", CV_Func, __FILE__, __LINE__);
+        }
+
+        //results are published in the order of submission
+        if (!prev.empty())
+            prev->wait(-1);
+        current->finish(output, failed, error);
+    }
+
+    static void run(void *arg)
+    {
+        AsyncStage *stage = (AsyncStage*)arg;
+
+        stage->monitor.lock();
+        for (;;)
+        {
+            while (!stage->busy && !stage->stop)
+                stage->monitor.wait();
+            if (!stage->busy)
+                break;
+
+            Ptr<AsyncState> current = stage->state, prev = stage->previous;
+            stage->monitor.unlock();
+
+            stage->compute(current, prev);
+
+            stage->monitor.lock();
+            stage->state.release();
+            stage->previous.release();
+            stage->busy = false;
+            stage->monitor.notifyAll();
+        }
+        stage->monitor.unlock();
+    }
+
+    //waits until the previous request of the stage is computed
+    void acquire()
+    {
+        monitor.lock();
+        while (busy)
+            monitor.wait();
+        monitor.unlock();
+    }
+
+    void launch(const Ptr<AsyncState> &current, const Ptr<AsyncState> &prev)
+    {
+        monitor.lock();
+        state = current;
+        previous = prev;
+        busy = true;
+        monitor.notifyAll();
+        monitor.unlock();
+    }
+
+    void shutdown()
+    {
+        monitor.lock();
+        stop = true;
+        monitor.notifyAll();
+        monitor.unlock();
+        thread.join();
+    }
+};
+
+struct AsyncForward::Impl
+{
+    Mutex mutex;
+    std::vector<Ptr<AsyncStage> > stages;
+    size_t next;
+    Ptr<AsyncState> last;
+
+    Impl() : next(0) {}
+
+    ~Impl()
+    {
+        //pending requests are completed before the threads exit
+        for (size_t i = 0; i < stages.size(); i++)
+            stages[i]->shutdown();
+    }
+
+    //called under the mutex, the returned stage is idle
+    AsyncStage &acquireStage()
+    {
+        AsyncStage &stage = *stages[next];
+        stage.acquire();
+        return stage;
+    }
+
+    Future launchStage(AsyncStage &stage)
+    {
+        Future future;
+        future.state = makePtr<AsyncState>();
+
+        stage.launch(future.state, last);
+        last = future.state;
+        next = (next + 1) % stages.size();
+        return future;
+    }
+};
+
+AsyncForward::AsyncForward(Net net, const String &inputName, const String &outputName, int numStages)
+    : impl(new Impl)
+{
+    CV_Assert(numStages > 0);
+
+    for (int i = 0; i < numStages; i++)
+    {
+        Ptr<AsyncStage> stage = makePtr<AsyncStage>();
+        stage->net = net.clone();
+        stage->inputName = inputName;
+        stage->outputName = outputName;
+        stage->thread.start(AsyncStage::run, stage.get());
+        impl->stages.push_back(stage);
+    }
+}
+
+AsyncForward::Future AsyncForward::forward(const Blob &input)
+{
+    AutoLock lock(impl->mutex);
+    AsyncStage &stage = impl->acquireStage();
+
+    input.matRefConst().copyTo(stage.input.matRef());
+    stage.fromImages = false;
+
+    return impl->launchStage(stage);
+}
+
+AsyncForward::Future AsyncForward::forward(InputArray images)
+{
+    AutoLock lock(impl->mutex);
+    AsyncStage &stage = impl->acquireStage();
+
+    std::vector<Mat> src;
+    if (images.isMatVector() || images.isUMatVector())
+        images.getMatVector(src);
+    else
+        src.push_back(images.getMat());
+
+    //buffers are reused if the shapes of images don't change
+    stage.images.resize(src.size());
+    for (size_t i = 0; i < src.size(); i++)
+        src[i].copyTo(stage.images[i]);
+    stage.fromImages = true;
+
+    return impl->launchStage(stage);
+}
+
+}
+}
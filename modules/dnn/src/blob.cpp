@@ -40,6 +40,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv
 {
@@ -119,6 +120,193 @@ namespace dnn
         }
     }
 
+    //maps destination coordinate to two source ones like bilinear cv::resize does
+    static inline void mapLinear(int dst, int srcSize, int dstSize, int &src0, int &src1, float &alpha)
+    {
+        float f = (float)((dst + 0.5) * srcSize / dstSize - 0.5);
+        int s = cvFloor(f);
+        f -= s;
+
+        if (s < 0)
+        {
+            s = 0;
+            f = 0;
+        }
+        if (s >= srcSize - 1)
+        {
+            s = srcSize - 1;
+            f = 0;
+        }
+
+        src0 = s;
+        src1 = std::min(s + 1, srcSize - 1);
+        alpha = f;
+    }
+
+    //resizes, normalizes and packs interleaved images into planes of the 4-dimensional blob row by row
+    template<typename T>
+    class ImagesToBlobInvoker : public ParallelLoopBody
+    {
+    public:
+
+        ImagesToBlobInvoker(const std::vector<Mat> &_images, Mat &_dst, const Scalar &mean, double scale, bool swapRB)
+            : images(_images), dst(_dst)
+        {
+            cn = images[0].channels();
+            rows = dst.size[2];
+            cols = dst.size[3];
+
+            for (int c = 0; c < cn; c++)
+            {
+                srcCn[c] = (swapRB && cn >= 3 && c < 3) ? 2 - c : c;
+                scales[c] = (float)scale;
+                shifts[c] = (float)(-mean[c] * scale);
+            }
+        }
+
+        void operator()(const Range &range) const
+        {
+            int rowSize = cols * cn;
+            AutoBuffer<int> xofsBuf(2 * cols);
+            AutoBuffer<float> buf(3 * rowSize + cols);
+            int *xofs = xofsBuf;
+            float *xalpha = (float*)buf + 3 * rowSize;
+            float *hrows[2] = { buf, (float*)buf + rowSize };
+            float *row = (float*)buf + 2 * rowSize;
+            int cached[2] = { -1, -1 };
+            int curImage = -1;
+
+            for (int r = range.start; r < range.end; r++)
+            {
+                int n = r / rows, y = r % rows;
+                const Mat &img = images[n];
+
+                float *planes[4];
+                for (int c = 0; c < cn; c++)
+                    planes[c] = dst.ptr<float>(n, c, y);
+
+                if (img.rows == rows && img.cols == cols)
+                {
+                    pack(img.ptr<T>(y), planes);
+                    continue;
+                }
+
+                if (n != curImage)
+                {
+                    for (int x = 0; x < cols; x++)
+                    {
+                        int sx0, sx1;
+                        mapLinear(x, img.cols, cols, sx0, sx1, xalpha[x]);
+                        xofs[2*x] = sx0 * cn;
+                        xofs[2*x + 1] = sx1 * cn;
+                    }
+                    cached[0] = cached[1] = -1;
+                    curImage = n;
+                }
+
+                int sy0, sy1;
+                float beta;
+                mapLinear(y, img.rows, rows, sy0, sy1, beta);
+
+                //horizontally interpolated source rows are shared by neighbouring destination rows
+                int k1 = (cached[0] == sy1) ? 0 : (cached[1] == sy1) ? 1 : -1;
+                int k0 = (cached[0] == sy0) ? 0 : (cached[1] == sy0) ? 1 : -1;
+                if (k0 < 0)
+                {
+                    k0 = (k1 == 0) ? 1 : 0;
+                    interpolateRow(img.ptr<T>(sy0), xofs, xalpha, hrows[k0]);
+                    cached[k0] = sy0;
+                }
+                if (sy1 == sy0)
+                {
+                    k1 = k0;
+                }
+                else if (k1 < 0)
+                {
+                    k1 = 1 - k0;
+                    interpolateRow(img.ptr<T>(sy1), xofs, xalpha, hrows[k1]);
+                    cached[k1] = sy1;
+                }
+
+                blendRows(hrows[k0], hrows[k1], beta, row, rowSize);
+                pack(row, planes);
+            }
+        }
+
+    private:
+
+        void interpolateRow(const T *src, const int *xofs, const float *xalpha, float *dstRow) const
+        {
+            for (int x = 0; x < cols; x++)
+            {
+                const T *s0 = src + xofs[2*x], *s1 = src + xofs[2*x + 1];
+                float a = xalpha[x];
+                for (int c = 0; c < cn; c++)
+                    dstRow[x*cn + c] = s0[c] + (s1[c] - (float)s0[c]) * a;
+            }
+        }
+
+        static void blendRows(const float *row0, const float *row1, float beta, float *dstRow, int len)
+        {
+            int i = 0;
+#if CV_SIMD128
+            v_float32x4 vbeta = v_setall_f32(beta);
+            for (; i <= len - 4; i += 4)
+            {
+                v_float32x4 v0 = v_load(row0 + i);
+                v_store(dstRow + i, v0 + (v_load(row1 + i) - v0) * vbeta);
+            }
+#endif
+            for (; i < len; i++)
+                dstRow[i] = row0[i] + (row1[i] - row0[i]) * beta;
+        }
+
+        template<typename TSrc>
+        void pack(const TSrc *src, float **planes) const
+        {
+            for (int c = 0; c < cn; c++)
+            {
+                const TSrc *s = src + srcCn[c];
+                float *d = planes[c];
+                float scale = scales[c], shift = shifts[c];
+                for (int x = 0; x < cols; x++)
+                    d[x] = s[x*cn] * scale + shift;
+            }
+        }
+
+        const std::vector<Mat> &images;
+        Mat &dst;
+        int cn, rows, cols;
+        int srcCn[4];
+        float scales[4], shifts[4];
+    };
+
+    static bool canConvertImages(const std::vector<Mat> &images)
+    {
+        int type = images[0].type();
+        if ((CV_MAT_DEPTH(type) != CV_8U && CV_MAT_DEPTH(type) != CV_32F) || CV_MAT_CN(type) > 4)
+            return false;
+
+        for (size_t i = 0; i < images.size(); i++)
+        {
+            if (images[i].empty() || images[i].dims > 2 || images[i].type() != type)
+                return false;
+        }
+        return true;
+    }
+
+    //dst must be allocated 4-dimensional float blob
+    static void convertImages(const std::vector<Mat> &images, Mat &dst, const Scalar &mean, double scale, bool swapRB)
+    {
+        int totalRows = dst.size[0] * dst.size[2];
+        int nstripes = (int)std::min<size_t>(totalRows, std::max<size_t>(1, dst.total() >> 16));
+
+        if (images[0].depth() == CV_8U)
+            parallel_for_(Range(0, totalRows), ImagesToBlobInvoker<uchar>(images, dst, mean, scale, swapRB), nstripes);
+        else
+            parallel_for_(Range(0, totalRows), ImagesToBlobInvoker<float>(images, dst, mean, scale, swapRB), nstripes);
+    }
+
     Blob::Blob(InputArray image, int dstCn)
     {
         CV_Assert(dstCn == -1 || dstCn > 0);
@@ -127,6 +315,12 @@ namespace dnn
 
         m.create(dstShape.dims(), dstShape.ptr(), CV_32F);
 
+        if (dstShape[1] == inMats[0].channels() && canConvertImages(inMats))
+        {
+            convertImages(inMats, m, Scalar(), 1.0, false);
+            return;
+        }
+
         std::vector<Mat> wrapBuf(dstShape[-3]);
         int elemSize = (int)m.elemSize();
         uchar *ptr = this->ptr();
@@ -155,11 +349,37 @@ namespace dnn
         }
     }
 
+    void Blob::batchFromImages(InputArray image, Size size, const Scalar &mean, double scale, bool swapRB)
+    {
+        std::vector<Mat> inMats = extractMatVector(image);
+        CV_Assert(inMats.size() > 0 && canConvertImages(inMats));
+
+        if (size == Size())
+            size = inMats[0].size();
+        CV_Assert(size.width > 0 && size.height > 0);
+
+        BlobShape dstShape((int)inMats.size(), inMats[0].channels(), size.height, size.width);
+        if (m.type() != CV_32F || !(shape() == dstShape))
+            create(dstShape, CV_32F);
+
+        convertImages(inMats, m, mean, scale, swapRB);
+    }
+
     Blob::Blob(const BlobShape &shape, int type)
     {
         this->create(shape, type);
     }
 
+    void Blob::fill(InputArray in)
+    {
+        CV_Assert(in.type() == CV_32F || in.type() == CV_64F);
+
+        if (in.isMat())
+            m = in.getMat();
+        else
+            in.copyTo(m);
+    }
+
     void Blob::fill(const BlobShape &shape, int type, void *data, bool deepCopy)
     {
         CV_Assert(type == CV_32F || type == CV_64F);
@@ -53,6 +53,7 @@ using namespace cv::dnn;
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include "caffe_io.hpp"
+#include "../weights_file.hpp"
 
 using ::google::protobuf::RepeatedField;
 using ::google::protobuf::RepeatedPtrField;
@@ -67,6 +68,7 @@ namespace
     {
         caffe::NetParameter net;
         caffe::NetParameter netBinary;
+        Ptr<WeightsFile> weightsFile;
 
     public:
 
@@ -75,7 +77,13 @@ namespace
             ReadNetParamsFromTextFileOrDie(pototxt, &net);
 
             if (caffeModel && caffeModel[0])
-                ReadNetParamsFromBinaryFileOrDie(caffeModel, &netBinary);
+            {
+                //weights converted by Net::writeWeights() are mapped instead of parsing
+                if (WeightsFile::isWeightsFile(caffeModel))
+                    weightsFile = WeightsFile::open(caffeModel);
+                else
+                    ReadNetParamsFromBinaryFileOrDie(caffeModel, &netBinary);
+            }
         }
 
         void addParam(const Message &msg, const FieldDescriptor *field, cv::dnn::LayerParams &params)
@@ -223,6 +231,12 @@ namespace
         {
             const std::string &name = layer.name();
 
+            if (weightsFile)
+            {
+                weightsFile->getBlobs(name, layerParams.blobs);
+                return;
+            }
+
             int li;
             for (li = 0; li != netBinary.layer_size(); li++)
             {
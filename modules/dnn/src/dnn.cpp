@@ -40,10 +40,16 @@
 //M*/
 
 #include "precomp.hpp"
+#include "layers/elementwise_layers.hpp"
+#include "layers/op_quantize.hpp"
+#include "weights_file.hpp"
+#include "threading.hpp"
 #include <set>
+#include <deque>
 #include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <fstream>
 
 using namespace cv;
 using namespace cv::dnn;
@@ -83,13 +89,18 @@ struct LayerPin
     {
         return (lid == r.lid && oid == r.oid);
     }
+
+    bool operator<(const LayerPin &r) const
+    {
+        return (lid < r.lid || (lid == r.lid && oid < r.oid));
+    }
 };
 
 struct LayerData
 {
-    LayerData() {}
+    LayerData() : skip(false) {}
     LayerData(int _id, const String &_name, const String &_type, LayerParams &_params)
-        : id(_id), name(_name), type(_type), params(_params)
+        : id(_id), name(_name), type(_type), params(_params), skip(false)
     {
         //add logging info
         params.name = name;
@@ -104,12 +115,14 @@ struct LayerData
     std::vector<LayerPin> inputBlobsId;
     std::set<int> inputLayersId;
     std::set<int> requiredOutputs;
+    std::set<int> memoryDepsId; //layers which must be computed before the layer overwrites shared memory
 
     Ptr<Layer> layerInstance;
     std::vector<Blob> outputBlobs;
     std::vector<Blob*> inputBlobs;
 
     int flag;
+    bool skip; //layer is fused into its parent and passes the parent's output through
 
     Ptr<Layer> getLayerInstance()
     {
@@ -126,6 +139,138 @@ struct LayerData
     }
 };
 
+//shares memory between output blobs whose lifetimes don't intersect
+struct BlobManager
+{
+    struct Chunk
+    {
+        Mat mem;
+        int refs;    //number of pending reads of the blobs placed into the chunk
+        bool locked; //the chunk contains net output, so it never will be reused
+        std::vector<int> users; //layers accessed the chunk since the last write
+
+        Chunk(size_t size) : mem(1, (int)size, CV_8U), refs(0), locked(false) {}
+
+        bool contains(const uchar *ptr) const
+        {
+            return (mem.data <= ptr && ptr < mem.data + mem.total());
+        }
+    };
+
+    std::vector<Chunk> chunks;
+    std::map<LayerPin, int> consumersNum;
+    std::map<LayerPin, int> pinToChunk;
+
+    void reset()
+    {
+        chunks.clear();
+        consumersNum.clear();
+        pinToChunk.clear();
+    }
+
+    void addConsumer(const LayerPin &pin)
+    {
+        consumersNum[pin]++;
+    }
+
+    int findChunk(const uchar *ptr) const
+    {
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            if (chunks[i].contains(ptr))
+                return (int)i;
+        }
+        return -1;
+    }
+
+    int acquireChunk(size_t size)
+    {
+        //best fit among chunks which aren't used now
+        int bestId = -1;
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            const Chunk &c = chunks[i];
+            if (c.refs == 0 && !c.locked && c.mem.total() >= size &&
+                (bestId < 0 || c.mem.total() < chunks[bestId].mem.total()))
+                bestId = (int)i;
+        }
+
+        if (bestId < 0)
+        {
+            chunks.push_back(Chunk(size));
+            bestId = (int)chunks.size() - 1;
+        }
+
+        return bestId;
+    }
+
+    //checks that the blob isn't read by anybody except the single pending consumer
+    bool isExclusive(const LayerPin &pin) const
+    {
+        std::map<LayerPin, int>::const_iterator it = pinToChunk.find(pin);
+        if (it == pinToChunk.end())
+            return false;
+
+        const Chunk &c = chunks[it->second];
+        return (!c.locked && c.refs == 1);
+    }
+
+    //moves output blobs of just allocated layer into shared chunks,
+    //fills @p deps by layers which must be computed before the layer writes into them
+    void bindOutputs(int lid, std::vector<Blob> &outputBlobs, std::set<int> &deps)
+    {
+        for (size_t i = 0; i < outputBlobs.size(); i++)
+        {
+            LayerPin pin(lid, (int)i);
+            Blob &blob = outputBlobs[i];
+            const Mat &m = blob.matRefConst();
+            if (m.empty())
+                continue;
+
+            int chunkId = findChunk(m.data);
+            if (chunkId < 0)
+            {
+                //the memory is shared with something that isn't controlled by the manager
+                if (!m.u || m.u->refcount != 1)
+                    continue;
+
+                chunkId = acquireChunk(m.total() * m.elemSize());
+
+                Blob chunkBlob;
+                chunkBlob.fill(blob.shape(), blob.type(), chunks[chunkId].mem.data, false);
+                blob = chunkBlob;
+            }
+
+            pinToChunk[pin] = chunkId;
+
+            Chunk &c = chunks[chunkId];
+            deps.insert(c.users.begin(), c.users.end());
+            c.users.assign(1, lid);
+
+            std::map<LayerPin, int>::iterator it = consumersNum.find(pin);
+            if (it == consumersNum.end() || it->second == 0)
+                c.locked = true;
+            else
+                c.refs += it->second;
+        }
+
+        deps.erase(lid);
+    }
+
+    //marks that the blob was read by yet another layer @p lid
+    void releaseReference(const LayerPin &pin, int lid)
+    {
+        std::map<LayerPin, int>::iterator it = pinToChunk.find(pin);
+        if (it == pinToChunk.end())
+            return;
+
+        Chunk &c = chunks[it->second];
+        CV_Assert(c.refs > 0);
+        c.refs--;
+        c.users.push_back(lid);
+    }
+};
+
 //fake layer containing network input blobs
 struct NetInputLayer : public Layer
 {
@@ -147,6 +292,154 @@ private:
     std::vector<String> outNames;
 };
 
+//measures forward passes of the layers, exists only while profiling is enabled
+struct NetProfiler
+{
+    struct Event
+    {
+        int lid, thread;
+        int64 start, end; //in ticks
+    };
+
+    struct Stats
+    {
+        Stats() : calls(0), ticks(0) {}
+
+        int calls;
+        int64 ticks;
+    };
+
+    NetProfiler() : origin(getTickCount()) {}
+
+    void forward(LayerData &ld)
+    {
+        Event e;
+        e.lid = ld.id;
+        e.thread = getThreadNum();
+        e.start = getTickCount();
+        ld.layerInstance->forward(ld.inputBlobs, ld.outputBlobs);
+        e.end = getTickCount();
+
+        AutoLock lock(mutex);
+        Stats &s = stats[ld.id];
+        s.calls++;
+        s.ticks += e.end - e.start;
+        if (events.size() < maxEvents)
+            events.push_back(e);
+    }
+
+    static const size_t maxEvents = 1 << 20; //the trace of long runs is truncated
+
+    int64 origin;
+    std::map<int, Stats> stats;
+    std::vector<Event> events;
+    Mutex mutex;
+};
+
+//the only branch profiling costs when it is disabled
+static inline void forwardLayerData(LayerData &ld, NetProfiler *profiler)
+{
+    if (profiler)
+        profiler->forward(ld);
+    else
+        ld.layerInstance->forward(ld.inputBlobs, ld.outputBlobs);
+}
+
+//state of the concurrent forward pass: layers become ready when all their dependencies were computed
+struct ReadyQueue
+{
+    ReadyQueue(const std::vector<std::vector<int> > &_children, const std::vector<int> &depsNum)
+        : children(_children), pending(depsNum), computed(0), failed(false)
+    {
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            if (pending[i] == 0)
+                ready.push_back((int)i);
+        }
+    }
+
+    const std::vector<std::vector<int> > &children;
+    std::vector<int> pending;   //number of not computed dependencies of each scheduled layer
+    std::deque<int> ready;
+    size_t computed;
+    bool failed;
+    cv::Exception error;
+    Monitor monitor;
+};
+
+//each worker takes ready layers from the queue until all layers are computed
+class ParallelForwardBody : public ParallelLoopBody
+{
+public:
+    ParallelForwardBody(const std::vector<LayerData*> &_schedule, ReadyQueue &_queue, NetProfiler *_profiler)
+        : schedule(_schedule), queue(_queue), profiler(_profiler) {}
+
+    void operator()(const Range &) const
+    {
+        queue.monitor.lock();
+        for (;;)
+        {
+            //some layer is being computed by another worker if nothing is ready
+            while (queue.ready.empty() && queue.computed < schedule.size() && !queue.failed)
+                queue.monitor.wait();
+
+            if (queue.ready.empty() || queue.failed)
+                break;
+
+            int pos = queue.ready.front();
+            queue.ready.pop_front();
+            queue.monitor.unlock();
+
+            bool failed = false;
+            cv::Exception error;
+            try
+            {
+                forwardLayerData(*schedule[pos], profiler);
+            }
+            catch (const cv::Exception &e)
+            {
+                failed = true;
+                error = e;
+            }
+            catch (const std::exception &e)
+            {
+                failed = true;
+                error = cv::Exception(Error::StsError, e.what(), CV_Func, __FILE__, __LINE__);
+            }
+            catch (...)
+            {
+                failed = true;
+                error = cv::Exception(Error::StsError, "Unknown exception in layer \"" + schedule[pos]->name + "\"",
+                                      CV_Func, __FILE__, __LINE__);
+            }
+
+            queue.monitor.lock();
+            if (failed && !queue.failed)
+            {
+                queue.failed = true;
+                queue.error = error;
+            }
+
+            queue.computed++;
+            const std::vector<int> &children = queue.children[pos];
+            for (size_t i = 0; i < children.size(); i++)
+            {
+                if (--queue.pending[children[i]] == 0)
+                    queue.ready.push_back(children[i]);
+            }
+            queue.monitor.notifyAll();
+        }
+        queue.monitor.unlock();
+    }
+
+private:
+    const std::vector<LayerData*> &schedule;
+    ReadyQueue &queue;
+    NetProfiler *profiler;
+
+    ParallelForwardBody& operator=(const ParallelForwardBody&);
+};
+
 struct Net::Impl
 {
     Impl()
@@ -161,6 +454,11 @@ struct Net::Impl
 
         lastLayerId = 1;
         netWasAllocated = false;
+        reuseBlobs = false;
+        inPlaceLayers = true;
+        maxConcurrentLayers = 1;
+        fusion = true;
+        profiling = false;
     }
 
     Ptr<NetInputLayer> netInputLayer;
@@ -174,10 +472,30 @@ struct Net::Impl
 
     bool netWasAllocated;
 
+    bool reuseBlobs, inPlaceLayers;
+    BlobManager blobManager;
+
+    std::vector<LayerData*> schedule;                   //allocated layers in order of computation
+    std::vector<std::vector<int> > scheduleParents;     //positions of parents of each scheduled layer
+    std::map<int, int> schedulePos;                     //position of the layer in the schedule
+    std::map<int, std::vector<int> > partialSchedules;  //cached slices of the schedule for forward(toLayer)
+    std::vector<std::vector<int> > scheduleChildren;    //positions of the layers waiting for each scheduled layer
+    std::vector<int> scheduleDepsNum;                   //number of layers each scheduled layer waits for
+    int maxConcurrentLayers;
+    bool fusion;
+    bool profiling;
+    Ptr<NetProfiler> profiler; //keeps statistics after profiling is disabled
+
+    NetProfiler *activeProfiler()
+    {
+        return (profiling) ? profiler.get() : NULL;
+    }
+
     void setUpNet()
     {
         if (!netWasAllocated)
         {
+            fuseLayers();
             allocateLayers();
             computeNetOutputLayers();
 
@@ -333,6 +651,54 @@ struct Net::Impl
             std::cout << layers[netOutputs[i]].name << std::endl;
     }
 
+    //merges element-wise layers into the preceding convolution and fully connected layers
+    void fuseLayers()
+    {
+        MapIdToLayerData::iterator it;
+        for (it = layers.begin(); it != layers.end(); it++)
+        {
+            LayerData &ld = it->second;
+            ld.skip = false;
+
+            Ptr<ActivationFusable> fusable = ld.getLayerInstance().dynamicCast<ActivationFusable>();
+            if (!fusable.empty())
+                fusable->setActivation(Ptr<ElementWiseLayerBase>());
+        }
+
+        if (!fusion)
+            return;
+
+        std::map<LayerPin, std::vector<int> > consumers;
+        for (it = layers.begin(); it != layers.end(); it++)
+        {
+            std::vector<LayerPin> &inputBlobsId = it->second.inputBlobsId;
+            for (size_t i = 0; i < inputBlobsId.size(); i++)
+                consumers[inputBlobsId[i]].push_back(it->first);
+        }
+
+        for (it = layers.begin(); it != layers.end(); it++)
+        {
+            int lid = it->first;
+            LayerData &ld = it->second;
+            if (lid == 0 || ld.skip || ld.inputBlobsId.size() != 1 ||
+                ld.requiredOutputs.size() != 1 || *ld.requiredOutputs.begin() != 0)
+                continue;
+
+            Ptr<ActivationFusable> fusable = ld.getLayerInstance().dynamicCast<ActivationFusable>();
+            std::vector<int> &outConsumers = consumers[LayerPin(lid, 0)];
+            if (fusable.empty() || outConsumers.size() != 1)
+                continue;
+
+            LayerData &activLd = layers[outConsumers[0]];
+            Ptr<ElementWiseLayerBase> activ = activLd.getLayerInstance().dynamicCast<ElementWiseLayerBase>();
+            if (activ.empty() || activLd.inputBlobsId.size() != 1)
+                continue;
+
+            if (fusable->setActivation(activ))
+                activLd.skip = true;
+        }
+    }
+
     void allocateLayer(int lid)
     {
         LayerData &ld = layers[lid];
@@ -361,57 +727,177 @@ struct Net::Impl
 
         //allocate layer
         ld.outputBlobs.resize(std::max((size_t)1, ld.requiredOutputs.size())); //layer produce at least one output blob
-        ld.getLayerInstance()->allocate(ld.inputBlobs, ld.outputBlobs);
+
+        if (!ld.getLayerInstance().dynamicCast<ElementWiseLayerBase>().empty())
+        {
+            //element-wise layers work in-place unless the net requests a separate output
+            ld.outputBlobs.resize(std::max(ld.outputBlobs.size(), ld.inputBlobs.size()));
+            for (size_t i = 0; i < ld.inputBlobs.size(); i++)
+            {
+                ld.outputBlobs[i] = Blob();
+                if (!canOverwriteInput(ld.inputBlobsId[i]))
+                    ld.outputBlobs[i].create(ld.inputBlobs[i]->shape(), ld.inputBlobs[i]->type());
+            }
+        }
+
+        if (ld.skip)
+            ld.outputBlobs[0].shareFrom(*ld.inputBlobs[0]);
+        else
+            ld.getLayerInstance()->allocate(ld.inputBlobs, ld.outputBlobs);
+
+        if (reuseBlobs && lid != 0)
+        {
+            blobManager.bindOutputs(lid, ld.outputBlobs, ld.memoryDepsId);
+            for (size_t i = 0; i < ld.inputBlobsId.size(); i++)
+                blobManager.releaseReference(ld.inputBlobsId[i], lid);
+        }
+
+        //parents were allocated earlier, so the schedule is topologically sorted
+        if (ld.skip)
+        {
+            //the fused parent computes the output instead
+            schedulePos[lid] = schedulePos[ld.inputBlobsId[0].lid];
+        }
+        else if (lid != 0)
+        {
+            schedulePos[lid] = (int)schedule.size();
+            schedule.push_back(&ld);
+        }
 
         ld.flag = 1;
     }
 
+    //checks that the blob may be overwritten by its single consumer
+    bool canOverwriteInput(const LayerPin &pin)
+    {
+        if (!inPlaceLayers)
+            return false;
+        if (reuseBlobs)
+            return blobManager.isExclusive(pin);
+
+        //without the manager the blob mustn't be read by other layers or aliased by other blobs
+        const Mat &m = layers[pin.lid].outputBlobs[pin.oid].matRefConst();
+        return blobManager.consumersNum[pin] == 1 && m.u && m.u->refcount == 1;
+    }
+
     void allocateLayers()
     {
         MapIdToLayerData::iterator it;
+
+        //drop headers pointing to the previously used chunks
+        std::map<LayerPin, int>::iterator pit;
+        for (pit = blobManager.pinToChunk.begin(); pit != blobManager.pinToChunk.end(); pit++)
+            layers[pit->first.lid].outputBlobs[pit->first.oid] = Blob();
+        blobManager.reset();
+
         for (it = layers.begin(); it != layers.end(); it++)
+        {
             it->second.flag = 0;
+            it->second.memoryDepsId.clear();
+
+            std::vector<LayerPin> &inputBlobsId = it->second.inputBlobsId;
+            for (size_t i = 0; i < inputBlobsId.size(); i++)
+                blobManager.addConsumer(inputBlobsId[i]);
+        }
+
+        schedule.clear();
+        schedulePos.clear();
 
         for (it = layers.begin(); it != layers.end(); it++)
         {
             int lid = it->first;
             allocateLayer(lid);
         }
+
+        scheduleParents.assign(schedule.size(), std::vector<int>());
+        for (size_t i = 0; i < schedule.size(); i++)
+        {
+            std::set<int> &parents = schedule[i]->inputLayersId;
+            for (set<int>::iterator j = parents.begin(); j != parents.end(); j++)
+            {
+                std::map<int, int>::iterator pos = schedulePos.find(*j);
+                if (pos != schedulePos.end())
+                    scheduleParents[i].push_back(pos->second);
+            }
+        }
+        partialSchedules.clear();
+
+        //a layer waits for its parents and for the layers which must read a memory chunk before the layer overwrites it
+        scheduleChildren.assign(schedule.size(), std::vector<int>());
+        scheduleDepsNum.assign(schedule.size(), 0);
+        for (size_t i = 0; i < schedule.size(); i++)
+        {
+            std::set<int> deps(scheduleParents[i].begin(), scheduleParents[i].end());
+
+            std::set<int> &memoryDeps = schedule[i]->memoryDepsId;
+            for (set<int>::iterator j = memoryDeps.begin(); j != memoryDeps.end(); j++)
+            {
+                std::map<int, int>::iterator pos = schedulePos.find(*j);
+                if (pos != schedulePos.end() && pos->second != (int)i)
+                    deps.insert(pos->second);
+            }
+
+            for (set<int>::iterator j = deps.begin(); j != deps.end(); j++)
+                scheduleChildren[*j].push_back((int)i);
+            scheduleDepsNum[i] = (int)deps.size();
+        }
     }
 
-    void forwardLayer(LayerData &ld, bool clearFlags = true)
+    //returns positions of the scheduled layers which are required to compute the layer @p lid
+    const std::vector<int> &getPartialSchedule(int lid)
     {
-        if (clearFlags)
+        std::map<int, std::vector<int> >::iterator it = partialSchedules.find(lid);
+        if (it != partialSchedules.end())
+            return it->second;
+
+        std::vector<int> &positions = partialSchedules[lid];
+        std::map<int, int>::iterator pos = schedulePos.find(lid);
+        if (pos == schedulePos.end())
+            return positions;
+
+        std::vector<uchar> required(pos->second + 1, 0);
+        required[pos->second] = 1;
+        for (int i = pos->second; i >= 0; i--)
         {
-            MapIdToLayerData::iterator it;
-            for (it = layers.begin(); it != layers.end(); it++)
-                it->second.flag = 0;
-        }
+            if (!required[i])
+                continue;
 
-        //already was forwarded
-        if (ld.flag)
-            return;
+            for (size_t j = 0; j < scheduleParents[i].size(); j++)
+                required[scheduleParents[i][j]] = 1;
+        }
 
-        //forward parents
-        for (set<int>::iterator i = ld.inputLayersId.begin(); i != ld.inputLayersId.end(); i++)
+        for (int i = 0; i <= pos->second; i++)
         {
-            forwardLayer(layers[*i], false);
+            if (required[i])
+                positions.push_back(i);
         }
+        return positions;
+    }
 
-        //forward itself
-        ld.layerInstance->forward(ld.inputBlobs, ld.outputBlobs);
+    void forwardLayer(LayerData &ld)
+    {
+        const std::vector<int> &positions = getPartialSchedule(ld.id);
 
-        ld.flag = 1;
+        for (size_t i = 0; i < positions.size(); i++)
+            forwardLayerData(*schedule[positions[i]], activeProfiler());
     }
 
     void forwardAll()
     {
-        MapIdToLayerData::iterator it;
-        for (it = layers.begin(); it != layers.end(); it++)
-            it->second.flag = 0;
+        if (maxConcurrentLayers <= 1)
+        {
+            for (size_t i = 0; i < schedule.size(); i++)
+                forwardLayerData(*schedule[i], activeProfiler());
+            return;
+        }
 
-        for (it = layers.begin(); it != layers.end(); it++)
-            forwardLayer(it->second, false);
+        ReadyQueue queue(scheduleChildren, scheduleDepsNum);
+        ParallelForwardBody body(schedule, queue, activeProfiler());
+        int workers = std::min((int)schedule.size(), maxConcurrentLayers);
+        parallel_for_(Range(0, workers), body, workers);
+
+        if (queue.failed)
+            throw queue.error;
     }
 };
 
@@ -425,6 +911,45 @@ Net::~Net()
 
 }
 
+Net Net::clone()
+{
+    Net dst;
+    Impl &dimpl = *dst.impl;
+
+    *dimpl.netInputLayer = *impl->netInputLayer;
+    dimpl.netOutputs = impl->netOutputs;
+    dimpl.layerNameToId = impl->layerNameToId;
+    dimpl.lastLayerId = impl->lastLayerId;
+    dimpl.reuseBlobs = impl->reuseBlobs;
+    dimpl.inPlaceLayers = impl->inPlaceLayers;
+    dimpl.maxConcurrentLayers = impl->maxConcurrentLayers;
+    dimpl.fusion = impl->fusion;
+
+    Impl::MapIdToLayerData::iterator it;
+    for (it = impl->layers.begin(); it != impl->layers.end(); it++)
+    {
+        if (it->first == 0)
+            continue;
+
+        const LayerData &src = it->second;
+        LayerData &ld = dimpl.layers.insert(std::make_pair(it->first, LayerData())).first->second;
+        ld.id = src.id;
+        ld.name = src.name;
+        ld.type = src.type;
+        ld.params = src.params;
+        ld.inputBlobsId = src.inputBlobsId;
+        ld.inputLayersId = src.inputLayersId;
+        ld.requiredOutputs = src.requiredOutputs;
+
+        //Blob copies share data, so the new layer instance will be created over the same weights
+        if (src.layerInstance)
+            ld.params.blobs = src.layerInstance->blobs;
+    }
+
+    dimpl.layers[0].requiredOutputs = impl->layers[0].requiredOutputs;
+    return dst;
+}
+
 int Net::addLayer(const String &name, const String &type, LayerParams &params)
 {
     if (name.find('.') != String::npos)
@@ -481,6 +1006,183 @@ void Net::forward(LayerId toLayer)
     impl->forwardLayer(impl->getLayerData(toLayer));
 }
 
+void Net::setMemoryReuse(bool reuseBlobs, bool inPlaceLayers)
+{
+    impl->reuseBlobs = reuseBlobs;
+    impl->inPlaceLayers = inPlaceLayers;
+    impl->netWasAllocated = false;
+}
+
+void Net::setMaxConcurrentLayers(int maxLayers)
+{
+    CV_Assert(maxLayers > 0);
+    impl->maxConcurrentLayers = maxLayers;
+}
+
+void Net::setLayersFusion(bool fusion)
+{
+    impl->fusion = fusion;
+    impl->netWasAllocated = false;
+}
+
+void Net::writeWeights(const String &path)
+{
+    std::map<String, std::vector<Blob> > layersBlobs;
+
+    Impl::MapIdToLayerData::iterator it;
+    for (it = impl->layers.begin(); it != impl->layers.end(); it++)
+    {
+        LayerData &ld = it->second;
+        if (it->first != 0 && !ld.params.blobs.empty())
+            layersBlobs[ld.name] = ld.params.blobs;
+    }
+
+    WeightsFile::write(path, layersBlobs);
+}
+
+void Net::readWeights(const String &path)
+{
+    Ptr<WeightsFile> file = WeightsFile::open(path);
+
+    Impl::MapIdToLayerData::iterator it;
+    for (it = impl->layers.begin(); it != impl->layers.end(); it++)
+    {
+        LayerData &ld = it->second;
+        if (it->first == 0 || !file->getBlobs(ld.name, ld.params.blobs))
+            continue;
+
+        if (ld.layerInstance)
+            ld.layerInstance->blobs = ld.params.blobs;
+    }
+    impl->netWasAllocated = false;
+}
+
+void Net::setCalibration(bool enable)
+{
+    Impl::MapIdToLayerData::iterator it;
+    for (it = impl->layers.begin(); it != impl->layers.end(); it++)
+    {
+        Ptr<Quantizable> layer = it->second.getLayerInstance().dynamicCast<Quantizable>();
+        if (!layer.empty())
+            layer->setCalibration(enable);
+    }
+}
+
+void Net::setQuantization(bool enable)
+{
+    Impl::MapIdToLayerData::iterator it;
+    for (it = impl->layers.begin(); it != impl->layers.end(); it++)
+    {
+        Ptr<Quantizable> layer = it->second.getLayerInstance().dynamicCast<Quantizable>();
+        if (!layer.empty())
+            layer->setQuantization(enable);
+    }
+    impl->netWasAllocated = false;
+}
+
+void Net::setProfiling(bool enable)
+{
+    if (enable)
+        impl->profiler = Ptr<NetProfiler>(new NetProfiler());
+    impl->profiling = enable;
+}
+
+void Net::getProfile(std::vector<LayerProfile> &profile)
+{
+    profile.clear();
+
+    Impl::MapIdToLayerData::iterator it;
+    for (it = impl->layers.begin(); it != impl->layers.end(); it++)
+    {
+        LayerData &ld = it->second;
+        if (ld.id == 0)
+            continue;
+
+        LayerProfile p;
+        p.id = ld.id;
+        p.name = ld.name;
+        p.type = ld.type;
+        p.calls = 0;
+        p.time = 0;
+        p.flops = 0;
+        p.outputBytes = 0;
+
+        if (impl->profiler)
+        {
+            std::map<int, NetProfiler::Stats>::iterator s = impl->profiler->stats.find(ld.id);
+            if (s != impl->profiler->stats.end())
+            {
+                p.calls = s->second.calls;
+                p.time = s->second.ticks * 1000. / getTickFrequency();
+            }
+        }
+
+        //fused layers neither compute nor allocate anything
+        if (impl->netWasAllocated && !ld.skip && ld.layerInstance)
+        {
+            p.flops = ld.layerInstance->getFLOPS(ld.inputBlobs, ld.outputBlobs);
+            for (size_t i = 0; i < ld.outputBlobs.size(); i++)
+            {
+                const Mat &m = ld.outputBlobs[i].matRefConst();
+                p.outputBytes += m.total() * m.elemSize();
+            }
+        }
+
+        profile.push_back(p);
+    }
+}
+
+static String escapeJson(const String &str)
+{
+    std::ostringstream ss;
+    for (size_t i = 0; i < str.size(); i++)
+    {
+        char c = str[i];
+        if (c == '"' || c == '\\')
+            ss << '\\' << c;
+        else if ((unsigned char)c < 0x20)
+            ss << ' ';
+        else
+            ss << c;
+    }
+    return ss.str();
+}
+
+void Net::writeProfileTrace(const String &path)
+{
+    std::ofstream file(path.c_str());
+    if (!file.is_open())
+        CV_Error(Error::StsError, "Can't open file \"" + path + "\" for writing");
+
+    file.setf(std::ios::fixed);
+    file.precision(3);
+    file << "{\"traceEvents\":[";
+
+    if (impl->profiler)
+    {
+        const NetProfiler &profiler = *impl->profiler;
+        double usPerTick = 1e6 / getTickFrequency();
+        std::map<int, int64> flops;
+
+        for (size_t i = 0; i < profiler.events.size(); i++)
+        {
+            const NetProfiler::Event &e = profiler.events[i];
+            LayerData &ld = impl->layers[e.lid];
+            if (flops.find(e.lid) == flops.end())
+                flops[e.lid] = ld.layerInstance->getFLOPS(ld.inputBlobs, ld.outputBlobs);
+
+            file << ((i == 0) ? "\n" : ",\n")
+                 << "{\"name\":\"" << escapeJson(ld.name) << "\",\"cat\":\"" << escapeJson(ld.type) << "\","
+                 << "\"ph\":\"X\",\"pid\":0,\"tid\":" << e.thread << ","
+                 << "\"ts\":" << (e.start - profiler.origin) * usPerTick << ","
+                 << "\"dur\":" << (e.end - e.start) * usPerTick << ","
+                 << "\"args\":{\"flops\":" << flops[e.lid] << "}}";
+        }
+    }
+
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
 void Net::setNetInputs(const std::vector<String> &inputBlobNames)
 {
     impl->netInputLayer->setNames(inputBlobNames);
@@ -494,7 +1196,13 @@ void Net::setBlob(String outputName, const Blob &blob)
 
     LayerData &ld = impl->layers[pin.lid];
     ld.outputBlobs.resize( std::max(pin.oid+1, (int)ld.requiredOutputs.size()) );
-    ld.outputBlobs[pin.oid] = blob;
+
+    //layers must be reallocated for inputs of the new shape
+    Blob &prev = ld.outputBlobs[pin.oid];
+    if (pin.lid == 0 && !prev.matRefConst().empty() && (!prev.equalShape(blob) || prev.type() != blob.type()))
+        impl->netWasAllocated = false;
+
+    prev = blob;
 }
 
 Blob Net::getBlob(String outputName)
@@ -553,6 +1261,11 @@ int Layer::outputNameToIndex(String)
     return -1;
 }
 
+int64 Layer::getFLOPS(const std::vector<Blob*>&, const std::vector<Blob>&) const
+{
+    return 0;
+}
+
 Layer::~Layer() {}
 
 //////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,262 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "precomp.hpp"
+#include "threading.hpp"
+#include <deque>
+#include <cstring>
+
+namespace cv
+{
+namespace dnn
+{
+
+struct InferenceRequest
+{
+    InferenceRequest(const Blob &_input, int64 _deadline)
+        : input(_input), deadline(_deadline), done(false), failed(false) {}
+
+    const Blob &input;
+    Blob output;
+    int64 deadline; //in ticks
+    bool done, failed;
+    cv::Exception error;
+
+    //requests can be stacked into one batch if only their first dimensions differ
+    bool isCompatible(const InferenceRequest &r) const
+    {
+        const Blob &other = r.input;
+        if (input.dims() != other.dims() || input.type() != other.type())
+            return false;
+        for (int i = 1; i < input.dims(); i++)
+        {
+            if (input.size(i) != other.size(i))
+                return false;
+        }
+        return true;
+    }
+};
+
+//network copy with the input buffer it was allocated for
+struct InferenceWorker
+{
+    Net net;
+    Blob input;
+};
+
+struct InferenceQueue::Impl
+{
+    String inputName, outputName;
+    int maxBatchSize;
+    int64 maxDelayTicks;
+
+    Monitor monitor;
+    std::deque<InferenceRequest*> queue;
+    std::vector<InferenceWorker> freeWorkers;
+
+    //returns number of requests at the front of the queue which can be stacked together
+    int getBatchSize(int &numSamples) const
+    {
+        int count = 0;
+        numSamples = 0;
+        for (size_t i = 0; i < queue.size(); i++)
+        {
+            int num = queue[i]->input.size(0);
+            if (count > 0 && (numSamples + num > maxBatchSize || !queue[0]->isCompatible(*queue[i])))
+                break;
+            numSamples += num;
+            count++;
+        }
+        return count;
+    }
+
+    //batches are padded to maxBatchSize samples, so the worker keeps the input shape its layers were allocated for
+    //and doesn't reallocate them whenever the number of queued samples changes
+    void forwardBatch(InferenceWorker &worker, const std::vector<InferenceRequest*> &batch)
+    {
+        int numSamples = 0;
+        for (size_t i = 0; i < batch.size(); i++)
+            numSamples += batch[i]->input.size(0);
+        int paddedSamples = std::max(numSamples, maxBatchSize);
+
+        Blob input;
+        if (batch.size() == 1 && numSamples == paddedSamples)
+        {
+            input = batch[0]->input;
+        }
+        else
+        {
+            BlobShape shape = batch[0]->input.shape();
+            shape[0] = paddedSamples;
+            worker.input.create(shape, batch[0]->input.type());
+            input = worker.input;
+
+            uchar *dst = input.ptr();
+            for (size_t i = 0; i < batch.size(); i++)
+            {
+                const Mat &src = batch[i]->input.matRefConst();
+                CV_Assert(src.isContinuous());
+                size_t size = src.total() * src.elemSize();
+                std::memcpy(dst, src.data, size);
+                dst += size;
+            }
+            std::memset(dst, 0, input.ptr() + input.total() * input.elemSize() - dst);
+        }
+
+        Net &net = worker.net;
+        net.setBlob(inputName, input);
+        net.forward();
+        Blob output = net.getBlob(outputName);
+        CV_Assert(output.dims() > 0 && output.size(0) == input.size(0));
+
+        BlobShape shape = output.shape();
+        for (size_t i = 0, n = 0; i < batch.size(); i++)
+        {
+            //outputs are copied because the worker overwrites them by the next batch
+            shape[0] = batch[i]->input.size(0);
+            batch[i]->output.fill(shape, output.type(), output.ptr((int)n), true);
+            n += shape[0];
+        }
+    }
+
+    //called under the lock, unlocks it during the computations
+    void runBatch()
+    {
+        int numSamples;
+        int count = getBatchSize(numSamples);
+        std::vector<InferenceRequest*> batch(queue.begin(), queue.begin() + count);
+        queue.erase(queue.begin(), queue.begin() + count);
+
+        InferenceWorker worker = freeWorkers.back();
+        freeWorkers.pop_back();
+        monitor.unlock();
+
+        bool failed = false;
+        cv::Exception error;
+        try
+        {
+            forwardBatch(worker, batch);
+        }
+        catch (const cv::Exception &e)
+        {
+            failed = true;
+            error = e;
+        }
+        catch (const std::exception &e)
+        {
+            failed = true;
+            error = cv::Exception(Error::StsError, e.what(), CV_Func, __FILE__, __LINE__);
+        }
+        catch (...)
+        {
+            //the worker must return to the pool and the waiters must be woken up whatever was thrown
+            failed = true;
+            error = cv::Exception(Error::StsError, "Unknown exception in the forward pass", CV_Func, __FILE__, __LINE__);
+        }
+
+        monitor.lock();
+        freeWorkers.push_back(worker);
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            batch[i]->done = true;
+            batch[i]->failed = failed;
+            if (failed)
+                batch[i]->error = error;
+        }
+        monitor.notifyAll();
+    }
+
+    Blob process(const Blob &input)
+    {
+        CV_Assert(input.dims() > 0 && input.size(0) > 0);
+        InferenceRequest request(input, getTickCount() + maxDelayTicks);
+
+        monitor.lock();
+        queue.push_back(&request);
+        monitor.notifyAll(); //the batch could become full
+
+        while (!request.done)
+        {
+            if (freeWorkers.empty() || queue.empty())
+            {
+                monitor.wait();
+                continue;
+            }
+
+            int numSamples;
+            getBatchSize(numSamples);
+            int64 delay = queue.front()->deadline - getTickCount();
+            if (numSamples >= maxBatchSize || delay <= 0)
+                runBatch();
+            else
+                monitor.wait(delay * 1000. / getTickFrequency());
+        }
+        monitor.unlock();
+
+        if (request.failed)
+            throw request.error;
+        return request.output;
+    }
+};
+
+InferenceQueue::InferenceQueue(Net net, const String &inputName, const String &outputName,
+                               int numWorkers, int maxBatchSize, double maxDelay)
+    : impl(new Impl)
+{
+    CV_Assert(numWorkers > 0 && maxBatchSize > 0 && maxDelay >= 0);
+
+    impl->inputName = inputName;
+    impl->outputName = outputName;
+    impl->maxBatchSize = maxBatchSize;
+    impl->maxDelayTicks = (int64)(maxDelay * 1e-3 * getTickFrequency());
+
+    impl->freeWorkers.resize(numWorkers);
+    for (int i = 0; i < numWorkers; i++)
+        impl->freeWorkers[i].net = net.clone();
+}
+
+Blob InferenceQueue::process(const Blob &input)
+{
+    return impl->process(input);
+}
+
+}
+}
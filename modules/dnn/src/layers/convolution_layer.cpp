@@ -45,6 +45,8 @@
 #include "convolution_layer.hpp"
 #include "op_im2col.hpp"
 #include "op_blas.hpp"
+#include "op_winograd.hpp"
+#include "op_direct_conv.hpp"
 #include <iostream>
 
 namespace cv
@@ -53,6 +55,9 @@ namespace dnn
 {
     ConvolutionLayer::ConvolutionLayer(LayerParams &params) : Layer(params)
     {
+        calibrating = quantized = false;
+        inputRange = 0;
+
         getKernelParams(params, kerH, kerW, padH, padW, strideH, strideW);
 
         numOutput = params.get<int>("num_output");
@@ -75,6 +80,18 @@ namespace dnn
         //TBD
         useOpenCL = params.has("use_opencl");
 
+        String algo = params.get<String>("conv_algorithm", "auto").toLowerCase();
+        if (algo == "auto")
+            algoRequested = ALGO_AUTO;
+        else if (algo == "im2col")
+            algoRequested = ALGO_IM2COL;
+        else if (algo == "winograd")
+            algoRequested = ALGO_WINOGRAD;
+        else if (algo == "direct")
+            algoRequested = ALGO_DIRECT;
+        else
+            CV_Error(Error::StsBadArg, "Unknown convolution algorithm \"" + algo + "\"");
+
         #if HAVE_CBLAS
         {
             if (getBlasThreads() != cv::getThreadNum())
@@ -110,11 +127,177 @@ namespace dnn
             outputs[i].create(BlobShape(inputs[i]->num(), topCn, topH, topW));
         }
 
-        if (!is1x1())
-            colMat.create(ksize, outH * outW, inpBlob.type());
+        algorithm = (quantized) ? ALGO_IM2COL : selectAlgorithm(inpBlob.type());
 
-        if (bias)
-            biasOnesMat = Mat::ones(1, topH * topW, inpBlob.type());
+        //weights are quantized here, so weights replaced by Net::readWeights() are quantized again
+        if (quantized)
+        {
+            Mat wgtMat(blobs[0].num(), (int)blobs[0].total(1), CV_32F, blobs[0].ptrf());
+            quantizeRows(wgtMat, wgtInt8, wgtScales);
+        }
+
+        if (algorithm == ALGO_WINOGRAD)
+        {
+            tilesH = (outH + 1) / 2;
+            tilesW = (outW + 1) / 2;
+
+            winogradWgt.create(group * WINOGRAD_TILE_AREA, outGroupCn * inpGroupCn, CV_32F);
+            for (int g = 0; g < group; g++)
+                winogradTransformKernels(blobs[0].ptrf(g*outGroupCn), outGroupCn, inpGroupCn, winogradWgt.ptr<float>(g*WINOGRAD_TILE_AREA));
+        }
+
+        int maxNum = 0;
+        for (size_t i = 0; i < inputs.size(); i++)
+            maxNum = std::max(maxNum, inputs[i]->num());
+
+        workspaces.resize(getNumStripes(maxNum * group));
+        for (size_t i = 0; i < workspaces.size(); i++)
+        {
+            Workspace &ws = workspaces[i];
+
+            if (algorithm == ALGO_IM2COL && !is1x1())
+                ws.colMat.create(ksize, outH * outW, inpBlob.type());
+
+            if (algorithm == ALGO_WINOGRAD)
+            {
+                ws.winogradInp.create(WINOGRAD_TILE_AREA, inpGroupCn * tilesH * tilesW, CV_32F);
+                ws.winogradOut.create(WINOGRAD_TILE_AREA, outGroupCn * tilesH * tilesW, CV_32F);
+            }
+        }
+    }
+
+    //chooses between parallel processing of (image, group) tiles and multithreading inside BLAS
+    int ConvolutionLayer::getNumStripes(int tiles) const
+    {
+        int threads = getNumThreads();
+        if (tiles < 2 || threads <= 1 || useOpenCL)
+            return 1;
+
+        //multithreaded BLAS loads all cores by itself, so tiles running BLAS GEMMs aren't split between threads
+        //(the number of BLAS threads is a process-wide setting and isn't changed here)
+        bool usesBlas = !quantized && algorithm != ALGO_DIRECT;
+        if (usesBlas && getBlasThreads() > 1)
+            return 1;
+
+        return std::min(tiles, threads);
+    }
+
+    class ConvolutionLayer::ForwardInvoker : public ParallelLoopBody
+    {
+    public:
+        ForwardInvoker(ConvolutionLayer *layer_, Blob &inpBlob_, Blob &outBlob_, int nstripes_)
+            : layer(layer_), inpBlob(&inpBlob_), outBlob(&outBlob_), nstripes(nstripes_) {}
+
+        void operator()(const Range &range) const
+        {
+            int tiles = inpBlob->num() * layer->group;
+
+            for (int s = range.start; s < range.end; s++)
+            {
+                int begin = (int)((int64)tiles * s / nstripes);
+                int end = (int)((int64)tiles * (s + 1) / nstripes);
+
+                for (int t = begin; t < end; t++)
+                    layer->forwardTile(*inpBlob, *outBlob, t / layer->group, t % layer->group, layer->workspaces[s]);
+            }
+        }
+
+    private:
+        ConvolutionLayer *layer;
+        Blob *inpBlob, *outBlob;
+        int nstripes;
+    };
+
+    int64 ConvolutionLayer::getFLOPS(const std::vector<Blob*>&, const std::vector<Blob> &outputs) const
+    {
+        //each output element is a dot product of length (inpCn/group)*kerH*kerW
+        int64 flops = 0;
+        for (size_t i = 0; i < outputs.size(); i++)
+            flops += 2 * (int64)outputs[i].total() * blobs[0].total(1);
+        return flops;
+    }
+
+    bool ConvolutionLayer::setActivation(const Ptr<ElementWiseLayerBase> &layer)
+    {
+        activ = layer;
+        return true;
+    }
+
+    void ConvolutionLayer::setCalibration(bool calibrate)
+    {
+        calibrating = calibrate;
+        if (calibrate)
+            inputRange = 0;
+    }
+
+    bool ConvolutionLayer::setQuantization(bool quantize)
+    {
+        if (quantize && inputRange <= 0)
+            return false;
+
+        //the int8 weights are computed by allocate()
+        quantized = quantize;
+        if (!quantized)
+        {
+            wgtInt8.release();
+            wgtScales.clear();
+        }
+        return true;
+    }
+
+    //adds bias to each row and applies fused activation while the row is hot in cache
+    void ConvolutionLayer::addBiasAndActivate(Mat &dstMat, const float *biasPtr)
+    {
+        if (!biasPtr && !activ)
+            return;
+
+        CV_Assert(dstMat.type() == CV_32F && dstMat.isContinuous());
+        for (int i = 0; i < dstMat.rows; i++)
+        {
+            float *row = dstMat.ptr<float>(i);
+
+            if (biasPtr)
+            {
+                float b = biasPtr[i];
+                for (int j = 0; j < dstMat.cols; j++)
+                    row[j] += b;
+            }
+
+            if (activ)
+                activ->applyInPlace(row, dstMat.cols);
+        }
+    }
+
+    int ConvolutionLayer::selectAlgorithm(int type) const
+    {
+        if (type != CV_32F)
+            return ALGO_IM2COL;
+
+        bool winogradApplicable = (kerH == 3 && kerW == 3 && strideH == 1 && strideW == 1);
+
+        switch (algoRequested)
+        {
+        case ALGO_IM2COL:
+        case ALGO_DIRECT:
+            return algoRequested;
+        case ALGO_WINOGRAD:
+            return (winogradApplicable) ? ALGO_WINOGRAD : ALGO_IM2COL;
+        default:
+            break;
+        }
+
+        if (useOpenCL || is1x1())
+            return ALGO_IM2COL;
+
+        //the transformed tiles are worth it when GEMMs are big enough
+        if (winogradApplicable && inpGroupCn >= 16 && outGroupCn >= 16)
+            return ALGO_WINOGRAD;
+
+        //GEMM with tiny inner dimension is inefficient
+        if (inpGroupCn <= 4 && kerH <= 5 && kerW <= 5)
+            return ALGO_DIRECT;
+
+        return ALGO_IM2COL;
     }
 
     inline bool ConvolutionLayer::is1x1() const
@@ -124,36 +307,127 @@ namespace dnn
 
     void ConvolutionLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
     {
-        Blob &wgtBlob = blobs[0];
+        CV_Assert(!workspaces.empty());
+
+        if (calibrating)
+        {
+            for (size_t ii = 0; ii < inputs.size(); ii++)
+                inputRange = std::max(inputRange, norm(inputs[ii]->matRefConst(), NORM_INF));
+        }
 
         for (size_t ii = 0; ii < outputs.size(); ii++)
         {
             Blob &inpBlob = *inputs[ii];
             Blob &outBlob = outputs[ii];
 
-            for (int n = 0; n < inpBlob.num(); n++)
+            int tiles = inpBlob.num() * group;
+            int nstripes = std::min((int)workspaces.size(), getNumStripes(tiles));
+
+            if (nstripes <= 1)
             {
-                for (int g = 0; g < group; g++)
-                {
-                    im2col(inpBlob, n, g);
-
-                    Mat kerMat(outGroupCn, ksize, wgtBlob.type(), wgtBlob.ptr(g*outGroupCn));
-                    Mat dstMat(outGroupCn, outH*outW, outBlob.type(), outBlob.ptr(n, g*outGroupCn));
-
-                    gemmCPU(kerMat, colMat, 1, dstMat, 0);
-                    
-                    if (bias)
-                    {
-                        float *biasPtr = blobs[1].ptrf() + g*outGroupCn;
-                        Mat biasMat(outGroupCn, 1, CV_32F, biasPtr);
-                        gemmCPU(biasMat, biasOnesMat, 1, dstMat, 1); //TODO: gemv
-                    }
-                }
+                for (int t = 0; t < tiles; t++)
+                    forwardTile(inpBlob, outBlob, t / group, t % group, workspaces[0]);
+                continue;
             }
+
+            parallel_for_(Range(0, nstripes), ForwardInvoker(this, inpBlob, outBlob, nstripes), nstripes);
+        }
+    }
+
+    void ConvolutionLayer::forwardTile(Blob &inpBlob, Blob &outBlob, int n, int g, Workspace &ws)
+    {
+        if (quantized)
+        {
+            forwardInt8(inpBlob, outBlob, n, g, ws);
+            return;
+        }
+
+        switch (algorithm)
+        {
+        case ALGO_WINOGRAD:
+            forwardWinograd(inpBlob, outBlob, n, g, ws);
+            break;
+        case ALGO_DIRECT:
+            forwardDirect(inpBlob, outBlob, n, g);
+            break;
+        default:
+            forwardIm2Col(inpBlob, outBlob, n, g, ws);
+            break;
         }
     }
 
-    void ConvolutionLayer::im2col(Blob &inpBlob, int imNum, int cnGroup)
+    void ConvolutionLayer::forwardIm2Col(Blob &inpBlob, Blob &outBlob, int n, int g, Workspace &ws)
+    {
+        Blob &wgtBlob = blobs[0];
+        Mat &colMat = ws.colMat;
+
+        im2col(inpBlob, n, g, colMat);
+
+        Mat kerMat(outGroupCn, ksize, wgtBlob.type(), wgtBlob.ptr(g*outGroupCn));
+        Mat dstMat(outGroupCn, outH*outW, outBlob.type(), outBlob.ptr(n, g*outGroupCn));
+
+        gemmCPU(kerMat, colMat, 1, dstMat, 0);
+        addBiasAndActivate(dstMat, (bias) ? blobs[1].ptrf() + g*outGroupCn : NULL);
+    }
+
+    void ConvolutionLayer::forwardInt8(Blob &inpBlob, Blob &outBlob, int n, int g, Workspace &ws)
+    {
+        float inpScale = getQuantizationScale(inputRange);
+
+        im2col(inpBlob, n, g, ws.colMat);
+        quantize(ws.colMat, inpScale, ws.colInt8, true);
+
+        Mat wgtMat = wgtInt8.rowRange(g*outGroupCn, (g + 1)*outGroupCn);
+        gemmInt8(wgtMat, ws.colInt8, ws.dstInt32);
+
+        Mat dstMat(outGroupCn, outH*outW, CV_32F, outBlob.ptr(n, g*outGroupCn));
+        for (int i = 0; i < outGroupCn; i++)
+        {
+            Mat dstRow = dstMat.row(i);
+            ws.dstInt32.row(i).convertTo(dstRow, CV_32F, wgtScales[g*outGroupCn + i] * inpScale);
+        }
+
+        addBiasAndActivate(dstMat, (bias) ? blobs[1].ptrf() + g*outGroupCn : NULL);
+    }
+
+    void ConvolutionLayer::forwardWinograd(Blob &inpBlob, Blob &outBlob, int n, int g, Workspace &ws)
+    {
+        Mat &winogradInp = ws.winogradInp, &winogradOut = ws.winogradOut;
+        int tiles = tilesH * tilesW;
+
+        winogradTransformInput(inpBlob.ptrf(n, g*inpGroupCn), inpGroupCn, inpH, inpW, padH, padW,
+                               tilesH, tilesW, winogradInp.ptr<float>());
+
+        for (int p = 0; p < WINOGRAD_TILE_AREA; p++)
+        {
+            Mat wgtMat(outGroupCn, inpGroupCn, CV_32F, winogradWgt.ptr<float>(g*WINOGRAD_TILE_AREA + p));
+            Mat inpMat(inpGroupCn, tiles, CV_32F, winogradInp.ptr<float>(p));
+            Mat outMat(outGroupCn, tiles, CV_32F, winogradOut.ptr<float>(p));
+            gemmCPU(wgtMat, inpMat, 1, outMat, 0);
+        }
+
+        const float *biasPtr = (bias) ? blobs[1].ptrf() + g*outGroupCn : NULL;
+        winogradTransformOutput(winogradOut.ptr<float>(), outGroupCn, tilesH, tilesW, biasPtr,
+                                outH, outW, outBlob.ptrf(n, g*outGroupCn));
+
+        if (activ)
+            activ->applyInPlace(outBlob.ptrf(n, g*outGroupCn), (size_t)outGroupCn*outH*outW);
+    }
+
+    void ConvolutionLayer::forwardDirect(Blob &inpBlob, Blob &outBlob, int n, int g)
+    {
+        const float *biasPtr = (bias) ? blobs[1].ptrf() + g*outGroupCn : NULL;
+
+        directConv(inpBlob.ptrf(n, g*inpGroupCn), inpGroupCn, inpH, inpW,
+                   blobs[0].ptrf(g*outGroupCn), biasPtr, outGroupCn, kerH, kerW,
+                   padH, padW, strideH, strideW,
+                   outBlob.ptrf(n, g*outGroupCn), outH, outW);
+
+        if (activ)
+            activ->applyInPlace(outBlob.ptrf(n, g*outGroupCn), (size_t)outGroupCn*outH*outW);
+    }
+
+    void ConvolutionLayer::im2col(Blob &inpBlob, int imNum, int cnGroup, Mat &colMat)
     {
         uchar *srcPtr = inpBlob.ptr(imNum, cnGroup*inpGroupCn);
 
@@ -200,6 +474,20 @@ namespace dnn
     DeConvolutionLayer::DeConvolutionLayer(LayerParams &params)
         : ConvolutionLayer(params) {}
 
+    int64 DeConvolutionLayer::getFLOPS(const std::vector<Blob*> &inputs, const std::vector<Blob>&) const
+    {
+        //each input element is multiplied by (outCn/group)*kerH*kerW weights
+        int64 flops = 0;
+        for (size_t i = 0; i < inputs.size(); i++)
+            flops += 2 * (int64)inputs[i]->total() * blobs[0].total(1);
+        return flops;
+    }
+
+    int DeConvolutionLayer::selectAlgorithm(int) const
+    {
+        return ALGO_IM2COL;
+    }
+
     void DeConvolutionLayer::computeInpOutShape(const Blob &inpBlob)
     {
         outH = inpBlob.rows();
@@ -213,42 +501,21 @@ namespace dnn
         topH = inpH; topW = inpW; topCn = inpCn;
     }
 
-    void DeConvolutionLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
+    void DeConvolutionLayer::forwardTile(Blob &convBlob, Blob &decnBlob, int n, int g, Workspace &ws)
     {
         Blob &wghtBlob = blobs[0];
+        Mat dstMat(inpGroupCn, inpH*inpW, decnBlob.type(), decnBlob.ptr(n, g*inpGroupCn));
+        Mat colMat = (is1x1()) ? dstMat : ws.colMat;
 
-        for (size_t ii = 0; ii < outputs.size(); ii++)
-        {
-            Blob &convBlob = *inputs[ii];
-            Blob &decnBlob = outputs[ii];
+        Mat convMat(outGroupCn, outH*outW, convBlob.type(), convBlob.ptr(n, g*outGroupCn));
+        Mat wghtMat(outGroupCn, ksize, wghtBlob.type(), wghtBlob.ptr(g*outGroupCn));
+        gemmCPU(wghtMat, convMat, 1, colMat, 0, GEMM_1_T);
 
-            for (int n = 0; n < convBlob.num(); n++)
-            {
-                for (int g = 0; g < group; g++)
-                {
-                    Mat dstMat(inpGroupCn, inpH*inpW, decnBlob.type(), decnBlob.ptr(n, g*inpGroupCn));
-
-                    if (is1x1())
-                        colMat = dstMat;
-
-                    Mat convMat(outGroupCn, outH*outW, convBlob.type(), convBlob.ptr(n, g*outGroupCn));
-                    Mat wghtMat(outGroupCn, ksize, wghtBlob.type(), wghtBlob.ptr(g*outGroupCn));
-                    gemmCPU(wghtMat, convMat, 1, colMat, 0, GEMM_1_T);
-
-                    col2im(dstMat);
-
-                    if (bias)
-                    {
-                        float *biasPtr = blobs[1].ptrf() + g*inpGroupCn;
-                        Mat biasMat(inpGroupCn, 1, CV_32F, biasPtr);
-                        gemmCPU(biasMat, biasOnesMat, 1, dstMat, 1); //TODO: gemv
-                    }
-                }
-            }
-        }
+        col2im(colMat, dstMat);
+        addBiasAndActivate(dstMat, (bias) ? blobs[1].ptrf() + g*inpGroupCn : NULL);
     }
 
-    void DeConvolutionLayer::col2im(Mat &dstMat)
+    void DeConvolutionLayer::col2im(const Mat &colMat, Mat &dstMat)
     {
         if (is1x1()) return;
 
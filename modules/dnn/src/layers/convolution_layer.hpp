@@ -42,15 +42,24 @@
 #ifndef __OPENCV_DNN_LAYERS_CONVOLUTION_LAYER_HPP__
 #define __OPENCV_DNN_LAYERS_CONVOLUTION_LAYER_HPP__
 #include "../precomp.hpp"
+#include "elementwise_layers.hpp"
+#include "op_quantize.hpp"
 
 namespace cv
 {
 namespace dnn
 {
-    //TODO: simultaneously convolution and bias addition for cache optimization
-    class ConvolutionLayer : public Layer
+    class ConvolutionLayer : public Layer, public ActivationFusable, public Quantizable
     {
     protected:
+        enum
+        {
+            ALGO_AUTO,
+            ALGO_IM2COL,   //im2col + GEMM, the most general one
+            ALGO_WINOGRAD, //Winograd F(2x2, 3x3) for 3x3 kernels with unit stride
+            ALGO_DIRECT    //direct convolution for small number of input channels
+        };
+
         bool bias;
         int numOutput, group;
         int padH, padW;
@@ -63,29 +72,65 @@ namespace dnn
         int inpGroupCn, outGroupCn;
         int ksize;
 
+        //scratch buffers, each of parallel stripes of (image, group) tiles uses its own one
+        struct Workspace
+        {
+            Mat colMat;
+            Mat winogradInp, winogradOut;
+            Mat colInt8, dstInt32;
+        };
+
+        class ForwardInvoker;
+
         bool useOpenCL;
-        Mat colMat, biasOnesMat;
+        std::vector<Workspace> workspaces;
+        Ptr<ElementWiseLayerBase> activ;
+
+        int algoRequested, algorithm;
+        int tilesH, tilesW;
+        Mat winogradWgt;
+
+        bool calibrating, quantized;
+        double inputRange;
+        Mat wgtInt8;
+        std::vector<float> wgtScales;
 
         inline bool is1x1() const;
         virtual void computeInpOutShape(const Blob &inpBlob);
-        void im2col(Blob &inpBlob, int imNum, int cnGroup);
+        virtual int selectAlgorithm(int type) const;
+        int getNumStripes(int tiles) const;
+        virtual void forwardTile(Blob &inpBlob, Blob &outBlob, int imNum, int cnGroup, Workspace &ws);
+        void im2col(Blob &inpBlob, int imNum, int cnGroup, Mat &colMat);
+        void forwardIm2Col(Blob &inpBlob, Blob &outBlob, int imNum, int cnGroup, Workspace &ws);
+        void forwardWinograd(Blob &inpBlob, Blob &outBlob, int imNum, int cnGroup, Workspace &ws);
+        void forwardDirect(Blob &inpBlob, Blob &outBlob, int imNum, int cnGroup);
+        void forwardInt8(Blob &inpBlob, Blob &outBlob, int imNum, int cnGroup, Workspace &ws);
+        void addBiasAndActivate(Mat &dstMat, const float *biasPtr);
 
     public:
-        ConvolutionLayer() {}
+        ConvolutionLayer() : calibrating(false), quantized(false), inputRange(0) {}
         ConvolutionLayer(LayerParams &params);
         void allocate(const std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
         void forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
+        int64 getFLOPS(const std::vector<Blob*> &inputs, const std::vector<Blob> &outputs) const;
+        bool setActivation(const Ptr<ElementWiseLayerBase> &activ);
+        void setCalibration(bool calibrate);
+        bool setQuantization(bool quantize);
     };
 
     class DeConvolutionLayer : public ConvolutionLayer
     {
     protected:
         void computeInpOutShape(const Blob &inpBlob);
-        void col2im(Mat &dstMat);
+        int selectAlgorithm(int type) const;
+        void forwardTile(Blob &convBlob, Blob &decnBlob, int imNum, int cnGroup, Workspace &ws);
+        void col2im(const Mat &colMat, Mat &dstMat);
 
     public:
         DeConvolutionLayer(LayerParams &params);
-        void forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
+        int64 getFLOPS(const std::vector<Blob*> &inputs, const std::vector<Blob> &outputs) const;
+        void setCalibration(bool) {}
+        bool setQuantization(bool quantize) { return !quantize; }
     };
 }
 }
@@ -55,40 +55,73 @@ using std::exp;
 using std::tanh;
 using std::pow;
 
+    //! Base class of element-wise layers, allows the net to detect layers which are able to work in-place
+    class ElementWiseLayerBase : public Layer
+    {
+    public:
+        //! Applies the function to continuous array of @p size elements in-place
+        virtual void applyInPlace(float *data, size_t size) = 0;
+    };
+
+    //! Interface of layers which can apply the following element-wise layer to their outputs, while outputs are hot in cache
+    class ActivationFusable
+    {
+    public:
+        virtual ~ActivationFusable() {}
+
+        //! Sets the activation applied to the outputs, empty pointer disables fusion.
+        //! Returns false if the layer can't fuse the passed activation.
+        virtual bool setActivation(const Ptr<ElementWiseLayerBase> &activ) = 0;
+    };
+
     template<typename Func>
-    class ElementWiseLayer : public Layer
+    class ElementWiseLayer : public ElementWiseLayerBase
     {
         Func func;
+
+        template<typename TFloat>
+        void apply(const TFloat *src, TFloat *dst, size_t size)
+        {
+            for (size_t j = 0; j < size; j++)
+                dst[j] = func(src[j]);
+        }
+
     public:
 
         ElementWiseLayer(LayerParams &_params) : func(_params) {}
 
+        void applyInPlace(float *data, size_t size)
+        {
+            apply(data, data, size);
+        }
+
         void allocate(const std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
         {
             outputs.resize(inputs.size());
             for (size_t i = 0; i < inputs.size(); i++)
-                outputs[i].shareFrom(*inputs[i]); //no data copy
+            {
+                //the net preallocates a separate output if the input must be preserved
+                const Blob &out = outputs[i];
+                if (out.matRefConst().empty() || !out.equalShape(*inputs[i]) || out.type() != inputs[i]->type())
+                    outputs[i].shareFrom(*inputs[i]); //no data copy
+            }
         }
 
         void forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
         {
             for (size_t i = 0; i < inputs.size(); i++)
             {
-                CV_Assert(inputs[i]->ptr() == outputs[i].ptr() && inputs[i]->type() == outputs[i].type());
+                CV_Assert(inputs[i]->type() == outputs[i].type() && inputs[i]->total() == outputs[i].total());
 
                 size_t size = outputs[i].total();
 
                 if (outputs[i].type() == CV_32F)
                 {
-                    float *data = outputs[i].ptrf();
-                    for (size_t j = 0; j < size; j++)
-                        data[j] = func(data[j]);
+                    apply(inputs[i]->ptrf(), outputs[i].ptrf(), size);
                 }
                 else if (outputs[i].type() == CV_64F)
                 {
-                    double *data = outputs[i].ptr<double>();
-                    for (size_t j = 0; j < size; j++)
-                        data[j] = func(data[j]);
+                    apply(inputs[i]->ptr<double>(), outputs[i].ptr<double>(), size);
                 }
                 else
                 {
@@ -96,6 +129,14 @@ using std::pow;
                 }
             }
         }
+
+        int64 getFLOPS(const std::vector<Blob*>&, const std::vector<Blob> &outputs) const
+        {
+            int64 flops = 0;
+            for (size_t i = 0; i < outputs.size(); i++)
+                flops += outputs[i].total();
+            return flops;
+        }
     };
 
 
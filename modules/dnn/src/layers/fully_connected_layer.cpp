@@ -54,6 +54,9 @@ namespace dnn
         bias = params.get<bool>("bias_term", true);
         axis_ = params.get<int>("axis", 1);
 
+        calibrating = quantized = false;
+        inputRange = 0;
+
         CV_Assert(blobs.size() == (bias ? 2U : 1U));
         CV_Assert(blobs[0].dims() >= 2 && blobs[0].total() >= (size_t)numOutputs);
         CV_Assert(!bias || blobs[1].total() == (size_t)numOutputs);
@@ -69,6 +72,13 @@ namespace dnn
         CV_Assert((size_t)innerSize * (size_t)numOutputs == blobs[0].total());
         CV_Assert(blobs[0].size(-2) == numOutputs && blobs[0].size(-1) == innerSize);
 
+        //weights are quantized here, so weights replaced by Net::readWeights() are quantized again
+        if (quantized)
+        {
+            Mat weight(numOutputs, innerSize, CV_32F, blobs[0].ptrf());
+            quantizeRows(weight, wgtInt8, wgtScales);
+        }
+
         output.resize(input.size());
         for (size_t i = 0; i < input.size(); i++)
         {
@@ -100,16 +110,84 @@ namespace dnn
             Mat weight(N, K, blobs[0].type(), blobs[0].ptrf());
             Mat dstMat(M, N, output[i].type(), output[i].ptrf());
 
-            //important: for perfomance purposes Caffe stores weights as transposed array
-            gemmCPU(srcMat, weight, 1, dstMat, 0, GEMM_2_T);
+            if (calibrating)
+                inputRange = std::max(inputRange, norm(srcMat, NORM_INF));
+
+            float inpScale = getQuantizationScale(inputRange);
+            if (quantized)
+            {
+                quantize(srcMat, inpScale, srcInt8);
+                gemmInt8(srcInt8, wgtInt8, dstInt32);
+            }
+            else
+            {
+                //important: for perfomance purposes Caffe stores weights as transposed array
+                gemmCPU(srcMat, weight, 1, dstMat, 0, GEMM_2_T);
+            }
+
+            if (!bias && !activ && !quantized)
+                continue;
 
-            if (bias)
+            const float *biasPtr = (bias) ? blobs[1].ptrf() : NULL;
+            for (int m = 0; m < M; m++)
             {
-                Mat biasOnesMat = Mat::ones(M, 1, CV_32F);
-                Mat biasMat(1, N, CV_32F, blobs[1].ptrf());
-                gemmCPU(biasOnesMat, biasMat, 1, dstMat, 1);
+                float *row = dstMat.ptr<float>(m);
+
+                if (quantized)
+                {
+                    const int *acc = dstInt32.ptr<int>(m);
+                    for (int n = 0; n < N; n++)
+                        row[n] = acc[n] * (inpScale * wgtScales[n]);
+                }
+
+                if (biasPtr)
+                {
+                    for (int n = 0; n < N; n++)
+                        row[n] += biasPtr[n];
+                }
+
+                if (activ)
+                    activ->applyInPlace(row, N);
             }
         }
     }
+
+    int64 FullyConnectedLayer::getFLOPS(const std::vector<Blob*>&, const std::vector<Blob> &outputs) const
+    {
+        int64 flops = 0;
+        for (size_t i = 0; i < outputs.size(); i++)
+            flops += 2 * (int64)outputs[i].total() * innerSize;
+        return flops;
+    }
+
+    bool FullyConnectedLayer::setActivation(const Ptr<ElementWiseLayerBase> &layer)
+    {
+        activ = layer;
+        return true;
+    }
+
+    void FullyConnectedLayer::setCalibration(bool calibrate)
+    {
+        calibrating = calibrate;
+        if (calibrate)
+            inputRange = 0;
+    }
+
+    bool FullyConnectedLayer::setQuantization(bool quantize)
+    {
+        if (quantize && inputRange <= 0)
+            return false;
+
+        //the int8 weights are computed by allocate()
+        quantized = quantize;
+        if (!quantized)
+        {
+            wgtInt8.release();
+            wgtScales.clear();
+            srcInt8.release();
+            dstInt32.release();
+        }
+        return true;
+    }
 }
 }
@@ -42,12 +42,14 @@
 #ifndef __OPENCV_DNN_LAYERS_FULLY_CONNECTED_LAYER_HPP__
 #define __OPENCV_DNN_LAYERS_FULLY_CONNECTED_LAYER_HPP__
 #include "../precomp.hpp"
+#include "elementwise_layers.hpp"
+#include "op_quantize.hpp"
 
 namespace cv
 {
 namespace dnn
 {
-    class FullyConnectedLayer : public Layer
+    class FullyConnectedLayer : public Layer, public ActivationFusable, public Quantizable
     {
         bool bias;
         int numOutputs;
@@ -55,12 +57,23 @@ namespace dnn
 
         int innerSize;
 
+        Ptr<ElementWiseLayerBase> activ;
+
+        bool calibrating, quantized;
+        double inputRange;
+        Mat wgtInt8, srcInt8, dstInt32;
+        std::vector<float> wgtScales;
+
         void reshape(const Blob &inp, Blob &out);
 
     public:
         FullyConnectedLayer(LayerParams &params);
         void allocate(const std::vector<Blob*> &input, std::vector<Blob> &output);
         void forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
+        int64 getFLOPS(const std::vector<Blob*> &inputs, const std::vector<Blob> &outputs) const;
+        bool setActivation(const Ptr<ElementWiseLayerBase> &activ);
+        void setCalibration(bool calibrate);
+        bool setQuantization(bool quantize);
     };
 }
 }
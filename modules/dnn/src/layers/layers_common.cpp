@@ -85,5 +85,18 @@ void getKernelParams(LayerParams &params, int &kernelH, int &kernelW, int &padH,
     CV_Assert(kernelH > 0 && kernelW > 0 && padH >= 0 && padW >= 0 && strideH > 0 && strideW > 0);
 }
 
+int getParallelStripes(size_t tiles, size_t tileSize)
+{
+    const size_t minStripeSize = 1 << 14;
+
+    int threads = getNumThreads();
+    if (tiles < 2 || threads <= 1)
+        return 1;
+
+    size_t stripes = std::min(tiles, (size_t)threads);
+    stripes = std::min(stripes, std::max(tiles * tileSize / minStripeSize, (size_t)1));
+    return (int)stripes;
+}
+
 }
 }
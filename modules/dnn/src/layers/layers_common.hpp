@@ -50,6 +50,9 @@ namespace dnn
 
 void getKernelParams(LayerParams &params, int &kernelH, int &kernelW, int &padH, int &padW, int &strideH, int &strideW);
 
+//number of stripes for parallel_for_ over independent tiles of tileSize elements; small jobs aren't worth waking up threads
+int getParallelStripes(size_t tiles, size_t tileSize);
+
 }
 }
 
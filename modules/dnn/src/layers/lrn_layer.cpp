@@ -42,6 +42,7 @@
 #include "../precomp.hpp"
 #include "layers_common.hpp"
 #include "lrn_layer.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <opencv2/imgproc.hpp>
 #include <algorithm>
 
@@ -49,6 +50,9 @@ namespace cv
 {
 namespace dnn
 {
+    //across channels normalization keeps sums of squares of this number of pixels in L1
+    static const int lrnChunk = 1024;
+
     LRNLayer::LRNLayer(LayerParams &params) : Layer(params)
     {
         String nrmType = params.get<String>("norm_region", "ACROSS_CHANNELS");
@@ -74,89 +78,193 @@ namespace dnn
 
         Vec4i shape = inputs[0]->shape4();
         outputs[0].create(shape);
-
-        shape[0] = 1; //maybe make shape[0] = 1 too
-        bufBlob.create(shape);
     }
 
+    class LRNLayer::ForwardInvoker : public ParallelLoopBody
+    {
+    public:
+        ForwardInvoker(LRNLayer *layer_, Blob &src_, Blob &dst_, size_t tiles_, int nstripes_)
+            : layer(layer_), src(&src_), dst(&dst_), tiles(tiles_), nstripes(nstripes_) {}
+
+        void operator()(const Range &r) const
+        {
+            Range tileRange((int)(r.start * tiles / nstripes), (int)(r.end * tiles / nstripes));
+            if (layer->type == CHANNEL_NRM)
+                layer->channelNormalization(*src, *dst, tileRange);
+            else
+                layer->spatialNormalization(*src, *dst, tileRange);
+        }
+
+    private:
+        LRNLayer *layer;
+        Blob *src, *dst;
+        size_t tiles;
+        int nstripes;
+    };
+
     void LRNLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
     {
         Blob &src = *inputs[0];
         Blob &dst = outputs[0];
+        CV_Assert(src.type() == CV_32F);
 
+        size_t planeSize = src.total(2);
+        size_t tiles, tileSize;
         switch (type)
         {
         case CHANNEL_NRM:
-            channelNoramlization(src, dst);
+            tiles = src.num() * ((planeSize + lrnChunk - 1) / lrnChunk);
+            tileSize = src.channels() * std::min(planeSize, (size_t)lrnChunk);
             break;
         case SPATIAL_NRM:
-            spatialNormalization(src, dst);
+            tiles = src.num() * src.channels();
+            tileSize = planeSize * size;
             break;
         default:
             CV_Error(cv::Error::StsNotImplemented, "Unimplemented mode of LRN layer");
-            break;
+            return;
         }
+
+        int nstripes = getParallelStripes(tiles, tileSize);
+        if (nstripes <= 1)
+            ForwardInvoker(this, src, dst, tiles, 1)(Range(0, 1));
+        else
+            parallel_for_(Range(0, nstripes), ForwardInvoker(this, src, dst, tiles, nstripes), nstripes);
     }
 
-    void LRNLayer::channelNoramlization(Blob &srcBlob, Blob &dstBlob)
+    int64 LRNLayer::getFLOPS(const std::vector<Blob*>&, const std::vector<Blob> &outputs) const
+    {
+        //sum of squares over the window, then scaling, power and division
+        int windowSize = (type == CHANNEL_NRM) ? size : size * size;
+        return (int64)outputs[0].total() * (2 * windowSize + 3);
+    }
+
+    static void addSquare(float *acc, const float *x, int len)
+    {
+        int i = 0;
+#if CV_SIMD128
+        for (; i <= len - 4; i += 4)
+        {
+            v_float32x4 v = v_load(x + i);
+            v_store(acc + i, v_load(acc + i) + v * v);
+        }
+#endif
+        for (; i < len; i++)
+            acc[i] += x[i] * x[i];
+    }
+
+    static void subtractSquare(float *acc, const float *x, int len)
+    {
+        int i = 0;
+#if CV_SIMD128
+        for (; i <= len - 4; i += 4)
+        {
+            v_float32x4 v = v_load(x + i);
+            v_store(acc + i, v_load(acc + i) - v * v);
+        }
+#endif
+        for (; i < len; i++)
+            acc[i] -= x[i] * x[i];
+    }
+
+    //dst = src / (1 + k*sqrSum)^beta, sqrSum may be the same as dst
+    static void normalize(const float *src, const float *sqrSum, float *dst, float *buf, int len, float k, double beta)
+    {
+        int i = 0;
+        if (beta == 0.75)
+        {
+            //the default case, x^0.75 = sqrt(x) * sqrt(sqrt(x)) is much faster than pow()
+#if CV_SIMD128
+            v_float32x4 one = v_setall_f32(1.f), vk = v_setall_f32(k);
+            for (; i <= len - 4; i += 4)
+            {
+                v_float32x4 s = v_sqrt(one + vk * v_load(sqrSum + i));
+                v_store(dst + i, v_load(src + i) / (s * v_sqrt(s)));
+            }
+#endif
+            for (; i < len; i++)
+            {
+                float s = std::sqrt(1.f + k * sqrSum[i]);
+                dst[i] = src[i] / (s * std::sqrt(s));
+            }
+            return;
+        }
+
+        for (i = 0; i < len; i++)
+            buf[i] = 1.f + k * sqrSum[i];
+
+        Mat bufMat(1, len, CV_32F, buf);
+        cv::pow(bufMat, -beta, bufMat);
+
+        i = 0;
+#if CV_SIMD128
+        for (; i <= len - 4; i += 4)
+            v_store(dst + i, v_load(src + i) * v_load(buf + i));
+#endif
+        for (; i < len; i++)
+            dst[i] = src[i] * buf[i];
+    }
+
+    void LRNLayer::channelNormalization(Blob &srcBlob, Blob &dstBlob, const Range &tiles)
     {
         CV_DbgAssert(srcBlob.ptr() != dstBlob.ptr());
 
-        int num = srcBlob.num();
         int channels = srcBlob.channels();
         int ksize = (size - 1) / 2;
+        size_t planeSize = srcBlob.total(2);
+        size_t chunks = (planeSize + lrnChunk - 1) / lrnChunk;
+        float k = (float)(alpha / size);
+
+        AutoBuffer<float> buf(2 * lrnChunk);
+        float *accum = buf, *powBuf = accum + lrnChunk;
 
-        for (int n = 0; n < num; n++)
+        for (int tile = tiles.start; tile < tiles.end; tile++)
         {
-            Mat accum = dstBlob.getPlane(n, channels-1); //trick for memory saving
-            accum.setTo(0);
+            int n = (int)(tile / chunks);
+            size_t start = (tile % chunks) * lrnChunk;
+            int len = (int)std::min((size_t)lrnChunk, planeSize - start);
 
+            const float *src = srcBlob.ptrf(n) + start;
+            float *dst = dstBlob.ptrf(n) + start;
+
+            std::fill(accum, accum + len, 0.f);
             for (int cn = 0; cn < std::min(ksize, channels); cn++)
-                cv::accumulateSquare(srcBlob.getPlane(n, cn), accum);
+                addSquare(accum, src + cn * planeSize, len);
 
             for (int cn = 0; cn < channels; cn++)
             {
                 if (cn + ksize < channels)
-                {
-                    cv::accumulateSquare(srcBlob.getPlane(n, cn + ksize), accum);
-                }
+                    addSquare(accum, src + (cn + ksize) * planeSize, len);
 
                 if (cn - ksize - 1 >= 0)
-                {
-                    Mat left = srcBlob.getPlane(n, cn - ksize - 1);
-                    cv::subtract(accum, left.mul(left), accum); //subtractSquare
-                }
-
-                Mat dst = dstBlob.getPlane(n, cn);
-                accum.convertTo(dst, dst.type(), alpha/size, 1);
-                cv::pow(dst, beta, dst);
-                cv::divide(srcBlob.getPlane(n, cn), dst, dst);
+                    subtractSquare(accum, src + (cn - ksize - 1) * planeSize, len);
+
+                normalize(src + cn * planeSize, accum, dst + cn * planeSize, powBuf, len, k, beta);
             }
         }
     }
 
-    void LRNLayer::spatialNormalization(Blob &srcBlob, Blob &dstBlob)
+    void LRNLayer::spatialNormalization(Blob &srcBlob, Blob &dstBlob, const Range &tiles)
     {
-        int num = srcBlob.num();
         int channels = srcBlob.channels();
+        int planeSize = (int)srcBlob.total(2);
+        float k = (float)(alpha / (size * size));
+
+        AutoBuffer<float> powBuf(planeSize);
 
-        for (int n = 0; n < num; n++)
+        for (int tile = tiles.start; tile < tiles.end; tile++)
         {
-            for (int cn = 0; cn < channels; cn++)
-            {
-                Mat src = srcBlob.getPlane(n, cn);
-                Mat dst = dstBlob.getPlane(n, cn);
-                uchar *dataDst0 = dst.data;
-
-                cv::pow(srcBlob.getPlane(n, cn), 2, dst);
-                //TODO: check border type
-                cv::boxFilter(dst, dst, dst.depth(), cv::Size(size, size), cv::Point(-1, -1), false, cv::BORDER_CONSTANT);
-                dst.convertTo(dst, dst.type(), alpha/(size*size), 1);
-                cv::pow(dst, beta, dst);
-                cv::divide(src, dst, dst);
-
-                CV_Assert(dataDst0 == dst.data); //debug
-            }
+            int n = tile / channels, cn = tile % channels;
+            Mat src = srcBlob.getPlane(n, cn);
+            Mat dst = dstBlob.getPlane(n, cn);
+            uchar *dataDst0 = dst.data;
+
+            cv::multiply(src, src, dst);
+            //TODO: check border type
+            cv::boxFilter(dst, dst, dst.depth(), cv::Size(size, size), cv::Point(-1, -1), false, cv::BORDER_CONSTANT);
+            normalize(src.ptr<float>(), dst.ptr<float>(), dst.ptr<float>(), powBuf, planeSize, k, beta);
+
+            CV_Assert(dataDst0 == dst.data); //debug
         }
     }
 
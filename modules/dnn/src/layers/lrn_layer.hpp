@@ -59,16 +59,16 @@ namespace dnn
         int size;
         double alpha, beta;
 
-        Blob bufBlob;
-
-        void channelNoramlization(Blob &src, Blob &dst);
-        void spatialNormalization(Blob &src, Blob &dst);
+        class ForwardInvoker;
+        void channelNormalization(Blob &src, Blob &dst, const Range &tiles);
+        void spatialNormalization(Blob &src, Blob &dst, const Range &tiles);
 
     public:
 
         LRNLayer(LayerParams &params);
         void allocate(const std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
         void forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
+        int64 getFLOPS(const std::vector<Blob*> &inputs, const std::vector<Blob> &outputs) const;
     };
 }
 }
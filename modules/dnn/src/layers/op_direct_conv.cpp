@@ -0,0 +1,124 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "../precomp.hpp"
+#include "op_direct_conv.hpp"
+#include "opencv2/core/hal/intrin.hpp"
+#include <algorithm>
+
+namespace cv
+{
+namespace dnn
+{
+
+//accumulates w*src[x*stride] into dst[x] for x in [xStart; xEnd)
+static inline void accumulateRow(const float *src, float w, int stride, int xStart, int xEnd, float *dst)
+{
+    int x = xStart;
+
+    if (stride == 1)
+    {
+#if CV_SIMD128
+        v_float32x4 vw = v_setall_f32(w);
+        for (; x <= xEnd - 4; x += 4)
+            v_store(dst + x, v_load(dst + x) + vw * v_load(src + x));
+#endif
+        for (; x < xEnd; x++)
+            dst[x] += w * src[x];
+    }
+    else
+    {
+        for (; x < xEnd; x++)
+            dst[x] += w * src[x*stride];
+    }
+}
+
+void directConv(const float *src, int inpCn, int inpH, int inpW,
+                const float *wgt, const float *bias, int outCn, int kerH, int kerW,
+                int padH, int padW, int strideH, int strideW,
+                float *dst, int outH, int outW)
+{
+    //range of output columns which don't touch padding for each kernel column
+    std::vector<int> xStart(kerW), xEnd(kerW);
+    for (int j = 0; j < kerW; j++)
+    {
+        int lo = padW - j, hi = inpW - 1 + padW - j;
+        xStart[j] = (lo > 0) ? std::min(outW, (lo + strideW - 1) / strideW) : 0;
+        xEnd[j] = (hi >= 0) ? std::min(outW, hi / strideW + 1) : 0;
+    }
+
+    for (int k = 0; k < outCn; k++)
+    {
+        const float *wgtK = wgt + (size_t)k*inpCn*kerH*kerW;
+        float *dstPlane = dst + (size_t)k*outH*outW;
+        float b = (bias) ? bias[k] : 0.f;
+
+        for (int y = 0; y < outH; y++)
+        {
+            float *dstRow = dstPlane + (size_t)y*outW;
+            for (int x = 0; x < outW; x++)
+                dstRow[x] = b;
+
+            for (int c = 0; c < inpCn; c++)
+            {
+                const float *srcPlane = src + (size_t)c*inpH*inpW;
+                const float *wgtKC = wgtK + (size_t)c*kerH*kerW;
+
+                for (int i = 0; i < kerH; i++)
+                {
+                    int iy = y*strideH - padH + i;
+                    if (iy < 0 || iy >= inpH)
+                        continue;
+
+                    const float *srcRow = srcPlane + (size_t)iy*inpW;
+                    for (int j = 0; j < kerW; j++)
+                    {
+                        if (xStart[j] < xEnd[j])
+                            accumulateRow(srcRow + (j - padW), wgtKC[i*kerW + j], strideW, xStart[j], xEnd[j], dstRow);
+                    }
+                }
+            }
+        }
+    }
+}
+
+}
+}
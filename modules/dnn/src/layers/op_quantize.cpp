@@ -0,0 +1,177 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "../precomp.hpp"
+#include "op_quantize.hpp"
+#include "opencv2/core/hal/intrin.hpp"
+#include <algorithm>
+
+namespace cv
+{
+namespace dnn
+{
+
+static void quantizeRow(const float *src, float invScale, int size, schar *dst)
+{
+    int i = 0;
+#if CV_SIMD128
+    v_float32x4 vs = v_setall_f32(invScale);
+    for (; i <= size - 16; i += 16)
+    {
+        v_int32x4 a = v_round(v_load(src + i) * vs);
+        v_int32x4 b = v_round(v_load(src + i + 4) * vs);
+        v_int32x4 c = v_round(v_load(src + i + 8) * vs);
+        v_int32x4 d = v_round(v_load(src + i + 12) * vs);
+        v_store(dst + i, v_pack(v_pack(a, b), v_pack(c, d)));
+    }
+#endif
+    for (; i < size; i++)
+        dst[i] = saturate_cast<schar>(cvRound(src[i] * invScale));
+}
+
+void quantizeRows(const Mat &src, Mat &dst, std::vector<float> &scales)
+{
+    CV_Assert(src.dims == 2 && src.type() == CV_32F);
+
+    dst.create(src.rows, src.cols, CV_8S);
+    scales.resize(src.rows);
+
+    for (int i = 0; i < src.rows; i++)
+    {
+        const float *srcRow = src.ptr<float>(i);
+
+        float maxAbs = 0;
+        for (int j = 0; j < src.cols; j++)
+            maxAbs = std::max(maxAbs, std::abs(srcRow[j]));
+
+        scales[i] = getQuantizationScale(maxAbs);
+        quantizeRow(srcRow, 1.f / scales[i], src.cols, dst.ptr<schar>(i));
+    }
+}
+
+void quantize(const Mat &src, float scale, Mat &dst, bool transpose)
+{
+    CV_Assert(src.dims == 2 && src.type() == CV_32F && scale > 0);
+    float invScale = 1.f / scale;
+
+    if (!transpose)
+    {
+        dst.create(src.rows, src.cols, CV_8S);
+        for (int i = 0; i < src.rows; i++)
+            quantizeRow(src.ptr<float>(i), invScale, src.cols, dst.ptr<schar>(i));
+        return;
+    }
+
+    //transpose by square blocks to keep both reads and writes in cache
+    const int BLOCK = 32;
+    dst.create(src.cols, src.rows, CV_8S);
+
+    for (int i0 = 0; i0 < src.rows; i0 += BLOCK)
+    {
+        int i1 = std::min(i0 + BLOCK, src.rows);
+        for (int j0 = 0; j0 < src.cols; j0 += BLOCK)
+        {
+            int j1 = std::min(j0 + BLOCK, src.cols);
+            for (int i = i0; i < i1; i++)
+            {
+                const float *srcRow = src.ptr<float>(i);
+                for (int j = j0; j < j1; j++)
+                    dst.at<schar>(j, i) = saturate_cast<schar>(cvRound(srcRow[j] * invScale));
+            }
+        }
+    }
+}
+
+static inline int dotInt8(const schar *a, const schar *b, int size)
+{
+    int i = 0, sum = 0;
+#if CV_SIMD128
+    v_int32x4 vsum = v_setzero_s32();
+    for (; i <= size - 16; i += 16)
+    {
+        v_int16x8 a0, a1, b0, b1;
+        v_expand(v_load(a + i), a0, a1);
+        v_expand(v_load(b + i), b0, b1);
+        vsum += v_dotprod(a0, b0) + v_dotprod(a1, b1);
+    }
+    sum = v_reduce_sum(vsum);
+#endif
+    for (; i < size; i++)
+        sum += (int)a[i] * (int)b[i];
+    return sum;
+}
+
+class GemmInt8Invoker : public ParallelLoopBody
+{
+public:
+    GemmInt8Invoker(const Mat &A_, const Mat &B_, Mat &C_) : A(&A_), B(&B_), C(&C_) {}
+
+    void operator()(const Range &range) const
+    {
+        int K = A->cols;
+
+        //rows of B are outer, so each of them is read from memory once per stripe
+        for (int n = range.start; n < range.end; n++)
+        {
+            const schar *bRow = B->ptr<schar>(n);
+            for (int m = 0; m < A->rows; m++)
+                C->at<int>(m, n) = dotInt8(A->ptr<schar>(m), bRow, K);
+        }
+    }
+
+private:
+    const Mat *A, *B;
+    Mat *C;
+};
+
+void gemmInt8(const Mat &A, const Mat &B, Mat &C)
+{
+    CV_Assert(A.dims == 2 && B.dims == 2 && A.type() == CV_8S && B.type() == CV_8S);
+    CV_Assert(A.cols == B.cols);
+
+    C.create(A.rows, B.rows, CV_32S);
+
+    double work = (double)A.rows * B.rows * A.cols;
+    parallel_for_(Range(0, B.rows), GemmInt8Invoker(A, B, C), work / (1 << 16));
+}
+
+}
+}
@@ -0,0 +1,87 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#ifndef __OPENCV_DNN_LAYERS_OP_QUANTIZE_HPP__
+#define __OPENCV_DNN_LAYERS_OP_QUANTIZE_HPP__
+#include "../precomp.hpp"
+
+namespace cv
+{
+namespace dnn
+{
+
+//! Interface of layers which are able to compute in int8
+class Quantizable
+{
+public:
+    virtual ~Quantizable() {}
+
+    //! While calibration is enabled the layer records range of its inputs in forward(), enabling resets the range
+    virtual void setCalibration(bool calibrate) = 0;
+
+    //! Switches the layer to int8 computations, returns false if the layer wasn't calibrated
+    virtual bool setQuantization(bool quantize) = 0;
+};
+
+//! Returns scale which maps [-range; range] to [-127; 127]
+inline float getQuantizationScale(double range)
+{
+    return (range > 0) ? (float)(range / 127) : 1.f;
+}
+
+/* Quantizes each row of float matrix @p src with its own scale, @p dst is CV_8S matrix of the same size.
+ * Dequantized values are dst(i, j)*scales[i].
+ */
+void quantizeRows(const Mat &src, Mat &dst, std::vector<float> &scales);
+
+/* Quantizes float matrix @p src with the given scale, @p dst is CV_8S matrix.
+ * If @p transpose is true then transposed matrix is stored, what gives continuous rows for gemmInt8().
+ */
+void quantize(const Mat &src, float scale, Mat &dst, bool transpose = false);
+
+/* Computes C = A * B^T for CV_8S matrices A (M x K) and B (N x K) with int32 accumulation, C is CV_32S matrix.
+ * Both operands are read along continuous rows.
+ */
+void gemmInt8(const Mat &A, const Mat &B, Mat &C);
+
+}
+}
+#endif
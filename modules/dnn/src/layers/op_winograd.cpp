@@ -0,0 +1,201 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "../precomp.hpp"
+#include "op_winograd.hpp"
+
+namespace cv
+{
+namespace dnn
+{
+
+//computes B^T x for the 4-element vector x
+static inline void winogradBT(float x0, float x1, float x2, float x3, float *y, int step)
+{
+    y[0*step] = x0 - x2;
+    y[1*step] = x1 + x2;
+    y[2*step] = x2 - x1;
+    y[3*step] = x1 - x3;
+}
+
+//computes G x for the 3-element vector x
+static inline void winogradG(float x0, float x1, float x2, float *y, int step)
+{
+    y[0*step] = x0;
+    y[1*step] = 0.5f*(x0 + x1 + x2);
+    y[2*step] = 0.5f*(x0 - x1 + x2);
+    y[3*step] = x2;
+}
+
+void winogradTransformKernels(const float *wgt, int outCn, int inpCn, float *dst)
+{
+    size_t planeSize = (size_t)outCn * inpCn;
+
+    for (int k = 0; k < outCn; k++)
+    {
+        for (int c = 0; c < inpCn; c++)
+        {
+            const float *g = wgt + ((size_t)k*inpCn + c)*9;
+            float tmp[12], u[16];
+
+            //G g: 4x3
+            for (int j = 0; j < 3; j++)
+                winogradG(g[j], g[3 + j], g[6 + j], tmp + j, 3);
+
+            //(G g) G^T: 4x4
+            for (int i = 0; i < 4; i++)
+                winogradG(tmp[3*i], tmp[3*i + 1], tmp[3*i + 2], u + 4*i, 1);
+
+            float *dstPtr = dst + (size_t)k*inpCn + c;
+            for (int i = 0; i < WINOGRAD_TILE_AREA; i++)
+                dstPtr[i*planeSize] = u[i];
+        }
+    }
+}
+
+void winogradTransformInput(const float *src, int cn, int height, int width, int padH, int padW,
+                            int tilesH, int tilesW, float *dst)
+{
+    size_t tiles = (size_t)tilesH * tilesW;
+    size_t planeSize = (size_t)cn * tiles;
+
+    for (int c = 0; c < cn; c++)
+    {
+        const float *srcPlane = src + (size_t)c*height*width;
+        float *dstPlane = dst + c*tiles;
+
+        for (int ty = 0; ty < tilesH; ty++)
+        {
+            int y0 = 2*ty - padH;
+
+            for (int tx = 0; tx < tilesW; tx++)
+            {
+                int x0 = 2*tx - padW;
+                float d[16], t[16];
+
+                if (y0 >= 0 && y0 + 4 <= height && x0 >= 0 && x0 + 4 <= width)
+                {
+                    for (int i = 0; i < 4; i++)
+                    {
+                        const float *row = srcPlane + (size_t)(y0 + i)*width + x0;
+                        d[4*i] = row[0]; d[4*i + 1] = row[1]; d[4*i + 2] = row[2]; d[4*i + 3] = row[3];
+                    }
+                }
+                else
+                {
+                    for (int i = 0; i < 4; i++)
+                    {
+                        for (int j = 0; j < 4; j++)
+                        {
+                            int y = y0 + i, x = x0 + j;
+                            d[4*i + j] = (0 <= y && y < height && 0 <= x && x < width) ? srcPlane[(size_t)y*width + x] : 0.f;
+                        }
+                    }
+                }
+
+                //B^T d
+                for (int j = 0; j < 4; j++)
+                    winogradBT(d[j], d[4 + j], d[8 + j], d[12 + j], t + j, 4);
+
+                //(B^T d) B
+                float *dstPtr = dstPlane + ty*tilesW + tx;
+                for (int i = 0; i < 4; i++)
+                {
+                    float v[4];
+                    winogradBT(t[4*i], t[4*i + 1], t[4*i + 2], t[4*i + 3], v, 1);
+                    for (int j = 0; j < 4; j++)
+                        dstPtr[(4*i + j)*planeSize] = v[j];
+                }
+            }
+        }
+    }
+}
+
+void winogradTransformOutput(const float *src, int cn, int tilesH, int tilesW, const float *bias,
+                             int outH, int outW, float *dst)
+{
+    size_t tiles = (size_t)tilesH * tilesW;
+    size_t planeSize = (size_t)cn * tiles;
+
+    for (int c = 0; c < cn; c++)
+    {
+        const float *srcPlane = src + c*tiles;
+        float *dstPlane = dst + (size_t)c*outH*outW;
+        float b = (bias) ? bias[c] : 0.f;
+
+        for (int ty = 0; ty < tilesH; ty++)
+        {
+            for (int tx = 0; tx < tilesW; tx++)
+            {
+                const float *srcPtr = srcPlane + ty*tilesW + tx;
+                float m[16], s[8];
+                for (int i = 0; i < WINOGRAD_TILE_AREA; i++)
+                    m[i] = srcPtr[i*planeSize];
+
+                //A^T m: 2x4
+                for (int j = 0; j < 4; j++)
+                {
+                    s[j]     = m[j] + m[4 + j] + m[8 + j];
+                    s[4 + j] = m[4 + j] - m[8 + j] - m[12 + j];
+                }
+
+                //(A^T m) A: 2x2
+                float y[4];
+                y[0] = s[0] + s[1] + s[2] + b;
+                y[1] = s[1] - s[2] - s[3] + b;
+                y[2] = s[4] + s[5] + s[6] + b;
+                y[3] = s[5] - s[6] - s[7] + b;
+
+                int oy = 2*ty, ox = 2*tx;
+                for (int i = 0; i < 2 && oy + i < outH; i++)
+                {
+                    float *dstRow = dstPlane + (size_t)(oy + i)*outW;
+                    dstRow[ox] = y[2*i];
+                    if (ox + 1 < outW)
+                        dstRow[ox + 1] = y[2*i + 1];
+                }
+            }
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,74 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#ifndef __OPENCV_DNN_LAYERS_OP_WINOGRAD_HPP__
+#define __OPENCV_DNN_LAYERS_OP_WINOGRAD_HPP__
+#include "../precomp.hpp"
+
+namespace cv
+{
+namespace dnn
+{
+
+/* Winograd F(2x2, 3x3) minimal filtering algorithm for 3x3 convolutions with unit stride.
+ *
+ * Each 2x2 output tile is computed from 4x4 input tile as A^T [(G g G^T) .* (B^T d B)] A.
+ * Element-wise products over channels are done as 16 independent matrix multiplications,
+ * so the transformed data is stored position-major: [16][channels][tiles].
+ */
+
+//number of elements in transformed 4x4 tile
+const int WINOGRAD_TILE_AREA = 16;
+
+//transforms [outCn][inpCn][3][3] weights into [16][outCn][inpCn] array
+void winogradTransformKernels(const float *wgt, int outCn, int inpCn, float *dst);
+
+//transforms [cn][height][width] image into [16][cn][tilesH*tilesW] array
+void winogradTransformInput(const float *src, int cn, int height, int width, int padH, int padW,
+                            int tilesH, int tilesW, float *dst);
+
+//transforms [16][cn][tilesH*tilesW] array into [cn][outH][outW] image, adds @p bias if it isn't NULL
+void winogradTransformOutput(const float *src, int cn, int tilesH, int tilesW, const float *bias,
+                             int outH, int outW, float *dst);
+
+}
+}
+#endif
@@ -42,6 +42,7 @@
 #include "../precomp.hpp"
 #include "layers_common.hpp"
 #include "pooling_layer.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <float.h>
 #include <algorithm>
 using std::max;
@@ -82,6 +83,7 @@ namespace dnn
         inpW = inputs[0]->cols();
         inpH = inputs[0]->rows();
         computeOutputShape(inpH, inpW);
+        computeInnerColumns();
 
         outputs.resize(inputs.size());
         for (size_t i = 0; i < inputs.size(); i++)
@@ -91,97 +93,179 @@ namespace dnn
         }
     }
 
-    void PoolingLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
+    class PoolingLayer::ForwardInvoker : public ParallelLoopBody
     {
-        for (size_t ii = 0; ii < inputs.size(); ii++)
+    public:
+        ForwardInvoker(PoolingLayer *layer_, Blob &input_, Blob &output_, int nstripes_)
+            : layer(layer_), input(&input_), output(&output_), nstripes(nstripes_) {}
+
+        void operator()(const Range &r) const
         {
-            switch (type)
+            int channels = input->channels();
+            int planes = input->num() * channels;
+            int start = (int)((int64)planes * r.start / nstripes);
+            int end = (int)((int64)planes * r.end / nstripes);
+
+            for (int p = start; p < end; p++)
             {
-            case MAX:
-                maxPooling(*inputs[ii], outputs[ii]);
-                break;
-            case AVE:
-                avePooling(*inputs[ii], outputs[ii]);
-                break;
-            default:
-                CV_Error(cv::Error::StsNotImplemented, "Not implemented");
-                break;
+                const float *srcData = input->ptrf(p / channels, p % channels);
+                float *dstData = output->ptrf(p / channels, p % channels);
+
+                if (layer->type == MAX)
+                    layer->maxPooling(srcData, dstData);
+                else
+                    layer->avePooling(srcData, dstData);
             }
         }
+
+    private:
+        PoolingLayer *layer;
+        Blob *input, *output;
+        int nstripes;
+    };
+
+    void PoolingLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
+    {
+        if (type != MAX && type != AVE)
+            CV_Error(cv::Error::StsNotImplemented, "Not implemented");
+
+        for (size_t ii = 0; ii < inputs.size(); ii++)
+        {
+            Blob &input = *inputs[ii];
+            Blob &output = outputs[ii];
+            CV_Assert(input.type() == CV_32F);
+            CV_DbgAssert(output.rows() == outH && output.cols() == outW);
+
+            size_t planes = input.total(0, 2);
+            int nstripes = getParallelStripes(planes, (size_t)outH * outW * kernelH * kernelW);
+
+            if (nstripes <= 1)
+                ForwardInvoker(this, input, output, 1)(Range(0, 1));
+            else
+                parallel_for_(Range(0, nstripes), ForwardInvoker(this, input, output, nstripes), nstripes);
+        }
+    }
+
+    int64 PoolingLayer::getFLOPS(const std::vector<Blob*>&, const std::vector<Blob> &outputs) const
+    {
+        int64 flops = 0;
+        for (size_t i = 0; i < outputs.size(); i++)
+            flops += (int64)outputs[i].total() * kernelH * kernelW;
+        return flops;
     }
 
-    void PoolingLayer::maxPooling(Blob &input, Blob &output)
+    void PoolingLayer::computeInnerColumns()
     {
-        CV_DbgAssert(output.rows() == outH && output.cols() == outW);
+        //windows of the vectorized columns lie inside the input row, stride 2 loads read one extra element
+        int extra = (strideW == 2) ? 1 : 0;
+        innerStart = (padW + strideW - 1) / strideW;
+        int last = inpW + padW - kernelW - extra;
+        innerEnd = (last >= 0) ? std::min(outW, last / strideW + 1) : 0;
+        if (strideW > 2 || innerEnd < innerStart)
+            innerStart = innerEnd = 0;
+    }
+
+#if CV_SIMD128
+    //loads src[0], src[stride], src[2*stride], src[3*stride] for stride 1 or 2
+    static inline v_float32x4 loadStrided(const float *src, int stride)
+    {
+        if (stride == 1)
+            return v_load(src);
+
+        v_float32x4 p, q, even, odd;
+        v_zip(v_load(src), v_load(src + 4), p, q);
+        v_zip(p, q, even, odd);
+        return even;
+    }
+#endif
 
-        for (int n = 0; n < input.num(); ++n)
+    void PoolingLayer::maxPooling(const float *srcData, float *dstData)
+    {
+        for (int ph = 0; ph < outH; ++ph)
         {
-            for (int c = 0; c < input.channels(); ++c)
-            {
-                float *srcData = input.ptrf(n, c);
-                float *dstData = output.ptrf(n, c);
+            int hstart = ph * strideH - padH;
+            int hend = min(hstart + kernelH, inpH);
+            hstart = max(hstart, 0);
 
-                for (int ph = 0; ph < outH; ++ph)
+            for (int pw = 0; pw < outW;)
+            {
+#if CV_SIMD128
+                if (pw >= innerStart && pw + 4 <= innerEnd)
                 {
-                    for (int pw = 0; pw < outW; ++pw)
+                    v_float32x4 vmax = v_setall_f32(-FLT_MAX);
+                    for (int h = hstart; h < hend; ++h)
                     {
-                        int hstart = ph * strideH - padH;
-                        int wstart = pw * strideW - padW;
-                        int hend = min(hstart + kernelH, inpH);
-                        int wend = min(wstart + kernelW, inpW);
-                        hstart = max(hstart, 0);
-                        wstart = max(wstart, 0);
-                        const int poolIndex = ph * outW + pw;
-                        float max_val = -FLT_MAX;
-
-                        for (int h = hstart; h < hend; ++h)
-                            for (int w = wstart; w < wend; ++w)
-                            {
-                                const int index = h * inpW + w;
-                                if (srcData[index] > max_val)
-                                    max_val = srcData[index];
-                            }
-
-                        dstData[poolIndex] = max_val;
+                        const float *row = srcData + h * inpW + pw * strideW - padW;
+                        for (int w = 0; w < kernelW; ++w)
+                            vmax = v_max(vmax, loadStrided(row + w, strideW));
                     }
+                    v_store(dstData + ph * outW + pw, vmax);
+                    pw += 4;
+                    continue;
                 }
+#endif
+                int wstart = pw * strideW - padW;
+                int wend = min(wstart + kernelW, inpW);
+                wstart = max(wstart, 0);
+                float max_val = -FLT_MAX;
+
+                for (int h = hstart; h < hend; ++h)
+                {
+                    const float *row = srcData + h * inpW;
+                    for (int w = wstart; w < wend; ++w)
+                        max_val = std::max(max_val, row[w]);
+                }
+
+                dstData[ph * outW + pw] = max_val;
+                pw++;
             }
         }
     }
 
-    void PoolingLayer::avePooling(Blob &input, Blob &output)
+    void PoolingLayer::avePooling(const float *srcData, float *dstData)
     {
-        for (int n = 0; n < input.num(); ++n)
+        for (int ph = 0; ph < outH; ++ph)
         {
-            for (int c = 0; c < input.channels(); ++c)
-            {
-                float *srcData = input.ptrf(n, c);
-                float *dstData = output.ptrf(n, c);
+            int hstart = ph * strideH - padH;
+            int hend = min(hstart + kernelH, inpH + padH);
+            int poolH = hend - hstart;
+            hstart = max(hstart, 0);
+            hend = min(hend, inpH);
 
-                for (int ph = 0; ph < outH; ++ph)
+            for (int pw = 0; pw < outW;)
+            {
+#if CV_SIMD128
+                if (pw >= innerStart && pw + 4 <= innerEnd)
                 {
-                    for (int pw = 0; pw < outW; ++pw)
+                    v_float32x4 vsum = v_setzero_f32();
+                    for (int h = hstart; h < hend; ++h)
                     {
-                        int hstart = ph * strideH - padH;
-                        int wstart = pw * strideW - padW;
-                        int hend = min(hstart + kernelH, inpH + padH);
-                        int wend = min(wstart + kernelW, inpW + padW);
-                        int poolSize = (hend - hstart) * (wend - wstart);
-                        hstart = max(hstart, 0);
-                        wstart = max(wstart, 0);
-                        hend = min(hend, inpH);
-                        wend = min(wend, inpW);
-
-                        dstData[ph * outW + pw] = 0.f;
-
-                        for (int h = hstart; h < hend; ++h)
-                            for (int w = wstart; w < wend; ++w)
-                                dstData[ph * outW + pw] += srcData[h * inpW + w];
-
-                        dstData[ph * outW + pw] /= poolSize;
+                        const float *row = srcData + h * inpW + pw * strideW - padW;
+                        for (int w = 0; w < kernelW; ++w)
+                            vsum += loadStrided(row + w, strideW);
                     }
+                    v_store(dstData + ph * outW + pw, vsum * v_setall_f32(1.f / (poolH * kernelW)));
+                    pw += 4;
+                    continue;
                 }
-          }
+#endif
+                int wstart = pw * strideW - padW;
+                int wend = min(wstart + kernelW, inpW + padW);
+                int poolSize = poolH * (wend - wstart);
+                wstart = max(wstart, 0);
+                wend = min(wend, inpW);
+                float sum = 0.f;
+
+                for (int h = hstart; h < hend; ++h)
+                {
+                    const float *row = srcData + h * inpW;
+                    for (int w = wstart; w < wend; ++w)
+                        sum += row[w];
+                }
+
+                dstData[ph * outW + pw] = sum / poolSize;
+                pw++;
+            }
         }
     }
 
@@ -63,15 +63,19 @@ namespace dnn
 
         int inpH, inpW;
         int outH, outW;
+        int innerStart, innerEnd; //range of output columns computed by vectorized code
 
+        class ForwardInvoker;
         void computeOutputShape(int inpH, int inpW);
-        void maxPooling(Blob &input, Blob &output);
-        void avePooling(Blob &input, Blob &output);
+        void computeInnerColumns();
+        void maxPooling(const float *srcData, float *dstData);
+        void avePooling(const float *srcData, float *dstData);
 
     public:
         PoolingLayer(LayerParams &params);
         void allocate(const std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
         void forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
+        int64 getFLOPS(const std::vector<Blob*> &inputs, const std::vector<Blob> &outputs) const;
     };
 }
 }
@@ -42,6 +42,7 @@
 #include "../precomp.hpp"
 #include "recurrent_layers.hpp"
 #include "op_blas.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <iostream>
 
 namespace cv
@@ -49,6 +50,81 @@ namespace cv
 namespace dnn
 {
 
+//Samples of a batch are independent, so the recurrence over timestamps is split between threads by samples.
+static int getNumStripes(int samples)
+{
+    int threads = getNumThreads();
+    if (samples < 2 || threads <= 1)
+        return 1;
+
+    //multithreaded BLAS loads all cores by itself, the number of its threads is a process-wide setting
+    //which can't be changed safely during forward(), so samples are split only for single-threaded BLAS
+    if (getBlasThreads() > 1)
+        return 1;
+
+    return std::min(samples, threads);
+}
+
+template<typename RecurrentImpl>
+class RecurrentInvoker : public ParallelLoopBody
+{
+public:
+    RecurrentInvoker(RecurrentImpl *impl_, int samples_, int nstripes_)
+        : impl(impl_), samples(samples_), nstripes(nstripes_) {}
+
+    void operator()(const Range &r) const
+    {
+        Range stripe(r.start * samples / nstripes, r.end * samples / nstripes);
+        if (!stripe.empty())
+            impl->forwardSamples(stripe);
+    }
+
+private:
+    RecurrentImpl *impl;
+    int samples, nstripes;
+};
+
+template<typename RecurrentImpl>
+static void runRecurrence(RecurrentImpl *impl, int samples)
+{
+    int nstripes = getNumStripes(samples);
+    if (nstripes <= 1)
+    {
+        impl->forwardSamples(Range(0, samples));
+        return;
+    }
+
+    parallel_for_(Range(0, nstripes), RecurrentInvoker<RecurrentImpl>(impl, samples, nstripes), nstripes);
+}
+
+//x = -2(x + b), so that a single exp() pass followed by tanhFinish() gives tanh(x + b)
+static void tanhPrepare(Mat &x, const float *bias)
+{
+    for (int i = 0; i < x.rows; i++)
+    {
+        float *row = x.ptr<float>(i);
+        for (int j = 0; j < x.cols; j++)
+            row[j] = -2.f * (row[j] + bias[j]);
+    }
+}
+
+//x = 2 / (1 + x) - 1, where x holds e^(-2y)
+static void tanhFinish(Mat &x)
+{
+    for (int i = 0; i < x.rows; i++)
+    {
+        float *row = x.ptr<float>(i);
+        int j = 0;
+#if CV_SIMD128
+        v_float32x4 one = v_setall_f32(1.f), two = v_setall_f32(2.f);
+        for (; j <= x.cols - 4; j += 4)
+            v_store(row + j, two / (one + v_load(row + j)) - one);
+#endif
+        for (; j < x.cols; j++)
+            row[j] = 2.f / (1.f + row[j]) - 1.f;
+    }
+}
+
 class LSTMLayerImpl : public LSTMLayer
 {
 public:
@@ -56,11 +132,14 @@ public:
     LSTMLayerImpl()
     {
         type = "LSTM";
+        useTimestampDim = false;
     }
 
-    int nH, nX, nC, numSamples;
+    int nH, nX, nC, numTimeStamps, numSamples;
+    bool useTimestampDim;
     Mat prevH, prevC;
-    Mat gates, dummyOnes;
+    Mat gates;
+    Mat h0, c0, hTs, cTs;
 
     void setWeights(const Blob &Wh, const Blob &Wx, const Blob &bias)
     {
@@ -74,29 +153,46 @@ public:
         blobs[2] = bias;
     }
 
+    void setUseTimestampsDim(bool use)
+    {
+        useTimestampDim = use;
+    }
+
     void allocate(const std::vector<Blob*> &input, std::vector<Blob> &output)
     {
         CV_Assert(blobs.size() == 3);
         Blob &Wh = blobs[0], &Wx = blobs[1];
-        
+
         nH = Wh.size(1);
         nX = Wx.size(1);
         nC = Wh.size(0) / 4;
+        CV_Assert(nH == nC);
 
         CV_Assert(input.size() >= 1 && input.size() <= 3);
-        CV_Assert(input[0]->size(-1) == nX);
-        
+        CV_Assert(input[0]->size(-1) == nX && input[0]->type() == CV_32F);
+
         BlobShape inpShape = input[0]->shape();
-        numSamples = input[0]->total(0, input[0]->dims()-1);
+        BlobShape stateShape = inpShape;
+        if (useTimestampDim)
+        {
+            CV_Assert(inpShape.dims() >= 2);
+            numTimeStamps = inpShape[0];
+            numSamples = (int)input[0]->total(1, inpShape.dims() - 1);
+            stateShape = BlobShape(inpShape.dims() - 1, inpShape.ptr() + 1);
+        }
+        else
+        {
+            numTimeStamps = 1;
+            numSamples = (int)input[0]->total(0, inpShape.dims() - 1);
+        }
+        stateShape[-1] = nC;
 
-        BlobShape hShape = inpShape;
-        hShape[-1] = nH;
-        BlobShape cShape = inpShape;
-        cShape[-1] = nC;
+        BlobShape outShape = inpShape;
+        outShape[-1] = nC;
 
         output.resize(2);
-        output[0].create(hShape, input[0]->type());
-        output[1].create(cShape, input[0]->type());
+        output[0].create(outShape, input[0]->type());
+        output[1].create(outShape, input[0]->type());
 
         if (input.size() < 2)
         {
@@ -104,7 +200,7 @@ public:
             prevH.setTo(0);
         }
         else
-            CV_Assert(input[1]->shape() == hShape);
+            CV_Assert(input[1]->shape() == stateShape);
 
         if (input.size() < 3)
         {
@@ -112,70 +208,123 @@ public:
             prevC.setTo(0);
         }
         else
-            CV_Assert(input[2]->shape() == cShape);
+            CV_Assert(input[2]->shape() == stateShape);
 
-        gates.create(numSamples, 4*nC, input[0]->type());
-        dummyOnes.create(numSamples, 1, input[0]->type());
-        dummyOnes.setTo(1);
+        gates.create(numTimeStamps * numSamples, 4*nC, input[0]->type());
     }
 
-    Mat ep, em;
-    void tanh(Mat &x, Mat &d)
+    //gates are stored as [i f o g]; ifo are replaced by -x and g by -2x, so one exp() pass serves all of them
+    static void prepareGates(float *g, const float *bias, int nC)
     {
-        //TODO: two exp() is bad idea
-        cv::exp(-x, em);
-        cv::exp( x, ep);
-        cv::divide(ep - em, ep + em, d);
+        int j = 0;
+        for (; j < 3*nC; j++)
+            g[j] = -(g[j] + bias[j]);
+        for (; j < 4*nC; j++)
+            g[j] = -2.f * (g[j] + bias[j]);
     }
 
-    void sigmoid(Mat &x)
+    //takes exponents of gates, computes c_t, keeps o_t in gates and writes -2c_t into h_t for the next exp() pass
+    static void computeCell(float *g, const float *cPrev, float *c, float *h, int nC)
     {
-        cv::exp(-x, x);
-        cv::pow(1 + x, -1, x);
+        float *gi = g, *gf = g + nC, *go = g + 2*nC, *gg = g + 3*nC;
+        int j = 0;
+#if CV_SIMD128
+        v_float32x4 one = v_setall_f32(1.f), two = v_setall_f32(2.f), mtwo = v_setall_f32(-2.f);
+        for (; j <= nC - 4; j += 4)
+        {
+            v_float32x4 vi = one / (one + v_load(gi + j));
+            v_float32x4 vf = one / (one + v_load(gf + j));
+            v_float32x4 vo = one / (one + v_load(go + j));
+            v_float32x4 vg = two / (one + v_load(gg + j)) - one;
+            v_float32x4 vc = vf * v_load(cPrev + j) + vi * vg;
+            v_store(go + j, vo);
+            v_store(c + j, vc);
+            v_store(h + j, vc * mtwo);
+        }
+#endif
+        for (; j < nC; j++)
+        {
+            float vi = 1.f / (1.f + gi[j]);
+            float vf = 1.f / (1.f + gf[j]);
+            float vg = 2.f / (1.f + gg[j]) - 1.f;
+            go[j] = 1.f / (1.f + go[j]);
+            c[j] = vf * cPrev[j] + vi * vg;
+            h[j] = -2.f * c[j];
+        }
+    }
+
+    //h_t = o_t * tanh(c_t), where h_t holds e^(-2c_t)
+    static void computeOutput(const float *o, float *h, int nC)
+    {
+        int j = 0;
+#if CV_SIMD128
+        v_float32x4 one = v_setall_f32(1.f), two = v_setall_f32(2.f);
+        for (; j <= nC - 4; j += 4)
+            v_store(h + j, v_load(o + j) * (two / (one + v_load(h + j)) - one));
+#endif
+        for (; j < nC; j++)
+            h[j] = o[j] * (2.f / (1.f + h[j]) - 1.f);
+    }
+
+    void forwardSamples(const Range &samples)
+    {
+        const Mat &Wh = blobs[0].matRefConst();
+        const float *bias = blobs[2].ptrf();
+
+        for (int t = 0; t < numTimeStamps; t++)
+        {
+            Range rows(t*numSamples + samples.start, t*numSamples + samples.end);
+            Mat gatesCurr = gates.rowRange(rows);
+            Mat hCurr = hTs.rowRange(rows);
+            Mat cCurr = cTs.rowRange(rows);
+            Mat hPrev = (t == 0) ? h0.rowRange(samples) : hTs.rowRange(rows.start - numSamples, rows.end - numSamples);
+            Mat cPrev = (t == 0) ? c0.rowRange(samples) : cTs.rowRange(rows.start - numSamples, rows.end - numSamples);
+
+            gemmCPU(hPrev, Wh, 1, gatesCurr, 1, GEMM_2_T); //+Wh * h_{t-1}
+
+            for (int i = 0; i < gatesCurr.rows; i++)
+                prepareGates(gatesCurr.ptr<float>(i), bias, nC);
+            cv::exp(gatesCurr, gatesCurr);
+
+            for (int i = 0; i < gatesCurr.rows; i++)
+                computeCell(gatesCurr.ptr<float>(i), cPrev.ptr<float>(i), cCurr.ptr<float>(i), hCurr.ptr<float>(i), nC);
+            cv::exp(hCurr, hCurr);
+
+            for (int i = 0; i < gatesCurr.rows; i++)
+                computeOutput(gatesCurr.ptr<float>(i) + 2*nC, hCurr.ptr<float>(i), nC);
+        }
     }
 
     void forward(std::vector<Blob*> &input, std::vector<Blob> &output)
     {
         CV_DbgAssert(blobs.size() == 3);
-        const Mat &Wh = blobs[0].matRefConst(), &Wx = blobs[1].matRefConst();
-        Mat bias = blobs[2].matRefConst().reshape(1, 1);
-        CV_DbgAssert(Wh.type() == CV_32F && Wx.type() == CV_32F && bias.type() == CV_32F);
-
-        int szx[] = { numSamples, nX };
-        int szc[] = { numSamples, nC };
-        Mat xCurr = input[0]->matRefConst().reshape(1, 2, szx);
-        Mat hPrev = (input.size() >= 2) ? input[1]->matRefConst().reshape(1, 2, szc) : prevH;
-        Mat cPrev = (input.size() >= 3) ? input[2]->matRefConst().reshape(1, 2, szc) : prevC;
-        CV_Assert(xCurr.type() == CV_32F && hPrev.type() == CV_32F && cPrev.type() == CV_32F);
-
-        Mat hCurr = output[0].matRef().reshape(1, 2, szc);
-        Mat cCurr = output[1].matRef().reshape(1, 2, szc);
-        CV_Assert(hCurr.type() == CV_32F && cCurr.type() == CV_32F);
-
-        gemmCPU(xCurr, Wx, 1, gates, 0, GEMM_2_T); // Wx * x_t
-        gemmCPU(hPrev, Wh, 1, gates, 1, GEMM_2_T); //+Wh * h_{t-1}
-        gemmCPU(dummyOnes, bias, 1, gates, 1);     //+b
-
-        Mat gatesDiv = gates.reshape(1, 4*numSamples);
-        Mat getesIFO = gatesDiv(Range(0, 3*numSamples), Range::all());
-        Mat gateI = gatesDiv(Range(0*numSamples, 1*numSamples), Range::all());
-        Mat gateF = gatesDiv(Range(1*numSamples, 2*numSamples), Range::all());
-        Mat gateO = gatesDiv(Range(2*numSamples, 3*numSamples), Range::all());
-        Mat gateG = gatesDiv(Range(3*numSamples, 4*numSamples), Range::all());
-        
-        sigmoid(getesIFO);
-        tanh(gateG, gateG);
-
-        cv::add(gateF.mul(cPrev), gateI.mul(gateG), cCurr);
-        
-        tanh(cCurr, hCurr);
-        cv::multiply(gateO, hCurr, hCurr);
-
-        //save answers for next iteration
-        if (input.size() <= 2)
-            hCurr.copyTo(hPrev);
-        if (input.size() <= 3)
-            cCurr.copyTo(cPrev);
+        const Mat &Wx = blobs[1].matRefConst();
+        CV_DbgAssert(blobs[0].type() == CV_32F && Wx.type() == CV_32F && blobs[2].type() == CV_32F);
+
+        int rows = numTimeStamps * numSamples;
+        Mat xTs(rows, nX, CV_32F, input[0]->ptrf());
+        hTs = Mat(rows, nH, CV_32F, output[0].ptrf());
+        cTs = Mat(rows, nC, CV_32F, output[1].ptrf());
+        h0 = (input.size() >= 2) ? Mat(numSamples, nH, CV_32F, input[1]->ptrf()) : prevH;
+        c0 = (input.size() >= 3) ? Mat(numSamples, nC, CV_32F, input[2]->ptrf()) : prevC;
+        CV_Assert(input[0]->type() == CV_32F && h0.type() == CV_32F && c0.type() == CV_32F);
+
+        //input projections don't depend on the recurrence, so they are computed for all timestamps at once
+        gemmCPU(xTs, Wx, 1, gates, 0, GEMM_2_T); // Wx * x_t
+
+        runRecurrence(this, numSamples);
+
+        //save answers for next call
+        Range last(rows - numSamples, rows);
+        if (input.size() < 2)
+            hTs.rowRange(last).copyTo(prevH);
+        if (input.size() < 3)
+            cTs.rowRange(last).copyTo(prevC);
+
+        h0.release();
+        c0.release();
+        hTs.release();
+        cTs.release();
     }
 };
 
@@ -192,16 +341,19 @@ void LSTMLayer::forward(std::vector<Blob*>&, std::vector<Blob>&)
 
 class RNNLayerImpl : public RNNLayer
 {
-    int nX, nH, nO, nSamples;
+    int nX, nH, nO, numTimeStamps, numSamples;
+    bool useTimestampDim;
     Mat Whh, Wxh, bh;
     Mat Who, bo;
-    Mat hPrevInternal, dummyBiasOnes;
+    Mat hPrevInternal;
+    Mat h0, hTs;
 
 public:
 
     RNNLayerImpl()
     {
         type = "RNN";
+        useTimestampDim = false;
     }
 
     void setWeights(const Blob &W_hh, const Blob &W_xh, const Blob &b_h, const Blob &W_ho, const Blob &b_o)
@@ -220,6 +372,11 @@ public:
         blobs[4] = b_o;
     }
 
+    void setUseTimestampsDim(bool use)
+    {
+        useTimestampDim = use;
+    }
+
     void allocate(const std::vector<Blob*> &input, std::vector<Blob> &output)
     {
         CV_Assert(input.size() >= 1 && input.size() <= 2);
@@ -234,9 +391,23 @@ public:
         nX = Wxh.cols;
         nO = Who.rows;
 
-        CV_Assert(input[0]->size(-1) == Wxh.cols);
-        nSamples = input[0]->total(0, input[0]->dims() - 1);
+        CV_Assert(input[0]->size(-1) == Wxh.cols && input[0]->type() == CV_32F);
         BlobShape xShape = input[0]->shape();
+        BlobShape stateShape = xShape;
+        if (useTimestampDim)
+        {
+            CV_Assert(xShape.dims() >= 2);
+            numTimeStamps = xShape[0];
+            numSamples = (int)input[0]->total(1, xShape.dims() - 1);
+            stateShape = BlobShape(xShape.dims() - 1, xShape.ptr() + 1);
+        }
+        else
+        {
+            numTimeStamps = 1;
+            numSamples = (int)input[0]->total(0, xShape.dims() - 1);
+        }
+        stateShape[-1] = nH;
+
         BlobShape hShape = xShape;
         BlobShape oShape = xShape;
         hShape[-1] = nH;
@@ -244,62 +415,62 @@ public:
 
         if (input.size() == 2)
         {
-            CV_Assert(input[1]->shape() == hShape);
+            CV_Assert(input[1]->shape() == stateShape);
         }
         else
         {
-            hPrevInternal.create(nSamples, nH, input[0]->type());
+            hPrevInternal.create(numSamples, nH, input[0]->type());
             hPrevInternal.setTo(0);
         }
 
         output.resize(2);
         output[0].create(oShape, input[0]->type());
         output[1].create(hShape, input[0]->type());
-
-        dummyBiasOnes.create(nSamples, 1, bh.type());
-        dummyBiasOnes.setTo(1);
-        bh = bh.reshape(1, 1); //is 1 x nH mat
-        bo = bo.reshape(1, 1); //is 1 x nO mat
     }
 
-    //in-place tanh function
-    static void tanh(Mat &x) // 2 / (1 + e^(-2x)) - 1
+    void forwardSamples(const Range &samples)
     {
-        x.convertTo(x, x.type(), -2);   // -2x
-        cv::exp(x, x);                  // e^(-2x)
-        x.convertTo(x, x.type(), 1, 1); // 1 + e^(-2x)
-        cv::pow(x, -1, x);              // 1 / (1 + e^(-2x))
-        x.convertTo(x, x.type(), 2, -1);// 2 / (1 + e^(-2x)) - 1
+        const float *bhPtr = bh.ptr<float>();
+
+        for (int t = 0; t < numTimeStamps; t++)
+        {
+            Range rows(t*numSamples + samples.start, t*numSamples + samples.end);
+            Mat hCurr = hTs.rowRange(rows);
+            Mat hPrev = (t == 0) ? h0.rowRange(samples) : hTs.rowRange(rows.start - numSamples, rows.end - numSamples);
+
+            gemmCPU(hPrev, Whh, 1, hCurr, 1, GEMM_2_T); //+W_{hh} * h_{prev}
+            tanhPrepare(hCurr, bhPtr);                  //+b_h
+            cv::exp(hCurr, hCurr);
+            tanhFinish(hCurr);
+        }
     }
 
     void forward(std::vector<Blob*> &input, std::vector<Blob> &output)
     {
-        Mat xCurr = input[0]->matRefConst();
-        Mat hPrev = (input.size() >= 2) ? input[1]->matRefConst() : hPrevInternal;
-        Mat oCurr = output[0].matRef();
-        Mat hCurr = output[1].matRef();
-
-        //TODO: Check types
-
-        int xsz[] = {nSamples, nX};
-        int hsz[] = {nSamples, nH};
-        int osz[] = {nSamples, nO};
-        if (xCurr.dims != 2) xCurr = xCurr.reshape(1, 2, xsz);
-        if (hPrev.dims != 2) hPrev = hPrev.reshape(1, 2, hsz);
-        if (oCurr.dims != 2) oCurr = oCurr.reshape(1, 2, osz);
-        if (hCurr.dims != 2) hCurr = hCurr.reshape(1, 2, hsz);
-
-        gemmCPU(hPrev, Whh, 1, hCurr, 0, GEMM_2_T); // W_{hh} * h_{prev}
-        gemmCPU(xCurr, Wxh, 1, hCurr, 1, GEMM_2_T); //+W_{xh} * x_{curr}
-        gemmCPU(dummyBiasOnes, bh, 1, hCurr, 1);      //+bh
-        tanh(hCurr);
-
-        gemmCPU(hPrev, Who, 1, oCurr, 0, GEMM_2_T); // W_{ho} * h_{prev}
-        gemmCPU(dummyBiasOnes, bo, 1, oCurr, 1);      //+b_o
-        tanh(oCurr);
+        CV_Assert(Whh.type() == CV_32F && Wxh.type() == CV_32F && Who.type() == CV_32F);
+
+        int rows = numTimeStamps * numSamples;
+        Mat xTs(rows, nX, CV_32F, input[0]->ptrf());
+        Mat oTs(rows, nO, CV_32F, output[0].ptrf());
+        hTs = Mat(rows, nH, CV_32F, output[1].ptrf());
+        h0 = (input.size() >= 2) ? Mat(numSamples, nH, CV_32F, input[1]->ptrf()) : hPrevInternal;
+
+        //input projections don't depend on the recurrence, so they are computed for all timestamps at once
+        gemmCPU(xTs, Wxh, 1, hTs, 0, GEMM_2_T); // W_{xh} * x_{curr}
+
+        runRecurrence(this, numSamples);
+
+        //outputs depend only on h_t, so they are computed for all timestamps at once too
+        gemmCPU(hTs, Who, 1, oTs, 0, GEMM_2_T); // W_{ho} * h_t
+        tanhPrepare(oTs, bo.ptr<float>());      //+b_o
+        cv::exp(oTs, oTs);
+        tanhFinish(oTs);
 
         if (input.size() < 2) //save h_{prev}
-            hCurr.copyTo(hPrevInternal);
+            hTs.rowRange(rows - numSamples, rows).copyTo(hPrevInternal);
+
+        h0.release();
+        hTs.release();
     }
 };
 
@@ -314,4 +485,4 @@ CV_EXPORTS_W Ptr<RNNLayer> RNNLayer::create()
 }
 
 }
-}
\ No newline at end of file
+}
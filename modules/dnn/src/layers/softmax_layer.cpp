@@ -42,6 +42,7 @@
 #include "../precomp.hpp"
 #include "layers_common.hpp"
 #include "softmax_layer.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <algorithm>
 #include <stdlib.h>
 using std::max;
@@ -65,79 +66,241 @@ namespace dnn
         BlobShape shape = inputs[0]->shape();
         outputs.resize(1);
         outputs[0].create(shape);
+    }
+
+    //columns of the tile are processed independently, so the tiles of long rows are short enough to fit buffers into L1
+    static const int softmaxChunk = 1024;
 
-        shape[axis] = 1;
-        maxAggregator.create(shape);
+    static void maxRow(float *acc, const float *x, int len)
+    {
+        int i = 0;
+#if CV_SIMD128
+        for (; i <= len - 4; i += 4)
+            v_store(acc + i, v_max(v_load(acc + i), v_load(x + i)));
+#endif
+        for (; i < len; i++)
+            acc[i] = std::max(acc[i], x[i]);
     }
 
-    void SoftMaxLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
+    static void subtractRow(const float *x, const float *y, float *dst, int len)
     {
-        Blob &src = *inputs[0];
-        Blob &dst = outputs[0];
+        int i = 0;
+#if CV_SIMD128
+        for (; i <= len - 4; i += 4)
+            v_store(dst + i, v_load(x + i) - v_load(y + i));
+#endif
+        for (; i < len; i++)
+            dst[i] = x[i] - y[i];
+    }
 
-        float *srcPtr = src.ptrf();
-        float *dstPtr = dst.ptrf();
-        float *bufPtr = maxAggregator.ptrf();
+    static void addRow(float *acc, const float *x, int len)
+    {
+        int i = 0;
+#if CV_SIMD128
+        for (; i <= len - 4; i += 4)
+            v_store(acc + i, v_load(acc + i) + v_load(x + i));
+#endif
+        for (; i < len; i++)
+            acc[i] += x[i];
+    }
 
-        size_t outerSize = src.total(0, axis);
-        size_t channels = src.size(axis);
-        size_t innerSize = src.total(axis + 1);
+    static void multiplyRow(float *dst, const float *scale, int len)
+    {
+        int i = 0;
+#if CV_SIMD128
+        for (; i <= len - 4; i += 4)
+            v_store(dst + i, v_load(dst + i) * v_load(scale + i));
+#endif
+        for (; i < len; i++)
+            dst[i] *= scale[i];
+    }
 
-        size_t outerStep = src.total(axis);
-        size_t cnStep = src.total(axis + 1);
+    static float maxValue(const float *x, int len)
+    {
+        int i = 0;
+        float maxVal = x[0];
+#if CV_SIMD128
+        if (len >= 4)
+        {
+            v_float32x4 vmax = v_load(x);
+            for (i = 4; i <= len - 4; i += 4)
+                vmax = v_max(vmax, v_load(x + i));
+            maxVal = v_reduce_max(vmax);
+        }
+#endif
+        for (; i < len; i++)
+            maxVal = std::max(maxVal, x[i]);
+        return maxVal;
+    }
 
-        //compute max along axis
-        for (size_t outerDim = 0; outerDim < outerSize; outerDim++)
+    static void subtractScalar(const float *x, float y, float *dst, int len)
+    {
+        int i = 0;
+#if CV_SIMD128
+        v_float32x4 vy = v_setall_f32(y);
+        for (; i <= len - 4; i += 4)
+            v_store(dst + i, v_load(x + i) - vy);
+#endif
+        for (; i < len; i++)
+            dst[i] = x[i] - y;
+    }
+
+    static float sumRow(const float *x, int len)
+    {
+        int i = 0;
+        float sum = 0;
+#if CV_SIMD128
+        v_float32x4 vsum = v_setzero_f32();
+        for (; i <= len - 4; i += 4)
+            vsum += v_load(x + i);
+        sum = v_reduce_sum(vsum);
+#endif
+        for (; i < len; i++)
+            sum += x[i];
+        return sum;
+    }
+
+    static void multiplyScalar(float *dst, float scale, int len)
+    {
+        int i = 0;
+#if CV_SIMD128
+        v_float32x4 vscale = v_setall_f32(scale);
+        for (; i <= len - 4; i += 4)
+            v_store(dst + i, v_load(dst + i) * vscale);
+#endif
+        for (; i < len; i++)
+            dst[i] *= scale;
+    }
+
+    /* Online softmax of contiguous vector, i.e. when the axis is the last one.
+     * The first pass reads the source once: exponents of each chunk are computed relatively to the running maximum,
+     * and the sum is rescaled whenever the maximum grows. The second pass only rescales chunks to the global maximum.
+     */
+    static void softmaxContinuous(const float *src, float *dst, int len)
+    {
+        int chunks = (len + softmaxChunk - 1) / softmaxChunk;
+        AutoBuffer<float, 16> chunkMax(chunks);
+
+        float maxVal = src[0], sum = 0;
+        for (int c = 0; c < chunks; c++)
         {
-            size_t srcOffset = outerDim * outerStep;
-            size_t bufOffset = outerDim * cnStep;
+            int start = c * softmaxChunk;
+            int n = std::min(softmaxChunk, len - start);
 
-            memcpy(bufPtr + bufOffset, srcPtr + srcOffset, innerSize * sizeof(float));
+            float newMax = std::max(maxVal, maxValue(src + start, n));
+            sum *= std::exp(maxVal - newMax);
 
-            for (size_t cnDim = 1; cnDim < channels; cnDim++)
-            {
-                for (size_t i = 0; i < innerSize; i++)
-                    bufPtr[bufOffset + i] = std::max(bufPtr[bufOffset + i], srcPtr[srcOffset + cnDim * cnStep + i]);
-            }
+            subtractScalar(src + start, newMax, dst + start, n);
+            Mat dstMat(1, n, CV_32F, dst + start);
+            cv::exp(dstMat, dstMat);
+            sum += sumRow(dst + start, n);
+
+            chunkMax[c] = maxVal = newMax;
         }
 
-        //subtract max
-        for (size_t outerDim = 0; outerDim < outerSize; outerDim++)
+        for (int c = 0; c < chunks; c++)
         {
-            size_t srcOffset = outerDim * outerStep;
-            size_t bufOffset = outerDim * cnStep;
+            int start = c * softmaxChunk;
+            int n = std::min(softmaxChunk, len - start);
+            multiplyScalar(dst + start, std::exp(chunkMax[c] - maxVal) / sum, n);
+        }
+    }
 
-            for (size_t cnDim = 0; cnDim < channels; cnDim++)
-            {
-                for (size_t i = 0; i < innerSize; i++)
-                    dstPtr[srcOffset + cnDim * cnStep + i] = srcPtr[srcOffset + cnDim * cnStep + i] - bufPtr[bufOffset + i];
-            }
+    class SoftMaxLayer::ForwardInvoker : public ParallelLoopBody
+    {
+    public:
+        ForwardInvoker(Blob &src_, Blob &dst_, int axis, int nstripes_)
+            : src(&src_), dst(&dst_), nstripes(nstripes_)
+        {
+            outerSize = src->total(0, axis);
+            channels = src->size(axis);
+            innerSize = src->total(axis + 1);
+            chunksPerRow = (innerSize + softmaxChunk - 1) / softmaxChunk;
         }
 
-        cv::exp(dst.matRef(), dst.matRef());
+        size_t getTilesNum() const
+        {
+            return outerSize * chunksPerRow;
+        }
 
-        for (size_t outerDim = 0; outerDim < outerSize; outerDim++)
+        void operator()(const Range &r) const
         {
-            size_t srcOffset = outerDim * outerStep;
-            size_t bufOffset = outerDim * cnStep;
+            size_t tiles = getTilesNum();
+            size_t tileStart = r.start * tiles / nstripes;
+            size_t tileEnd = r.end * tiles / nstripes;
 
-            //sum exp along axis
-            for (size_t i = 0; i < innerSize; i++)
-                bufPtr[bufOffset + i] = 0.f;
+            AutoBuffer<float> buf(2 * softmaxChunk);
+            float *maxBuf = buf, *sumBuf = maxBuf + softmaxChunk;
 
-            for (size_t cnDim = 0; cnDim < channels; cnDim++)
+            for (size_t tile = tileStart; tile < tileEnd; tile++)
             {
-                for (size_t i = 0; i < innerSize; i++)
-                    bufPtr[bufOffset + i] += dstPtr[srcOffset + cnDim * cnStep + i];
-            }
+                size_t outer = tile / chunksPerRow;
+                size_t start = (tile % chunksPerRow) * softmaxChunk;
+                int len = (int)std::min((size_t)softmaxChunk, innerSize - start);
 
-            //divide by computed sum
-            for (size_t cnDim = 0; cnDim < channels; cnDim++)
-            {
-                for (size_t i = 0; i < innerSize; i++)
-                    dstPtr[srcOffset + cnDim * cnStep + i] /= bufPtr[bufOffset + i];
+                const float *srcPtr = src->ptrf() + outer * channels * innerSize + start;
+                float *dstPtr = dst->ptrf() + outer * channels * innerSize + start;
+
+                if (innerSize == 1)
+                {
+                    softmaxContinuous(srcPtr, dstPtr, (int)channels);
+                    continue;
+                }
+
+                std::copy(srcPtr, srcPtr + len, maxBuf);
+                for (size_t cn = 1; cn < channels; cn++)
+                    maxRow(maxBuf, srcPtr + cn * innerSize, len);
+
+                //subtraction, exponent and summation are fused, so each row is processed while it is hot in cache
+                std::fill(sumBuf, sumBuf + len, 0.f);
+                for (size_t cn = 0; cn < channels; cn++)
+                {
+                    float *dstRow = dstPtr + cn * innerSize;
+                    subtractRow(srcPtr + cn * innerSize, maxBuf, dstRow, len);
+                    Mat dstMat(1, len, CV_32F, dstRow);
+                    cv::exp(dstMat, dstMat);
+                    addRow(sumBuf, dstRow, len);
+                }
+
+                for (int i = 0; i < len; i++)
+                    sumBuf[i] = 1.f / sumBuf[i];
+                for (size_t cn = 0; cn < channels; cn++)
+                    multiplyRow(dstPtr + cn * innerSize, sumBuf, len);
             }
         }
+
+    private:
+        Blob *src, *dst;
+        size_t outerSize, channels, innerSize, chunksPerRow;
+        int nstripes;
+    };
+
+    int64 SoftMaxLayer::getFLOPS(const std::vector<Blob*>&, const std::vector<Blob> &outputs) const
+    {
+        //max, subtraction, exponent, sum and scaling
+        return 5 * (int64)outputs[0].total();
+    }
+
+    void SoftMaxLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
+    {
+        Blob &src = *inputs[0];
+        Blob &dst = outputs[0];
+        CV_Assert(src.type() == CV_32F);
+
+        ForwardInvoker invoker(src, dst, axis, 1);
+        size_t tiles = invoker.getTilesNum();
+        if (tiles == 0)
+            return;
+
+        int nstripes = getParallelStripes(tiles, src.total() / tiles);
+
+        if (nstripes <= 1)
+        {
+            invoker(Range(0, 1));
+            return;
+        }
+
+        parallel_for_(Range(0, nstripes), ForwardInvoker(src, dst, axis, nstripes), nstripes);
     }
 
 }
@@ -50,12 +50,14 @@ namespace dnn
     class SoftMaxLayer : public Layer
     {
         int axis_, axis;
-        Blob maxAggregator;
+
+        class ForwardInvoker;
 
     public:
         SoftMaxLayer(LayerParams &params);
         void allocate(const std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
         void forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
+        int64 getFLOPS(const std::vector<Blob*> &inputs, const std::vector<Blob> &outputs) const;
     };
 }
 }
@@ -0,0 +1,219 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#ifndef __OPENCV_DNN_THREADING_HPP__
+#define __OPENCV_DNN_THREADING_HPP__
+#include "precomp.hpp"
+#include <cmath>
+
+#if defined _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/time.h>
+#endif
+
+namespace cv
+{
+namespace dnn
+{
+
+//mutex with condition variable, cv::Mutex doesn't allow to wait for events
+class Monitor
+{
+public:
+    Monitor()
+    {
+#if defined _WIN32
+        InitializeCriticalSection(&cs);
+        InitializeConditionVariable(&cond);
+#else
+        pthread_mutex_init(&mutex, NULL);
+        pthread_cond_init(&cond, NULL);
+#endif
+    }
+
+    ~Monitor()
+    {
+#if defined _WIN32
+        DeleteCriticalSection(&cs);
+#else
+        pthread_cond_destroy(&cond);
+        pthread_mutex_destroy(&mutex);
+#endif
+    }
+
+    void lock()
+    {
+#if defined _WIN32
+        EnterCriticalSection(&cs);
+#else
+        pthread_mutex_lock(&mutex);
+#endif
+    }
+
+    void unlock()
+    {
+#if defined _WIN32
+        LeaveCriticalSection(&cs);
+#else
+        pthread_mutex_unlock(&mutex);
+#endif
+    }
+
+    //must be called under the lock; waits forever if timeout is negative
+    void wait(double timeoutMs = -1)
+    {
+#if defined _WIN32
+        SleepConditionVariableCS(&cond, &cs, (timeoutMs < 0) ? INFINITE : (DWORD)std::ceil(timeoutMs));
+#else
+        if (timeoutMs < 0)
+        {
+            pthread_cond_wait(&cond, &mutex);
+            return;
+        }
+
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        int64 ns = (int64)now.tv_usec * 1000 + (int64)(timeoutMs * 1e6);
+        struct timespec deadline;
+        deadline.tv_sec = now.tv_sec + (time_t)(ns / 1000000000);
+        deadline.tv_nsec = (long)(ns % 1000000000);
+        pthread_cond_timedwait(&cond, &mutex, &deadline);
+#endif
+    }
+
+    void notifyAll()
+    {
+#if defined _WIN32
+        WakeAllConditionVariable(&cond);
+#else
+        pthread_cond_broadcast(&cond);
+#endif
+    }
+
+private:
+#if defined _WIN32
+    CRITICAL_SECTION cs;
+    CONDITION_VARIABLE cond;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+
+    Monitor(const Monitor&);
+    Monitor& operator=(const Monitor&);
+};
+
+//thread which runs the function, joined by the destructor
+class Thread
+{
+public:
+    typedef void (*Function)(void *arg);
+
+    Thread() : running(false) {}
+
+    ~Thread()
+    {
+        join();
+    }
+
+    void start(Function function, void *arg)
+    {
+        CV_Assert(!running);
+#if defined _WIN32
+        handle = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)entry, new Task(function, arg), 0, NULL);
+        running = (handle != NULL);
+#else
+        running = (pthread_create(&handle, NULL, entry, new Task(function, arg)) == 0);
+#endif
+        if (!running)
+            CV_Error(Error::StsError, "Can't create thread");
+    }
+
+    void join()
+    {
+        if (!running)
+            return;
+#if defined _WIN32
+        WaitForSingleObject(handle, INFINITE);
+        CloseHandle(handle);
+#else
+        pthread_join(handle, NULL);
+#endif
+        running = false;
+    }
+
+private:
+    struct Task
+    {
+        Task(Function f, void *a) : function(f), arg(a) {}
+
+        Function function;
+        void *arg;
+    };
+
+#if defined _WIN32
+    static DWORD WINAPI entry(void *p)
+#else
+    static void *entry(void *p)
+#endif
+    {
+        Task task = *(Task*)p;
+        delete (Task*)p;
+        task.function(task.arg);
+        return 0;
+    }
+
+#if defined _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    bool running;
+
+    Thread(const Thread&);
+    Thread& operator=(const Thread&);
+};
+
+}
+}
+#endif
@@ -6,6 +6,8 @@
 extern "C"
 {
 
+#define THDISKFILE_BUFFER_SIZE (1 << 20)
+
 typedef struct THDiskFile__
 {
     THFile file;
@@ -213,9 +215,47 @@ static void THDiskFile_close(THFile *self)
 
 /* Little and Big Endian */
 
+/* byte swapping of whole words, compilers vectorize these loops */
+static void THDiskFile_reverseMemory16(unsigned short *dst, const unsigned short *src, long n)
+{
+  long i;
+  for(i = 0; i < n; i++)
+    dst[i] = (unsigned short)((src[i] >> 8) | (src[i] << 8));
+}
+
+static inline unsigned int THDiskFile_swap32(unsigned int x)
+{
+  return (x >> 24) | ((x >> 8) & 0x0000ff00u) | ((x << 8) & 0x00ff0000u) | (x << 24);
+}
+
+static void THDiskFile_reverseMemory32(unsigned int *dst, const unsigned int *src, long n)
+{
+  long i;
+  for(i = 0; i < n; i++)
+    dst[i] = THDiskFile_swap32(src[i]);
+}
+
+static void THDiskFile_reverseMemory64(unsigned int *dst, const unsigned int *src, long n)
+{
+  long i;
+  for(i = 0; i < n; i++)
+  {
+    unsigned int lo = src[2*i], hi = src[2*i+1];
+    dst[2*i] = THDiskFile_swap32(hi);
+    dst[2*i+1] = THDiskFile_swap32(lo);
+  }
+}
+
 static void THDiskFile_reverseMemory(void *dst, const void *src, long blockSize, long numBlocks)
 {
-  if(blockSize != 1)
+  /* fast paths for aligned words, src and dst are either the same or don't overlap */
+  if(blockSize == 2 && ((size_t)src | (size_t)dst) % 2 == 0)
+    THDiskFile_reverseMemory16((unsigned short*)dst, (const unsigned short*)src, numBlocks);
+  else if(blockSize == 4 && ((size_t)src | (size_t)dst) % 4 == 0)
+    THDiskFile_reverseMemory32((unsigned int*)dst, (const unsigned int*)src, numBlocks);
+  else if(blockSize == 8 && ((size_t)src | (size_t)dst) % 4 == 0)
+    THDiskFile_reverseMemory64((unsigned int*)dst, (const unsigned int*)src, numBlocks);
+  else if(blockSize != 1)
   {
     long halfBlockSize = blockSize/2;
     char *charSrc = (char*)src;
@@ -488,6 +528,9 @@ THFile *THDiskFile_new(const char *name, const char *mode, int isQuiet)
       THError("cannot open <%s> in mode %c%c", name, (isReadable ? 'r' : ' '), (isWritable ? 'w' : ' '));
   }
 
+  /* serialized objects consist of many small scalars, large buffer saves system calls on them */
+  setvbuf(handle, NULL, _IOFBF, THDISKFILE_BUFFER_SIZE);
+
   self = (THDiskFile*)THAlloc(sizeof(THDiskFile));
 
   self->handle = handle;
@@ -90,6 +90,7 @@ struct TorchImporter : public ::cv::dnn::Importer
     THFile *file;
     std::set<int> readedIndexes;
     std::map<int, Mat> storages;
+    std::map<int, Mat> floatStorages; //storages converted to CV_32F on the first use by a tensor
     std::map<int, Blob> tensors;
 
     struct Module
@@ -265,6 +266,37 @@ struct TorchImporter : public ::cv::dnn::Importer
         storages.insert(std::make_pair(index, storageMat));
     }
 
+    //returns CV_32F version of the storage, conversion is done once for all tensors sharing the storage
+    Mat getFloatStorage(int index)
+    {
+        std::map<int, Mat>::iterator it = floatStorages.find(index);
+        if (it != floatStorages.end())
+            return it->second;
+
+        Mat &storage = storages[index];
+        Mat floatStorage;
+        if (storage.type() == CV_32F)
+            floatStorage = storage;
+        else
+            storage.convertTo(floatStorage, CV_32F);
+
+        floatStorages.insert(std::make_pair(index, floatStorage));
+        return floatStorage;
+    }
+
+    //creates header of continuous array inside of @p storage, which shares reference counter with it
+    static Mat sharedView(const Mat &storage, size_t offset, int ndims, const int *sizes)
+    {
+        Mat view(ndims, sizes, storage.type(), (void*)(storage.ptr() + offset * storage.elemSize()));
+        if (storage.u)
+        {
+            view.allocator = storage.allocator;
+            view.u = storage.u;
+            CV_XADD(&view.u->refcount, 1);
+        }
+        return view;
+    }
+
     void readTorchTable(Dict &scalarParams, std::map<String, Blob> &tensorParams)
     {
         int luaType = readInt();
@@ -370,29 +402,64 @@ struct TorchImporter : public ::cv::dnn::Importer
             readTorchStorage(indexStorage, typeStorage);
         }
 
-        //small check
-        size_t requireElems = (size_t)offset + (size_t)steps[0] * (size_t)sizes[0];
+        //small check, the last element of the tensor must lie inside of the storage
+        size_t requireElems = (size_t)offset + 1;
+        for (int i = 0; i < ndims; i++)
+        {
+            CV_Assert(sizes[i] >= 0 && steps[i] >= 0);
+            if (sizes[i] == 0)
+                requireElems = 0;
+            if (requireElems)
+                requireElems += (size_t)steps[i] * (size_t)(sizes[i] - 1);
+        }
         size_t storageElems = storages[indexStorage].total();
         if (requireElems > storageElems)
             CV_Error(Error::StsBadSize, "Storage has insufficent number of elemements for requested Tensor");
 
         //convert sizes
         AutoBuffer<int, 4> isizes(ndims);
-        AutoBuffer<size_t, 4> ssteps(ndims);
+        bool isContinuous = true;
+        long continuousStep = 1;
         for (int i = ndims - 1; i >= 0; i--)
         {
             isizes[i] = (int)sizes[i];
-            ssteps[i] = (size_t)steps[i] * CV_ELEM_SIZE(typeTensor);
-        }
 
-        //allocate Blob
-        Mat srcMat(ndims, (int*)isizes, typeTensor , storages[indexStorage].ptr() + offset, (size_t*)ssteps);
-        //int dstType = (typeTensor == CV_64F) ? CV_64F : CV_32F;
-        int dstType = CV_32F;
+            if (sizes[i] > 1 && steps[i] != continuousStep)
+                isContinuous = false;
+            continuousStep *= sizes[i];
+        }
 
+        //tensors are views of the storage, so modules sharing a storage share its memory too
+        Mat storage = getFloatStorage(indexStorage);
         Blob blob;
-        blob.create(BlobShape(ndims, isizes), dstType);
-        srcMat.convertTo(blob.matRef(), dstType);
+        if (isContinuous)
+        {
+            blob.fill(sharedView(storage, (size_t)offset, ndims, isizes));
+        }
+        else
+        {
+            //Mat requires the last step to be the element size, so the elements are gathered using all Torch strides
+            blob.create(BlobShape(ndims, isizes), CV_32F);
+            const float *src = storage.ptr<float>() + offset;
+            float *dst = blob.ptrf();
+            size_t total = blob.total();
+
+            AutoBuffer<int, 4> idx(ndims);
+            std::fill((int*)idx, (int*)idx + ndims, 0);
+            size_t srcOfs = 0;
+            for (size_t i = 0; i < total; i++)
+            {
+                dst[i] = src[srcOfs];
+                for (int d = ndims - 1; d >= 0; d--)
+                {
+                    srcOfs += steps[d];
+                    if (++idx[d] < isizes[d])
+                        break;
+                    srcOfs -= (size_t)steps[d] * isizes[d];
+                    idx[d] = 0;
+                }
+            }
+        }
 
         tensors.insert(std::make_pair(indexTensor, blob));
     }
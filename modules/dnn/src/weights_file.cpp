@@ -0,0 +1,340 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "precomp.hpp"
+#include "weights_file.hpp"
+#include <fstream>
+#include <cstring>
+
+#if defined _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace cv
+{
+namespace dnn
+{
+
+static const char weightsFileMagic[8] = { 'O', 'C', 'V', 'D', 'N', 'N', 'W', '1' };
+static const unsigned byteOrderMark = 0x01020304;
+static const size_t dataAlignment = 64;
+
+struct WeightsFile::Mapping
+{
+    const uchar *data;
+    size_t size;
+#if defined _WIN32
+    HANDLE file, mapping;
+#endif
+
+    Mapping(const String &path) : data(NULL), size(0)
+    {
+#if defined _WIN32
+        mapping = NULL;
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            CV_Error(Error::StsError, "Can't open weights file \"" + path + "\"");
+
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(file, &fileSize);
+        size = (size_t)fileSize.QuadPart;
+
+        //copy-on-write mapping, so blobs wrapping it may be modified without changing the file
+        mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (mapping != NULL)
+            data = (const uchar*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            CV_Error(Error::StsError, "Can't open weights file \"" + path + "\"");
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            size = (size_t)st.st_size;
+            //copy-on-write mapping, so blobs wrapping it may be modified without changing the file
+            void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            data = (ptr != MAP_FAILED) ? (const uchar*)ptr : NULL;
+        }
+        ::close(fd); //the mapping keeps the file opened
+#endif
+        if (!data)
+        {
+            release();
+            CV_Error(Error::StsError, "Can't map weights file \"" + path + "\" into memory");
+        }
+    }
+
+    ~Mapping()
+    {
+        release();
+    }
+
+    void release()
+    {
+#if defined _WIN32
+        if (data)
+            UnmapViewOfFile(data);
+        if (mapping != NULL)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data)
+            munmap((void*)data, size);
+#endif
+        data = NULL;
+    }
+};
+
+//Mat allocator which holds reference to the mapping while the Mat headers wrapping it are alive
+class MappedDataAllocator : public MatAllocator
+{
+public:
+    //reallocated blobs don't refer to the mapping anymore
+    UMatData* allocate(int dims, const int *sizes, int type, void *data, size_t *step, int flags, UMatUsageFlags usageFlags) const
+    {
+        return Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(UMatData*, int, UMatUsageFlags) const
+    {
+        return false;
+    }
+
+    void deallocate(UMatData *u) const
+    {
+        if (!u)
+            return;
+
+        CV_Assert(u->urefcount == 0 && u->refcount == 0);
+        delete (Ptr<WeightsFile::Mapping>*)u->userdata;
+        delete u;
+    }
+
+    Mat wrap(const Ptr<WeightsFile::Mapping> &mapping, int dims, const int *sizes, int type, size_t offset) const
+    {
+        Mat m(dims, sizes, type, (void*)(mapping->data + offset));
+
+        UMatData *u = new UMatData(this);
+        u->data = u->origdata = m.data;
+        u->size = m.total() * m.elemSize();
+        u->refcount = 1;
+        u->userdata = new Ptr<WeightsFile::Mapping>(mapping);
+
+        m.allocator = this;
+        m.u = u;
+        return m;
+    }
+};
+
+static MappedDataAllocator mappedDataAllocator;
+
+template<typename T>
+static void writeValue(std::vector<char> &buf, T val)
+{
+    const char *p = (const char*)&val;
+    buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+static inline size_t alignSize_(size_t sz)
+{
+    return (sz + dataAlignment - 1) / dataAlignment * dataAlignment;
+}
+
+void WeightsFile::write(const String &path, const std::map<String, std::vector<Blob> > &layersBlobs)
+{
+    typedef std::map<String, std::vector<Blob> >::const_iterator Iter;
+
+    //the table has fixed size, so offsets of the arrays are known before it's written
+    size_t tableSize = 0;
+    unsigned blobsCount = 0;
+    for (Iter it = layersBlobs.begin(); it != layersBlobs.end(); it++)
+    {
+        for (size_t i = 0; i < it->second.size(); i++)
+        {
+            const Mat &m = it->second[i].matRefConst();
+            tableSize += 5 * sizeof(int) + it->first.size() + m.dims * sizeof(int) + sizeof(uint64);
+            blobsCount++;
+        }
+    }
+
+    std::vector<char> header;
+    header.insert(header.end(), weightsFileMagic, weightsFileMagic + sizeof(weightsFileMagic));
+    writeValue(header, byteOrderMark);
+    writeValue(header, blobsCount);
+
+    size_t offset = alignSize_(header.size() + tableSize);
+    std::vector<const Mat*> arrays;
+    std::vector<size_t> offsets;
+    for (Iter it = layersBlobs.begin(); it != layersBlobs.end(); it++)
+    {
+        for (size_t i = 0; i < it->second.size(); i++)
+        {
+            const Mat &m = it->second[i].matRefConst();
+            CV_Assert(m.isContinuous());
+
+            writeValue(header, (unsigned)it->first.size());
+            header.insert(header.end(), it->first.begin(), it->first.end());
+            writeValue(header, (unsigned)i);
+            writeValue(header, m.type());
+            writeValue(header, m.dims);
+            for (int d = 0; d < m.dims; d++)
+                writeValue(header, m.size[d]);
+            writeValue(header, (uint64)offset);
+
+            arrays.push_back(&m);
+            offsets.push_back(offset);
+            offset = alignSize_(offset + m.total() * m.elemSize());
+        }
+    }
+    CV_Assert(header.size() == sizeof(weightsFileMagic) + 2 * sizeof(unsigned) + tableSize);
+
+    std::ofstream fs(path.c_str(), std::ios::binary);
+    if (!fs.is_open())
+        CV_Error(Error::StsError, "Can't create weights file \"" + path + "\"");
+
+    fs.write(&header[0], header.size());
+    size_t pos = header.size();
+    std::vector<char> padding(dataAlignment, 0);
+    for (size_t i = 0; i < arrays.size(); i++)
+    {
+        fs.write(&padding[0], offsets[i] - pos);
+        size_t bytes = arrays[i]->total() * arrays[i]->elemSize();
+        fs.write((const char*)arrays[i]->data, bytes);
+        pos = offsets[i] + bytes;
+    }
+
+    if (!fs.good())
+        CV_Error(Error::StsError, "Can't write weights file \"" + path + "\"");
+}
+
+bool WeightsFile::isWeightsFile(const String &path)
+{
+    char magic[sizeof(weightsFileMagic)];
+    std::ifstream fs(path.c_str(), std::ios::binary);
+    fs.read(magic, sizeof(magic));
+    return fs.good() && memcmp(magic, weightsFileMagic, sizeof(magic)) == 0;
+}
+
+template<typename T>
+static T readValue(const uchar *data, size_t size, size_t &pos)
+{
+    if (pos + sizeof(T) > size)
+        CV_Error(Error::StsParseError, "Unexpected end of weights file");
+
+    T val;
+    memcpy(&val, data + pos, sizeof(T));
+    pos += sizeof(T);
+    return val;
+}
+
+Ptr<WeightsFile> WeightsFile::open(const String &path)
+{
+    Ptr<WeightsFile> file(new WeightsFile());
+    file->mapping = Ptr<Mapping>(new Mapping(path));
+
+    const uchar *data = file->mapping->data;
+    size_t size = file->mapping->size, pos = 0;
+
+    if (size < sizeof(weightsFileMagic) || memcmp(data, weightsFileMagic, sizeof(weightsFileMagic)) != 0)
+        CV_Error(Error::StsParseError, "\"" + path + "\" isn't native weights file");
+    pos += sizeof(weightsFileMagic);
+
+    if (readValue<unsigned>(data, size, pos) != byteOrderMark)
+        CV_Error(Error::StsParseError, "Weights file \"" + path + "\" was written on the host with another byte order");
+
+    unsigned blobsCount = readValue<unsigned>(data, size, pos);
+    for (unsigned i = 0; i < blobsCount; i++)
+    {
+        unsigned nameLen = readValue<unsigned>(data, size, pos);
+        if (pos + nameLen > size)
+            CV_Error(Error::StsParseError, "Unexpected end of weights file");
+        String name((const char*)data + pos, nameLen);
+        pos += nameLen;
+
+        unsigned blobIndex = readValue<unsigned>(data, size, pos);
+        int type = readValue<int>(data, size, pos);
+        int dims = readValue<int>(data, size, pos);
+        CV_Assert((type == CV_32F || type == CV_64F) && dims > 0 && dims <= CV_MAX_DIM);
+
+        int sizes[CV_MAX_DIM];
+        size_t total = 1;
+        for (int d = 0; d < dims; d++)
+        {
+            sizes[d] = readValue<int>(data, size, pos);
+            //a blob can't have more elements than the file has bytes, so the product doesn't overflow
+            if (sizes[d] < 0 || (sizes[d] > 0 && total > size / sizes[d]))
+                CV_Error(Error::StsParseError, "Corrupted weights file \"" + path + "\"");
+            total *= sizes[d];
+        }
+
+        uint64 offset = readValue<uint64>(data, size, pos);
+        if (offset % dataAlignment != 0 || offset > size || total > (size - (size_t)offset) / CV_ELEM_SIZE(type))
+            CV_Error(Error::StsParseError, "Corrupted weights file \"" + path + "\"");
+
+        std::vector<Blob> &blobs = file->layers[name];
+        if (blobs.size() <= blobIndex)
+            blobs.resize(blobIndex + 1);
+        blobs[blobIndex].fill(mappedDataAllocator.wrap(file->mapping, dims, sizes, type, (size_t)offset));
+    }
+
+    return file;
+}
+
+bool WeightsFile::getBlobs(const String &layerName, std::vector<Blob> &blobs) const
+{
+    std::map<String, std::vector<Blob> >::const_iterator it = layers.find(layerName);
+    if (it == layers.end())
+        return false;
+
+    blobs = it->second;
+    return true;
+}
+
+}
+}
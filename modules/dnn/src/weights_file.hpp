@@ -0,0 +1,83 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#ifndef __OPENCV_DNN_WEIGHTS_FILE_HPP__
+#define __OPENCV_DNN_WEIGHTS_FILE_HPP__
+#include "precomp.hpp"
+#include <map>
+
+namespace cv
+{
+namespace dnn
+{
+
+/* Native container of learned parameters of the net.
+ * Blobs are stored as raw arrays aligned to 64 bytes, so they are used directly from the memory mapped file.
+ * Layout (host byte order, checked by marker):
+ *   "OCVDNNW1", uint32 byteOrderMark, uint32 blobsCount,
+ *   blobsCount table entries: uint32 nameLen, char name[nameLen], uint32 blobIndex, int32 type, int32 dims, int32 sizes[dims], uint64 offset,
+ *   arrays of data at their offsets.
+ */
+class WeightsFile
+{
+public:
+    //! Writes parameters of layers, @p layersBlobs maps layer name to its blobs
+    static void write(const String &path, const std::map<String, std::vector<Blob> > &layersBlobs);
+
+    //! Returns true if the file starts with the signature of native weights file
+    static bool isWeightsFile(const String &path);
+
+    //! Maps the file into memory, the mapping is released when all blobs wrapping it are released
+    static Ptr<WeightsFile> open(const String &path);
+
+    //! Returns blobs wrapping copy-on-write mapped data, or false if the file doesn't contain the layer
+    bool getBlobs(const String &layerName, std::vector<Blob> &blobs) const;
+
+    struct Mapping;
+
+private:
+    Ptr<Mapping> mapping;
+    std::map<String, std::vector<Blob> > layers;
+};
+
+}
+}
+#endif
@@ -77,5 +77,16 @@ TEST(Reproducibility_AlexNet, Accuracy)
     normAssert(ref, out, "prob");
 }
 
+TEST(Reproducibility_AlexNet, Int8)
+{
+    std::vector<Mat> inpMats;
+    inpMats.push_back( imread(_tf("alexnet_0.png")) );
+    inpMats.push_back( imread(_tf("alexnet_1.png")) );
+    ASSERT_TRUE(!inpMats[0].empty() && !inpMats[1].empty());
+
+    Blob ref = blobFromNPY(_tf("alexnet.npy"));
+    checkInt8TopClasses(_tf("bvlc_alexnet.prototxt"), _tf("bvlc_alexnet.caffemodel"), inpMats, ref);
+}
+
 }
 #endif
@@ -62,4 +62,40 @@ inline void normAssert(cv::dnn::Blob &ref, cv::dnn::Blob &test, const char *comm
     normAssert(ref.matRefConst(), test.matRefConst(), comment);
 }
 
+//! Checks that the Caffe classification net quantized to int8 gives the same top-1 classes as the float reference @p ref.
+//! The net is calibrated on the same images it is evaluated on, its input and output are ".data" and "prob".
+inline void checkInt8TopClasses(const cv::String &prototxt, const cv::String &caffemodel,
+                                const std::vector<cv::Mat> &inpMats, cv::dnn::Blob &ref)
+{
+    cv::dnn::Net net;
+    {
+        cv::Ptr<cv::dnn::Importer> importer = cv::dnn::createCaffeImporter(prototxt, caffemodel);
+        ASSERT_TRUE(importer != NULL);
+        importer->populateNet(net);
+    }
+
+    net.setBlob(".data", cv::dnn::Blob(inpMats));
+    net.setCalibration(true);
+    net.forward();
+    net.setCalibration(false);
+
+    net.setQuantization(true);
+    net.forward();
+
+    cv::dnn::Blob out = net.getBlob("prob");
+    ASSERT_EQ(ref.shape(), out.shape());
+
+    for (int n = 0; n < ref.num(); n++)
+    {
+        cv::Mat refProb(1, (int)ref.total(1), CV_32F, ref.ptrf(n));
+        cv::Mat outProb(1, (int)out.total(1), CV_32F, out.ptrf(n));
+
+        cv::Point refClass, outClass;
+        cv::minMaxLoc(refProb, NULL, NULL, NULL, &refClass);
+        cv::minMaxLoc(outProb, NULL, NULL, NULL, &outClass);
+        EXPECT_EQ(refClass.x, outClass.x) << "sample " << n;
+        EXPECT_LE(cvtest::norm(refProb, outProb, cv::NORM_INF), 0.05) << "sample " << n;
+    }
+}
+
 #endif
@@ -77,5 +77,50 @@ TEST(Reproducibility_GoogLeNet, Accuracy)
     normAssert(out, ref);
 }
 
+TEST(Reproducibility_GoogLeNet, MappedWeights)
+{
+    String weightsFile = cv::tempfile(".weights");
+    {
+        Net net;
+        Ptr<Importer> importer = createCaffeImporter(_tf("bvlc_googlenet.prototxt"), _tf("bvlc_googlenet.caffemodel"));
+        ASSERT_TRUE(importer != NULL);
+        importer->populateNet(net);
+        net.writeWeights(weightsFile);
+    }
+
+    Net net;
+    {
+        Ptr<Importer> importer = createCaffeImporter(_tf("bvlc_googlenet.prototxt"), weightsFile);
+        ASSERT_TRUE(importer != NULL);
+        importer->populateNet(net);
+    }
+
+    std::vector<Mat> inpMats;
+    inpMats.push_back( imread(_tf("googlenet_0.jpg")) );
+    inpMats.push_back( imread(_tf("googlenet_1.jpg")) );
+    ASSERT_TRUE(!inpMats[0].empty() && !inpMats[1].empty());
+
+    net.setBlob(".data", Blob(inpMats));
+    net.forward();
+
+    Blob out = net.getBlob("prob");
+    Blob ref = blobFromNPY(_tf("googlenet_prob.npy"));
+    normAssert(out, ref);
+
+    net = Net(); //unmaps the file
+    remove(weightsFile.c_str());
+}
+
+TEST(Reproducibility_GoogLeNet, Int8)
+{
+    std::vector<Mat> inpMats;
+    inpMats.push_back( imread(_tf("googlenet_0.jpg")) );
+    inpMats.push_back( imread(_tf("googlenet_1.jpg")) );
+    ASSERT_TRUE(!inpMats[0].empty() && !inpMats[1].empty());
+
+    Blob ref = blobFromNPY(_tf("googlenet_prob.npy"));
+    checkInt8TopClasses(_tf("bvlc_googlenet.prototxt"), _tf("bvlc_googlenet.caffemodel"), inpMats, ref);
+}
+
 }
 #endif
@@ -42,6 +42,8 @@
 #include "test_precomp.hpp"
 #include <opencv2/core/ocl.hpp>
 #include <iostream>
+#include <fstream>
+#include <iterator>
 #include "npy_blob.hpp"
 #include <opencv2/dnn/all_layers.hpp>
 
@@ -87,6 +89,56 @@ TEST(Layer_Test_Softmax, Accuracy)
      testLayer("layer_softmax");
 }
 
+static void softmaxReference(const Mat &src, Mat &dst, int channels, int innerSize)
+{
+    dst.create(src.size(), CV_32F);
+    int outerSize = (int)(src.total() / (channels * innerSize));
+    for (int o = 0; o < outerSize; o++)
+    {
+        for (int j = 0; j < innerSize; j++)
+        {
+            const float *x = src.ptr<float>() + o * channels * innerSize + j;
+            float *y = dst.ptr<float>() + o * channels * innerSize + j;
+
+            double maxVal = x[0], sum = 0;
+            for (int c = 1; c < channels; c++)
+                maxVal = std::max(maxVal, (double)x[c * innerSize]);
+            for (int c = 0; c < channels; c++)
+                sum += std::exp(x[c * innerSize] - maxVal);
+            for (int c = 0; c < channels; c++)
+                y[c * innerSize] = (float)(std::exp(x[c * innerSize] - maxVal) / sum);
+        }
+    }
+}
+
+//rows longer than the chunk of the layer, the maximum grows from chunk to chunk
+TEST(Layer_Test_Softmax, LongRows)
+{
+    const int len = 3000;
+    BlobShape shapes[] = { BlobShape(2, len), BlobShape(2, 5, len) };
+    for (int t = 0; t < 2; t++)
+    {
+        bool continuous = (t == 0);
+        Blob input(shapes[t]);
+        RNG rng(0);
+        rng.fill(input.matRef(), RNG::UNIFORM, -1, 1);
+        Mat inpMat = input.matRef().reshape(1, 1);
+        for (int i = 0; i < (int)inpMat.total(); i++)
+            inpMat.at<float>(i) += 0.01f * (i % len);
+
+        LayerParams params;
+        Net net;
+        net.connect(0, 0, net.addLayer("output", "Softmax", params), 0);
+        net.setBlob(".0", input);
+        net.forward();
+        Blob out = net.getBlob("output");
+
+        Mat ref;
+        softmaxReference(input.matRefConst(), ref, continuous ? len : 5, continuous ? 1 : len);
+        normAssert(ref.reshape(1, 1), out.matRefConst().reshape(1, 1), continuous ? "continuous" : "strided");
+    }
+}
+
 TEST(Layer_Test_LRN_spatial, Accuracy)
 {
      testLayer("layer_lrn_spatial");
@@ -113,6 +165,84 @@ TEST(Layer_Test_Convolution, AccuracyOCL)
     }
 }
 
+static void forwardConvolution(const Blob &inp, const Blob &wgt, const Blob &bias, int pad, int stride,
+                               const String &algo, Blob &out)
+{
+    LayerParams lp;
+    lp.set("num_output", wgt.num());
+    lp.set("kernel_size", wgt.cols());
+    lp.set("pad", pad);
+    lp.set("stride", stride);
+    lp.set("conv_algorithm", algo);
+    lp.blobs.push_back(wgt);
+    lp.blobs.push_back(bias);
+
+    Blob inpCopy = inp;
+    std::vector<Blob*> inpVec(1, &inpCopy);
+    std::vector<Blob> outVec;
+
+    Ptr<Layer> layer = LayerFactory::createLayerInstance("Convolution", lp);
+    layer->allocate(inpVec, outVec);
+    layer->forward(inpVec, outVec);
+    out = outVec[0];
+}
+
+TEST(Layer_Test_Convolution, Algorithms)
+{
+    RNG rng(0);
+    int params[][4] = { {3, 16, 1, 1}, {3, 3, 0, 1}, {5, 2, 2, 2} }; //kernel size, input channels, pad, stride
+
+    for (size_t i = 0; i < sizeof(params) / sizeof(params[0]); i++)
+    {
+        int ksz = params[i][0], inpCn = params[i][1], pad = params[i][2], stride = params[i][3];
+
+        Blob inp(BlobShape(2, inpCn, 13, 10));
+        Blob wgt(BlobShape(8, inpCn, ksz, ksz)), bias(BlobShape(8, 1, 1, 1));
+        rng.fill(inp.matRef(), RNG::UNIFORM, -1, 1);
+        rng.fill(wgt.matRef(), RNG::UNIFORM, -1, 1);
+        rng.fill(bias.matRef(), RNG::UNIFORM, -1, 1);
+
+        Blob ref, out;
+        forwardConvolution(inp, wgt, bias, pad, stride, "im2col", ref);
+
+        forwardConvolution(inp, wgt, bias, pad, stride, "winograd", out);
+        normAssert(ref, out, "winograd");
+
+        forwardConvolution(inp, wgt, bias, pad, stride, "direct", out);
+        normAssert(ref, out, "direct");
+    }
+}
+
+TEST(Layer_Test_Convolution, Batch)
+{
+    RNG rng(0);
+    const int batchSize = 7;
+
+    Blob inp(BlobShape(batchSize, 16, 9, 8));
+    Blob wgt(BlobShape(8, 16, 3, 3)), bias(BlobShape(8, 1, 1, 1));
+    rng.fill(inp.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(wgt.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(bias.matRef(), RNG::UNIFORM, -1, 1);
+
+    const char *algos[] = { "im2col", "winograd", "direct" };
+    for (size_t i = 0; i < sizeof(algos) / sizeof(algos[0]); i++)
+    {
+        Blob out;
+        forwardConvolution(inp, wgt, bias, 1, 1, algos[i], out);
+
+        //images of the batch are processed in parallel, compare them with separately computed ones
+        for (int n = 0; n < batchSize; n++)
+        {
+            Blob image, ref;
+            image.fill(BlobShape(1, 16, 9, 8), CV_32F, inp.ptrf(n));
+            forwardConvolution(image, wgt, bias, 1, 1, algos[i], ref);
+
+            Mat outImage(1, (int)out.total(1), CV_32F, out.ptrf(n));
+            normAssert(Mat(1, (int)ref.total(), CV_32F, ref.ptrf()), outImage, algos[i]);
+        }
+    }
+}
+
 TEST(Layer_Test_InnerProduct, Accuracy)
 {
      testLayer("layer_inner_product", true);
@@ -128,6 +258,56 @@ TEST(Layer_Test_Pooling_ave, Accuracy)
      testLayer("layer_pooling_ave");
 }
 
+//straightforward Caffe pooling with 3x3 kernel, stride 2 and padding 1
+static void poolingReference(Blob &inp, Blob &out, bool isMax)
+{
+    const int k = 3, stride = 2, pad = 1;
+    int inpH = inp.rows(), inpW = inp.cols();
+    for (int n = 0; n < out.num(); n++)
+    for (int c = 0; c < out.channels(); c++)
+    for (int y = 0; y < out.rows(); y++)
+    for (int x = 0; x < out.cols(); x++)
+    {
+        int y0 = y * stride - pad, x0 = x * stride - pad;
+        int poolSize = (std::min(y0 + k, inpH + pad) - y0) * (std::min(x0 + k, inpW + pad) - x0);
+        float res = isMax ? -FLT_MAX : 0.f;
+        for (int i = std::max(y0, 0); i < std::min(y0 + k, inpH); i++)
+        for (int j = std::max(x0, 0); j < std::min(x0 + k, inpW); j++)
+        {
+            float v = inp.ptrf(n, c, i)[j];
+            res = isMax ? std::max(res, v) : res + v;
+        }
+        out.ptrf(n, c, y)[x] = isMax ? res : res / poolSize;
+    }
+}
+
+TEST(Layer_Test_Pooling, Stride2)
+{
+    Blob inp(BlobShape(2, 5, 17, 23));
+    RNG rng(0);
+    rng.fill(inp.matRef(), RNG::UNIFORM, -1, 1);
+
+    const char *pools[] = { "max", "ave" };
+    for (int i = 0; i < 2; i++)
+    {
+        LayerParams lp;
+        lp.set("pool", pools[i]);
+        lp.set("kernel_size", 3);
+        lp.set("stride", 2);
+        lp.set("pad", 1);
+        Ptr<Layer> layer = LayerFactory::createLayerInstance("Pooling", lp);
+
+        std::vector<Blob*> inputs(1, &inp);
+        std::vector<Blob> outputs;
+        layer->allocate(inputs, outputs);
+        layer->forward(inputs, outputs);
+
+        Blob ref(outputs[0].shape());
+        poolingReference(inp, ref, i == 0);
+        normAssert(ref, outputs[0], pools[i]);
+    }
+}
+
 TEST(Layer_Test_DeConvolution, Accuracy)
 {
      testLayer("layer_deconvolution", true, false);
@@ -175,6 +355,438 @@ TEST(Layer_Test_Reshape_Split_Slice, Accuracy)
     normAssert(input, output);
 }
 
+//creates ReLU -> (TanH, Sigmoid) -> Concat net
+static void createBranchyNet(Net &net)
+{
+    LayerParams lp;
+    lp.set("axis", 1);
+
+    int reluId = net.addLayer("relu", "ReLU", lp);
+    int tanhId = net.addLayer("tanh", "TanH", lp);
+    int sigmId = net.addLayer("sigmoid", "Sigmoid", lp);
+    int concatId = net.addLayer("output", "Concat", lp);
+
+    net.connect(0, 0, reluId, 0);
+    net.connect(reluId, 0, tanhId, 0);
+    net.connect(reluId, 0, sigmId, 0);
+    net.connect(tanhId, 0, concatId, 0);
+    net.connect(sigmId, 0, concatId, 1);
+}
+
+static Blob forwardBranchyNet(const Blob &input, bool reuseBlobs, bool inPlaceLayers, int maxConcurrentLayers = 1)
+{
+    Net net;
+    createBranchyNet(net);
+    net.setMemoryReuse(reuseBlobs, inPlaceLayers);
+    net.setMaxConcurrentLayers(maxConcurrentLayers);
+    net.setBlob(".0", input);
+    net.forward();
+    return net.getBlob("output");
+}
+
+TEST(Layer_Test_MemoryReuse, Accuracy)
+{
+    Blob input(BlobShape(2, 3, 4, 5));
+    RNG rng(0);
+    rng.fill(input.matRef(), RNG::UNIFORM, -1, 1);
+
+    Blob ref(BlobShape(2, 6, 4, 5));
+    for (int n = 0; n < 2; n++)
+    {
+        for (int cn = 0; cn < 3; cn++)
+        {
+            Mat relu = cv::max(input.getPlane(n, cn), 0);
+            Mat expNeg;
+            cv::exp(-relu, expNeg);
+
+            for (int i = 0; i < 4 * 5; i++)
+            {
+                float x = relu.ptr<float>()[i];
+                ref.ptrf(n, cn)[i] = std::tanh(x);
+                ref.ptrf(n, cn + 3)[i] = 1.f / (1.f + expNeg.ptr<float>()[i]);
+            }
+        }
+    }
+
+    Blob out = forwardBranchyNet(input, false, false);
+    normAssert(ref, out, "without reuse");
+
+    out = forwardBranchyNet(input, false, true);
+    normAssert(ref, out, "in-place without reuse");
+
+    out = forwardBranchyNet(input, true, false);
+    normAssert(ref, out, "with reuse");
+
+    out = forwardBranchyNet(input, true, true);
+    normAssert(ref, out, "in-place");
+
+    out = forwardBranchyNet(input, true, true, 4);
+    normAssert(ref, out, "concurrent layers");
+}
+
+static int getLayerCalls(Net &net, const String &name)
+{
+    std::vector<LayerProfile> profile;
+    net.getProfile(profile);
+    for (size_t i = 0; i < profile.size(); i++)
+    {
+        if (profile[i].name == name)
+            return profile[i].calls;
+    }
+    return -1;
+}
+
+TEST(Layer_Test_Net, PartialForward)
+{
+    Blob input(BlobShape(2, 3, 4, 5));
+    RNG rng(0);
+    rng.fill(input.matRef(), RNG::UNIFORM, -1, 1);
+
+    Mat tanhRef;
+    cv::max(input.matRefConst(), 0, tanhRef);
+    for (size_t i = 0; i < tanhRef.total(); i++)
+        tanhRef.ptr<float>()[i] = std::tanh(tanhRef.ptr<float>()[i]);
+
+    Net net;
+    createBranchyNet(net);
+    net.setProfiling(true);
+    net.setBlob(".0", input);
+
+    //only the ancestors of the requested layer are computed
+    net.forward("tanh");
+    EXPECT_EQ(1, getLayerCalls(net, "relu"));
+    EXPECT_EQ(1, getLayerCalls(net, "tanh"));
+    EXPECT_EQ(0, getLayerCalls(net, "sigmoid"));
+    EXPECT_EQ(0, getLayerCalls(net, "output"));
+    normAssert(tanhRef, net.getBlob("tanh").matRefConst());
+
+    net.forward();
+    EXPECT_EQ(2, getLayerCalls(net, "relu"));
+    EXPECT_EQ(2, getLayerCalls(net, "tanh"));
+    EXPECT_EQ(1, getLayerCalls(net, "sigmoid"));
+    EXPECT_EQ(1, getLayerCalls(net, "output"));
+    Blob ref = forwardBranchyNet(input, false, true), out = net.getBlob("output");
+    normAssert(ref, out);
+    normAssert(tanhRef, net.getBlob("tanh").matRefConst(), "tanh after full pass");
+}
+
+//creates Convolution -> ReLU -> InnerProduct -> TanH net
+static void createConvFcNet(Net &net, const Blob &input, const String &convAlgo)
+{
+    RNG rng(0);
+    Blob convWgt(BlobShape(16, input.channels(), 3, 3)), convBias(BlobShape(16, 1, 1, 1));
+    Blob fcWgt(BlobShape(10, 16 * input.rows() * input.cols())), fcBias(BlobShape(1, 10));
+    rng.fill(convWgt.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(convBias.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(fcWgt.matRef(), RNG::UNIFORM, -0.1, 0.1);
+    rng.fill(fcBias.matRef(), RNG::UNIFORM, -1, 1);
+
+    LayerParams convParams, fcParams, activParams;
+    convParams.set("num_output", 16);
+    convParams.set("kernel_size", 3);
+    convParams.set("pad", 1);
+    convParams.set("conv_algorithm", convAlgo);
+    convParams.blobs.push_back(convWgt);
+    convParams.blobs.push_back(convBias);
+    fcParams.set("num_output", 10);
+    fcParams.blobs.push_back(fcWgt);
+    fcParams.blobs.push_back(fcBias);
+
+    int convId = net.addLayer("conv", "Convolution", convParams);
+    int reluId = net.addLayer("relu", "ReLU", activParams);
+    int fcId = net.addLayer("fc", "InnerProduct", fcParams);
+    int tanhId = net.addLayer("output", "TanH", activParams);
+
+    net.connect(0, 0, convId, 0);
+    net.connect(convId, 0, reluId, 0);
+    net.connect(reluId, 0, fcId, 0);
+    net.connect(fcId, 0, tanhId, 0);
+}
+
+static Blob forwardFusableNet(const Blob &input, const String &convAlgo, bool fusion)
+{
+    Net net;
+    createConvFcNet(net, input, convAlgo);
+
+    net.setLayersFusion(fusion);
+    net.setBlob(".0", input);
+    net.forward();
+    return net.getBlob("output");
+}
+
+TEST(Layer_Test_Fusion, Accuracy)
+{
+    Blob input(BlobShape(2, 16, 6, 7));
+    RNG rng(0);
+    rng.fill(input.matRef(), RNG::UNIFORM, -1, 1);
+
+    const char *algos[] = { "im2col", "winograd", "direct" };
+    for (size_t i = 0; i < sizeof(algos) / sizeof(algos[0]); i++)
+    {
+        Blob ref = forwardFusableNet(input, algos[i], false);
+        Blob out = forwardFusableNet(input, algos[i], true);
+        normAssert(ref, out, algos[i]);
+    }
+}
+
+TEST(Layer_Test_Net, MappedWeights)
+{
+    Blob input(BlobShape(2, 16, 6, 7));
+    RNG rng(0);
+    rng.fill(input.matRef(), RNG::UNIFORM, -1, 1);
+
+    String weightsFile = cv::tempfile(".weights");
+    Mat ref;
+    {
+        Net net;
+        createConvFcNet(net, input, "auto");
+        net.writeWeights(weightsFile);
+
+        net.setBlob(".0", input);
+        net.forward();
+        ref = net.getBlob("output").matRef().clone();
+    }
+
+    {
+        Net net;
+        createConvFcNet(net, input, "auto");
+        net.readWeights(weightsFile);
+
+        net.setBlob(".0", input);
+        net.forward();
+        normAssert(ref, net.getBlob("output").matRef());
+
+        //pages are mapped copy-on-write, so mapped blobs can be modified without changing the file
+        Mat fcWgt = net.getParam("fc", 0).matRef();
+        fcWgt.setTo(0);
+    }
+
+    {
+        Net net;
+        createConvFcNet(net, input, "auto");
+        net.readWeights(weightsFile);
+
+        net.setBlob(".0", input);
+        net.forward();
+        normAssert(ref, net.getBlob("output").matRef(), "file is unchanged");
+    }
+
+    remove(weightsFile.c_str());
+}
+
+class InferenceQueueBody : public ParallelLoopBody
+{
+public:
+    InferenceQueueBody(InferenceQueue *_queue, Blob *_input, Mat *_output, std::vector<int> *_outputNums)
+        : queue(_queue), input(_input), output(_output), outputNums(_outputNums) {}
+
+    //gtest assertions aren't reliable outside of the main thread, so results are checked by the caller
+    void operator()(const Range &r) const
+    {
+        for (int i = r.start; i < r.end; i++)
+        {
+            Blob sample;
+            sample.fill(BlobShape(1, input->channels(), input->rows(), input->cols()), CV_32F, input->ptrf(i), false);
+
+            Blob out = queue->process(sample);
+            (*outputNums)[i] = out.num();
+            if (out.num() != 1)
+                continue;
+            Mat dst = output->row(i);
+            out.matRefConst().reshape(1, 1).copyTo(dst);
+        }
+    }
+
+private:
+    InferenceQueue *queue;
+    Blob *input;
+    Mat *output;
+    std::vector<int> *outputNums;
+};
+
+TEST(Layer_Test_Net, InferenceQueue)
+{
+    const int numSamples = 12;
+    Blob input(BlobShape(numSamples, 16, 6, 7));
+    RNG rng(0);
+    rng.fill(input.matRef(), RNG::UNIFORM, -1, 1);
+
+    Net net;
+    createConvFcNet(net, input, "auto");
+    net.setBlob(".0", input);
+    net.forward();
+    Mat ref = net.getBlob("output").matRef().clone();
+
+    InferenceQueue queue(net, ".0", "output", 2, 4, 5.);
+    Mat out(numSamples, 10, CV_32F, Scalar(0));
+    std::vector<int> outputNums(numSamples, 0);
+    parallel_for_(Range(0, numSamples), InferenceQueueBody(&queue, &input, &out, &outputNums), numSamples);
+    for (int i = 0; i < numSamples; i++)
+        ASSERT_EQ(1, outputNums[i]) << "sample " << i;
+    normAssert(ref, out);
+
+    //the prototype network is untouched
+    normAssert(ref, net.getBlob("output").matRef(), "prototype");
+}
+
+TEST(Layer_Test_Net, AsyncForward)
+{
+    const int numFrames = 5;
+    Net net;
+    Blob input(BlobShape(1, 3, 6, 7));
+    createConvFcNet(net, input, "auto");
+
+    RNG rng(0);
+    std::vector<Mat> frames(numFrames), refs(numFrames);
+    for (int i = 0; i < numFrames; i++)
+    {
+        frames[i].create(6, 7, CV_8UC3);
+        rng.fill(frames[i], RNG::UNIFORM, 0, 256);
+
+        net.setBlob(".0", Blob(frames[i]));
+        net.forward();
+        refs[i] = net.getBlob("output").matRef().clone();
+    }
+
+    AsyncForward stream(net, ".0", "output", 2);
+    std::vector<AsyncForward::Future> futures;
+    for (int i = 0; i < numFrames; i++)
+    {
+        if (i % 2)
+            futures.push_back(stream.forward(frames[i]));
+        else
+            futures.push_back(stream.forward(Blob(frames[i])));
+    }
+
+    //results are ready in the order of submission
+    for (int i = numFrames - 1; i >= 0; i--)
+    {
+        Blob out = futures[i].get();
+        for (int j = 0; j < i; j++)
+            EXPECT_TRUE(futures[j].ready());
+        normAssert(refs[i], out.matRefConst());
+    }
+
+    //errors are rethrown to the caller
+    AsyncForward::Future failed = stream.forward(Blob(BlobShape(1, 5, 6, 7)));
+    EXPECT_ANY_THROW(failed.get());
+}
+
+TEST(Layer_Test_Net, Profiling)
+{
+    Blob input(BlobShape(2, 16, 6, 7));
+    RNG rng(0);
+    rng.fill(input.matRef(), RNG::UNIFORM, -1, 1);
+
+    Net net;
+    createConvFcNet(net, input, "auto");
+    net.setBlob(".0", input);
+    net.setProfiling(true);
+    net.forward();
+    net.forward();
+    net.setProfiling(false);
+    net.forward();
+
+    std::vector<LayerProfile> profile;
+    net.getProfile(profile);
+    ASSERT_EQ(profile.size(), 4U);
+
+    //Convolution -> ReLU -> InnerProduct -> TanH, activations are fused
+    EXPECT_EQ(profile[0].name, "conv");
+    EXPECT_EQ(profile[0].calls, 2);
+    EXPECT_GE(profile[0].time, 0.);
+    EXPECT_EQ(profile[0].flops, 2 * (int64)(2 * 16 * 6 * 7) * (16 * 3 * 3));
+    EXPECT_EQ(profile[0].outputBytes, 2 * 16 * 6 * 7 * sizeof(float));
+    EXPECT_EQ(profile[1].calls, 0);
+    EXPECT_EQ(profile[2].calls, 2);
+    EXPECT_EQ(profile[2].flops, 2 * (int64)(2 * 10) * (16 * 6 * 7));
+
+    String traceFile = cv::tempfile(".json");
+    net.writeProfileTrace(traceFile);
+    std::ifstream trace(traceFile.c_str());
+    std::string content((std::istreambuf_iterator<char>(trace)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(content.find("{\"traceEvents\":["), 0U);
+    EXPECT_NE(content.find("\"name\":\"fc\""), std::string::npos);
+    trace.close();
+    remove(traceFile.c_str());
+}
+
+TEST(Layer_Test_Quantization, Accuracy)
+{
+    Blob input(BlobShape(2, 16, 6, 7));
+    RNG rng(0);
+    rng.fill(input.matRef(), RNG::UNIFORM, -1, 1);
+
+    Net net;
+    createConvFcNet(net, input, "auto");
+    net.setBlob(".0", input);
+    net.forward();
+    Mat ref = net.getBlob("output").matRef().clone();
+
+    net.setCalibration(true);
+    net.forward();
+    net.setCalibration(false);
+
+    net.setQuantization(true);
+    net.forward();
+    Mat out = net.getBlob("output").matRef().clone();
+    EXPECT_LE(cvtest::norm(ref, out, NORM_INF), 0.02 * cvtest::norm(ref, NORM_INF));
+
+    net.setQuantization(false);
+    net.forward();
+    normAssert(ref, net.getBlob("output").matRef(), "float restored");
+}
+
+TEST(Layer_Test_Quantization, ReadWeights)
+{
+    Blob input(BlobShape(2, 16, 6, 7));
+    RNG rng(0);
+    rng.fill(input.matRef(), RNG::UNIFORM, -1, 1);
+
+    //other weights with the same ranges of layer inputs: permuted convolution filters and negated FC weights
+    String weightsFile = cv::tempfile(".weights");
+    Mat ref;
+    {
+        Net net;
+        createConvFcNet(net, input, "auto");
+        net.setBlob(".0", input);
+        net.forward();
+
+        Mat convWgt = net.getParam("conv", 0).matRef().reshape(1, 16);
+        Mat convBias = net.getParam("conv", 1).matRef().reshape(1, 16);
+        Mat fcWgt = net.getParam("fc", 0).matRef();
+        flip(convWgt.clone(), convWgt, 0);
+        flip(convBias.clone(), convBias, 0);
+        fcWgt *= -1;
+        net.writeWeights(weightsFile);
+    }
+    {
+        Net net;
+        createConvFcNet(net, input, "auto");
+        net.readWeights(weightsFile);
+        net.setBlob(".0", input);
+        net.forward();
+        ref = net.getBlob("output").matRef().clone();
+    }
+
+    Net net;
+    createConvFcNet(net, input, "auto");
+    net.setBlob(".0", input);
+    net.setCalibration(true);
+    net.forward();
+    net.setCalibration(false);
+    net.setQuantization(true);
+    net.forward();
+
+    //int8 weights must be computed from the new weights
+    net.readWeights(weightsFile);
+    net.forward();
+    Mat out = net.getBlob("output").matRef();
+    EXPECT_LE(cvtest::norm(ref, out, NORM_INF), 0.02 * cvtest::norm(ref, NORM_INF));
+
+    remove(weightsFile.c_str());
+}
+
 class Layer_LSTM_Test : public ::testing::Test
 {
 public:
@@ -232,6 +844,59 @@ TEST_F(Layer_LSTM_Test, BasicTest_2)
 }
 
 
+static Mat sigmoid(const Mat &x)
+{
+    Mat e;
+    cv::exp(-x, e);
+    return 1 / (1 + e);
+}
+
+TEST_F(Layer_LSTM_Test, Timestamps)
+{
+    const int T = 5, N = 3;
+    randu(Wh.matRef(), -0.5, 0.5);
+    randu(Wx.matRef(), -0.5, 0.5);
+    randu(b.matRef(), -0.5, 0.5);
+    layer->setWeights(Wh, Wx, b);
+
+    Blob inp(BlobShape(T, N, Nx));
+    randu(inp.matRef(), -1, 1);
+    inputs.push_back(inp);
+    layer->setUseTimestampsDim();
+    allocateAndForward();
+
+    ASSERT_EQ(outputs.size(), 2);
+    EXPECT_EQ(outputs[0].shape(), BlobShape(T, N, Nc));
+    EXPECT_EQ(outputs[1].shape(), BlobShape(T, N, Nc));
+
+    //the first step is checked against the definition
+    Mat x0(N, Nx, CV_32F, inp.ptrf(0));
+    Mat gates = x0 * Wx.matRefConst().t() + repeat(b.matRefConst().t(), N, 1);
+    Mat c = sigmoid(gates.colRange(0, Nc)).mul(2*sigmoid(2*gates.colRange(3*Nc, 4*Nc)) - 1);
+    Mat h = sigmoid(gates.colRange(2*Nc, 3*Nc)).mul(2*sigmoid(2*c) - 1);
+    normAssert(h, Mat(N, Nc, CV_32F, outputs[0].ptrf(0)), "h_0");
+    normAssert(c, Mat(N, Nc, CV_32F, outputs[1].ptrf(0)), "c_0");
+
+    //the whole sequence must be the same as one made by separate steps
+    Ptr<LSTMLayer> stepLayer = LSTMLayer::create();
+    stepLayer->setWeights(Wh, Wx, b);
+
+    Blob xt(BlobShape(N, Nx));
+    std::vector<Blob*> stepInputs(1, &xt);
+    std::vector<Blob> stepOutputs;
+    stepLayer->allocate(stepInputs, stepOutputs);
+
+    for (int t = 0; t < T; t++)
+    {
+        Mat xtMat(N, Nx, CV_32F, xt.ptrf());
+        Mat(N, Nx, CV_32F, inp.ptrf(t)).copyTo(xtMat);
+        stepLayer->forward(stepInputs, stepOutputs);
+
+        normAssert(stepOutputs[0].matRefConst(), Mat(N, Nc, CV_32F, outputs[0].ptrf(t)), "h_t");
+        normAssert(stepOutputs[1].matRefConst(), Mat(N, Nc, CV_32F, outputs[1].ptrf(t)), "c_t");
+    }
+}
+
 class Layer_RNN_Test : public ::testing::Test
 {
 public:
@@ -290,4 +955,42 @@ TEST_F(Layer_RNN_Test, BasicTest_2)
     EXPECT_EQ(outputs[1].shape(), BlobShape(1, 2, 3, Nh));
 }
 
+TEST_F(Layer_RNN_Test, Timestamps)
+{
+    const int T = 4, N = 5;
+    randu(Whh.matRef(), -0.5, 0.5);
+    randu(Wxh.matRef(), -0.5, 0.5);
+    randu(bh.matRef(), -0.5, 0.5);
+    randu(Who.matRef(), -0.5, 0.5);
+    randu(bo.matRef(), -0.5, 0.5);
+    layer->setWeights(Whh, Wxh, bh, Who, bo);
+
+    Blob inp(BlobShape(T, N, Nx));
+    randu(inp.matRef(), -1, 1);
+    inputs.push_back(inp);
+    layer->setUseTimestampsDim();
+    allocateAndForward();
+
+    ASSERT_EQ(outputs.size(), 2);
+    EXPECT_EQ(outputs[0].shape(), BlobShape(T, N, No));
+    EXPECT_EQ(outputs[1].shape(), BlobShape(T, N, Nh));
+
+    Mat hPrev = Mat::zeros(N, Nh, CV_32F);
+    for (int t = 0; t < T; t++)
+    {
+        Mat xt(N, Nx, CV_32F, inp.ptrf(t));
+        Mat a = hPrev * Whh.matRefConst().t() + xt * Wxh.matRefConst().t() + repeat(bh.matRefConst().t(), N, 1);
+        Mat e, h, o;
+        cv::exp(-2*a, e);
+        h = 2 / (1 + e) - 1;
+        a = h * Who.matRefConst().t() + repeat(bo.matRefConst().t(), N, 1);
+        cv::exp(-2*a, e);
+        o = 2 / (1 + e) - 1;
+
+        normAssert(h, Mat(N, Nh, CV_32F, outputs[1].ptrf(t)), "h_t");
+        normAssert(o, Mat(N, No, CV_32F, outputs[0].ptrf(t)), "o_t");
+        hPrev = h;
+    }
+}
+
 }
@@ -28,4 +28,69 @@ TEST(BlobShape_EmptyFill, Regression)
     EXPECT_EQ(s.dims(), 10);
 }
 
+TEST(Blob_FromImages, Accuracy)
+{
+    RNG rng(0);
+    std::vector<Mat> images(2);
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        images[i].create(17, 23, CV_8UC3);
+        rng.fill(images[i], RNG::UNIFORM, 0, 256);
+    }
+
+    Blob blob(images);
+    ASSERT_TRUE(blob.shape() == BlobShape(2, 3, 17, 23));
+    for (int n = 0; n < 2; n++)
+    {
+        std::vector<Mat> planes;
+        split(images[n], planes);
+        for (int c = 0; c < 3; c++)
+        {
+            Mat ref;
+            planes[c].convertTo(ref, CV_32F);
+            normAssert(ref, blob.getPlane(n, c));
+        }
+    }
+}
+
+TEST(Blob_BatchFromImages, Accuracy)
+{
+    RNG rng(0);
+    std::vector<Mat> images(2);
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        images[i].create(17, 23, CV_8UC3);
+        rng.fill(images[i], RNG::UNIFORM, 0, 256);
+    }
+
+    Size size(31, 12);
+    Scalar mean(104, 117, 123);
+    double scale = 0.017;
+
+    Blob blob;
+    blob.batchFromImages(images, size, mean, scale, true);
+    ASSERT_TRUE(blob.shape() == BlobShape(2, 3, 12, 31));
+
+    for (int n = 0; n < 2; n++)
+    {
+        Mat img;
+        images[n].convertTo(img, CV_32F);
+        resize(img, img, size, 0, 0, INTER_LINEAR);
+        cvtColor(img, img, COLOR_BGR2RGB);
+
+        std::vector<Mat> planes;
+        split(img, planes);
+        for (int c = 0; c < 3; c++)
+        {
+            Mat ref = (planes[c] - mean[c]) * scale;
+            normAssert(ref, blob.getPlane(n, c));
+        }
+    }
+
+    //the blob is filled in place if its shape doesn't change
+    const float *data = blob.ptrf();
+    blob.batchFromImages(images, size, mean, scale, true);
+    EXPECT_EQ(data, blob.ptrf());
+}
+
 }
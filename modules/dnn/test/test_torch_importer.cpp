@@ -42,6 +42,7 @@
 #if defined(ENABLE_TORCH_IMPORTER) && ENABLE_TORCH_IMPORTER
 #if defined(ENABLE_TORCH_TESTS) && ENABLE_TORCH_TESTS
 #include "test_precomp.hpp"
+#include <fstream>
 
 namespace cvtest
 {
@@ -87,6 +88,61 @@ static void runTorchNet(String prefix, String outLayerName, bool isBinary)
     normAssert(outRef, out);
 }
 
+//writes ASCII Torch file with 2x3 FloatTensor viewing FloatStorage {0, 1, ..., 7}
+static String writeTorchTensor(int stride0, int stride1, int offset)
+{
+    String filename = cv::tempfile(".txt");
+    std::ofstream f(filename.c_str());
+    f << "4\n1\n3\nV 1\n17\ntorch.FloatTensor\n";
+    f << "2\n2 3\n" << stride0 << " " << stride1 << "\n" << offset + 1 << "\n";
+    f << "4\n2\n3\nV 1\n18\ntorch.FloatStorage\n";
+    f << "8\n0 1 2 3 4 5 6 7\n";
+    return filename;
+}
+
+TEST(Torch_Importer, read_tensor_with_offset)
+{
+    String filename = writeTorchTensor(3, 1, 2);
+    Blob blob = readTorchBlob(filename, false);
+    remove(filename.c_str());
+
+    float ref[] = {2, 3, 4, 5, 6, 7};
+    normAssert(Mat(2, 3, CV_32F, ref), blob.matRefConst().reshape(1, 2));
+}
+
+TEST(Torch_Importer, read_noncontinuous_tensor)
+{
+    //transposed view of the storage with offset
+    String filename = writeTorchTensor(1, 2, 2);
+    Blob blob = readTorchBlob(filename, false);
+    remove(filename.c_str());
+
+    float ref[] = {2, 4, 6, 3, 5, 7};
+    normAssert(Mat(2, 3, CV_32F, ref), blob.matRefConst().reshape(1, 2));
+}
+
+TEST(Torch_Importer, tensor_outlives_importer)
+{
+    String filename = writeTorchTensor(3, 1, 2);
+    Blob blob;
+    {
+        //the tensor is a view of the storage owned by the importer
+        Blob tmp = readTorchBlob(filename, false);
+        ASSERT_TRUE(tmp.matRefConst().u != NULL);
+        blob = tmp;
+    }
+    remove(filename.c_str());
+
+    //the importer is destroyed, so the blob must be the only owner of the storage it views
+    const Mat &m = blob.matRefConst();
+    ASSERT_TRUE(m.u != NULL);
+    EXPECT_EQ(1, m.u->refcount);
+    EXPECT_TRUE(m.u->data <= m.data && m.data + m.total() * m.elemSize() <= m.u->data + m.u->size);
+
+    float ref[] = {2, 3, 4, 5, 6, 7};
+    normAssert(Mat(2, 3, CV_32F, ref), m.reshape(1, 2));
+}
+
 TEST(Torch_Importer, run_convolution)
 {
     runTorchNet("net_conv", "l1_Convolution", false);
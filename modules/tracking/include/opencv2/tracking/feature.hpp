@@ -233,6 +233,15 @@ class CvHaarEvaluator : public CvFeatureEvaluator
     float getInitMean() const;
     float getInitSigma() const;
 
+    /**
+     * \brief Prepares the evaluation of the feature on the patches of an integral image, the result is the same as of eval()
+     * @param patchSize size of the patches
+     * @param step row step of the integral image in elements
+     * @param offsets output offsets of the corners of the areas from the beginning of the patch, 4 per area
+     * @param weights output weights of the areas, 1 per area
+     */
+    void getIntegralOffsets( Size patchSize, int step, int* offsets, float* weights ) const;
+
    private:
     int m_type;
     int m_numAreas;
@@ -254,6 +263,16 @@ class CvHaarEvaluator : public CvFeatureEvaluator
   virtual void init( const CvFeatureParams *_featureParams, int _maxSampleCount, Size _winSize );
   virtual void setImage( const Mat& img, uchar clsLabel = 0, int idx = 1 );
   virtual float operator()( int featureIdx, int sampleIdx );
+
+  /**
+   * \brief Evaluates the features on a batch of patches of the integral images, the patches are split across the threads.
+   * The patches of the same size, type and row step, e.g. the samples cut from one integral image, are evaluated
+   * with the corner offsets computed once for the whole batch.
+   * @param images patches of the integral images
+   * @param featureIdx indices of the evaluated features
+   * @param response the response of the feature featureIdx[j] on the patch i is written to the element (featureIdx[j], i)
+   */
+  void evalBatch( const std::vector<Mat>& images, const std::vector<int>& featureIdx, Mat& response ) const;
   virtual void writeFeatures( FileStorage &fs, const Mat& featureMap ) const;
   void writeFeature( FileStorage &fs ) const;  // for old file format
   const std::vector<CvHaarEvaluator::FeatureHaar>& getFeatures() const;
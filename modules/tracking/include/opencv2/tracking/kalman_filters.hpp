@@ -114,6 +114,24 @@ public:
     * @param z_k - measurement vector.
     */
     virtual void measurementFunction( const Mat& x_k, const Mat& n_k, Mat& z_k ) = 0;
+
+    /** The function for computing the next states of all sigma points in one call.
+    * The filters call it once per prediction step. The default implementation calls stateConversionFunction
+    * for every column, override it to propagate the sigma points with vectorized or matrix code.
+    * @param x_k - previous state vectors, one per column,
+    * @param u_k - control vector, shared by all columns,
+    * @param v_k - noise vectors, one per column,
+    * @param x_kplus1 - next state vectors, one per column, preallocated and filled in place.
+    */
+    virtual void stateConversionFunctionBatch( const Mat& x_k, const Mat& u_k, const Mat& v_k, Mat& x_kplus1 );
+    /** The function for computing the measurements of all sigma points in one call.
+    * The filters call it once per correction step. The default implementation calls measurementFunction
+    * for every column.
+    * @param x_k - state vectors, one per column,
+    * @param n_k - noise vectors, one per column,
+    * @param z_k - measurement vectors, one per column, preallocated and filled in place.
+    */
+    virtual void measurementFunctionBatch( const Mat& x_k, const Mat& n_k, Mat& z_k );
 };
 
 
@@ -222,6 +240,56 @@ CV_EXPORTS Ptr<UnscentedKalmanFilter> createUnscentedKalmanFilter( const Unscent
 */
 CV_EXPORTS Ptr<UnscentedKalmanFilter> createAugmentedUnscentedKalmanFilter( const AugmentedUnscentedKalmanFilterParams &params );
 
+/** @brief Set of independent Unscented Kalman filters stepped together, e.g. one filter per tracked object.
+
+* The filters are processed in parallel, so a system model shared by several filters must not keep per-call state.
+*/
+class CV_EXPORTS MultiUnscentedKalmanFilter
+{
+public:
+
+    /** The function adds a filter to the set
+    * @param filter - the filter created by createUnscentedKalmanFilter or createAugmentedUnscentedKalmanFilter,
+    * @return index of the filter in the set.
+    */
+    int add( const Ptr<UnscentedKalmanFilter>& filter );
+
+    /** The function removes all filters from the set
+    */
+    void clear();
+
+    /**
+    * @return number of filters in the set.
+    */
+    int size() const;
+
+    /**
+    * @param idx - index of the filter,
+    * @return the filter.
+    */
+    Ptr<UnscentedKalmanFilter> getFilter( int idx ) const;
+
+    /** The function performs prediction step of all filters
+    * @param controls - control vectors, one per filter, or empty if the filters have no control input.
+    */
+    void predict( const std::vector<Mat>& controls = std::vector<Mat>() );
+
+    /** The function performs correction step of all filters
+    * @param measurements - measurement vectors, one per filter. Filters with an empty measurement keep the predicted state.
+    */
+    void correct( const std::vector<Mat>& measurements );
+
+    /**
+    * @return the current estimates of the states, one per filter.
+    */
+    const std::vector<Mat>& getStates() const;
+
+protected:
+
+    std::vector<Ptr<UnscentedKalmanFilter> > filters;
+    std::vector<Mat> states;
+};
+
 } // tracking
 } // cv
 
@@ -85,6 +85,10 @@ class CV_EXPORTS ClfMilBoost
   std::vector<ClfOnlineStump*> _weakclf;
   uint _counter;
 
+  //feature-major training samples and responses of the weak classifiers, reused between updates
+  Mat _posx, _negx;
+  Mat _pospred, _negpred;
+
 };
 
 class ClfOnlineStump
@@ -105,6 +109,13 @@ class ClfOnlineStump
   float classifyF( const Mat& x, int i );
   std::vector<float> classifySetF( const Mat& x );
 
+  /** \brief Updates the stump from the contiguous values of its feature in the positive and negative samples.
+   */
+  void update( const float* posx, int numpos, const float* negx, int numneg );
+  /** \brief Computes the log odds ratio for n contiguous values of the stump feature.
+   */
+  void classifySetF( const float* x, int n, float* res ) const;
+
  private:
   bool _trained;
   int _ind;
@@ -1201,6 +1201,10 @@ class CV_EXPORTS TrackerTLD : public Tracker
  * The original paper of KCF is available at <http://home.isr.uc.pt/~henriques/circulant/index.html>
  * as well as the matlab implementation. For more information about KCF with color-names features, please refer to
  * <http://www.cvl.isy.liu.se/research/objrec/visualtracking/colvistrack/index.html>.
+ *
+ * If TrackerKCF::Params::scale_estimation is set, the tracker also estimates the size of the target.
+ * The sub-window is sampled at several scales around the current one, all samples are resized to the size
+ * of the filter and evaluated by the same model, and the scale with the highest response is selected.
  */
 class CV_EXPORTS TrackerKCF : public Tracker
 {
@@ -1247,6 +1251,10 @@ public:
 		int compressed_size;          //!<  feature size after compression
 		unsigned int desc_pca;        //!<  compressed descriptors of TrackerKCF::MODE
 		unsigned int desc_npca;       //!<  non-compressed descriptors of TrackerKCF::MODE
+		bool scale_estimation;        //!<  search the target over several scales and adapt the size of the bounding box
+		int scale_count;              //!<  number of the evaluated scales, including the current one
+		double scale_step;            //!<  ratio between the neighbouring scales
+		double scale_penalty;         //!<  multiplier of the responses of the changed scales, suppresses the scale jitter
 	};
 
 	virtual void setFeatureExtractor(void(*)(const Mat, const Rect, Mat&), bool pca_func = false);
@@ -1326,12 +1334,25 @@ public:
 	*/
 	CV_WRAP bool update(const Mat& image, CV_OUT std::vector<Rect2d> & boundingBox);
 
+	/**
+	* \brief Enables or disables the parallel update of the trackers.
+	* In the parallel mode update() processes the trackers concurrently. The trackers don't share
+	* a state, so the results are the same as in the sequential mode, except for BOOSTING trackers
+	* which draw random numbers from the global generator during the update.
+	* In both modes the trackers share preprocessed versions of the frame, e.g. grayscale or integral images.
+	* @param parallel true to update the trackers concurrently
+	*/
+	CV_WRAP void setParallelUpdate(bool parallel = true);
+
 protected:
 	//!<  storage for the tracker algorithms.
 	std::vector< Ptr<Tracker> > trackerList;
 
 	//!<  default algorithm for the tracking method.
 	String defaultAlgorithm;
+
+	//!<  update the trackers concurrently.
+	bool parallelUpdate;
 };
 
 class ROISelector {
@@ -1,6 +1,7 @@
 #include "opencv2/core.hpp"
 #include "opencv2/core/core_c.h"
 #include <algorithm>
+#include <cstring>
 #include <typeinfo>
 #include <cmath>
 #define WEIGHTED
@@ -42,10 +43,30 @@ namespace cv{
         TermCriteria _termcrit;
         int _maxItNum,_iter,_particlesNum;
         double _alpha;
+        Mat_<double> _new_particles;
         inline void normalize(Mat_<double>& row);
         RNG rng;
     };
 
+    //!computes the log-weights of the particles in parallel, the function has to be safe to call concurrently
+    class PFEvaluateInvoker : public ParallelLoopBody{
+    public:
+        PFEvaluateInvoker(const PFSolver::Function* function,Mat_<double>& particles,Mat_<double>& logweight):
+            _function(function),_particles(particles),_logweight(logweight){}
+        void operator()(const Range& range)const{
+            for(int i=range.start;i<range.end;i++){
+                double* particle=_particles[i];
+                _function->correctParams(particle);
+                _logweight(0,i)=-(_function->calc(particle));
+            }
+        }
+    private:
+        const PFSolver::Function* _function;
+        Mat_<double>& _particles;
+        Mat_<double>& _logweight;
+        PFEvaluateInvoker& operator=(const PFEvaluateInvoker&);
+    };
+
     CV_EXPORTS_W Ptr<PFSolver> createPFSolver(const Ptr<MinProblemSolver::Function>& f=Ptr<MinProblemSolver::Function>(),InputArray std=Mat(),
             TermCriteria termcrit=TermCriteria(TermCriteria::MAX_ITER,5,0.0),int particlesNum=100,double alpha=0.6);
 
@@ -56,14 +77,18 @@ namespace cv{
         rng=RNG(getTickCount());
     }
     void PFSolver::getOptParam(OutputArray params)const{
-        params.create(1,_std.rows,CV_64FC1);
-        Mat mat(1,_std.rows,CV_64FC1);
+        params.create(1,_std.cols,CV_64FC1);
+        Mat_<double> mat(1,_std.cols,0.0);
 #ifdef WEIGHTED
-        mat.setTo(0.0);
+        double* opt=mat[0];
         for(int i=0;i<_particles.rows;i++){
-            mat+=_particles.row(i)/exp(-_logweight(0,i));
+            const double* particle=_particles[i];
+            double weight=exp(_logweight(0,i));
+            for(int j=0;j<_particles.cols;j++){
+                opt[j]+=particle[j]*weight;
+            }
         }
-        _real_function->correctParams((double*)mat.data);
+        _real_function->correctParams(opt);
         mat.copyTo(params);
 #else
         params.create(1,_std.rows,CV_64FC1);
@@ -88,35 +113,27 @@ namespace cv{
         }
 
         //measure
-        for(int i=0;i<_particles.rows;i++){
-            _real_function->correctParams((double*)_particles.row(i).data);
-            _logweight(0,i)=-(_real_function->calc((double*)_particles.row(i).data));
-        }
+        parallel_for_(Range(0,_particles.rows),PFEvaluateInvoker(_real_function,_particles,_logweight));
         //normalize
         normalize(_logweight);
-        //replicate
-        Mat_<double> new_particles(_particlesNum,_std.cols);
+        //replicate, the buffers of the particles are swapped instead of reallocated
+        _new_particles.create(_particlesNum,_std.cols);
+        size_t rowSize=_std.cols*sizeof(double);
         int num_particles=0;
         for(int i=0;i<_particles.rows;i++){
-            int num_replicons=cvFloor(new_particles.rows/exp(-_logweight(0,i)));
-            for(int j=0;j<num_replicons;j++,num_particles++){
-                _particles.row(i).copyTo(new_particles.row(num_particles));
+            int num_replicons=cvFloor(_new_particles.rows*exp(_logweight(0,i)));
+            for(int j=0;j<num_replicons && num_particles<_new_particles.rows;j++,num_particles++){
+                memcpy(_new_particles[num_particles],_particles[i],rowSize);
             }
         }
-        //Mat_<double> maxrow=_particles.row(std::max_element(_logweight.begin(),_logweight.end())-_logweight.begin());
-        double max_element;
-        minMaxLoc(_logweight, 0, &max_element);
-        Mat_<double> maxrow=_particles.row((int)max_element);
-        for(;num_particles<new_particles.rows;num_particles++){
-                maxrow.copyTo(new_particles.row(num_particles));
-        }
-
-        if(_particles.rows!=new_particles.rows){
-            _particles=new_particles;
-        }else{
-            new_particles.copyTo(_particles);
+        Point max_loc;
+        minMaxLoc(_logweight,0,0,0,&max_loc);
+        const double* maxrow=_particles[max_loc.x];
+        for(;num_particles<_new_particles.rows;num_particles++){
+            memcpy(_new_particles[num_particles],maxrow,rowSize);
         }
-        _std=_std*_alpha;
+        cv::swap(_particles,_new_particles);
+        _std*=_alpha;
         _iter++;
         return _iter;
     }
@@ -127,7 +144,7 @@ namespace cv{
         CV_Assert(mat_x.type()==CV_64FC1 && MIN(mat_x.rows,mat_x.cols)==1 && MAX(mat_x.rows,mat_x.cols)==_std.cols);
 
         _iter=0;
-        _particles=Mat_<double>(_particlesNum,_std.cols);
+        _particles.create(_particlesNum,_std.cols);
         if(mat_x.rows>1){
             mat_x=mat_x.t();
         }
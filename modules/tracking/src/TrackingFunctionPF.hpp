@@ -2,6 +2,8 @@
 #include <opencv2/imgproc/imgproc_c.h>
 #define CLIP(x,a,b) MIN(MAX((x),(a)),(b))
 #define HIST_SIZE 50
+//!largest integral histogram, in counters, that is built for a frame
+#define MAX_INTEGRAL_HIST_SIZE (1<<25)
 
 namespace cv{
 
@@ -14,69 +16,173 @@ namespace cv{
             void correctParams(double* pt)const;
         private:
             Mat _image;
+            Mat _hsv;
+            //!compact histogram bin of every pixel of the current frame, see TrackingHistogram::quantize()
+            Mat_<ushort> _bins;
+            //!integral histogram of the compact bins of the current frame, the counters of the point (y,x) are
+            //!contiguous; empty when it would exceed MAX_INTEGRAL_HIST_SIZE and the patches are counted pixel by pixel
+            std::vector<int> _integral;
             static inline Rect rectFromRow(const double* row);
             const int _nh,_ns,_nv;
             class TrackingHistogram{
             public:
                 TrackingHistogram(const Mat& img,int nh,int ns,int nv);
-                double dist(const TrackingHistogram& hist)const;
+                //!maps every pixel of the image to the compact index of its bin, all bins that are empty in this
+                //!histogram share the last index, as they do not contribute to the distance
+                void quantize(const Mat& img,Mat& hsv,Mat_<ushort>& bins)const;
+                //!distance to the histogram of a patch of the map computed by quantize()
+                double dist(const Mat_<ushort>& bins)const;
+                //!distance to the histogram given by the pixel counts of the non-empty bins and the patch area
+                double dist(const int* counts,int area)const;
+                //!number of the bins which are not empty in this histogram
+                int getNumBins()const{ return (int)_sqrtHist.size(); }
+                //!index of the histogram bin of every pixel: nh*ns hue-saturation bins followed by nv value bins
+                static void computeBins(const Mat& img,int nh,int ns,int nv,Mat& hsv,Mat_<ushort>& bins);
             private:
-                Mat_<double> HShist, Vhist;
+                int _nh,_ns,_nv;
+                std::vector<ushort> _compact;
+                std::vector<double> _sqrtHist;
             };
             TrackingHistogram _origHist;
 			const TrackingFunctionPF & operator = (const TrackingFunctionPF &);
     };
 
-    TrackingFunctionPF::TrackingHistogram::TrackingHistogram(const Mat& img,int nh,int ns,int nv){
-
-        Mat hsv;
+    void TrackingFunctionPF::TrackingHistogram::computeBins(const Mat& img,int nh,int ns,int nv,Mat& hsv,Mat_<ushort>& bins){
         img.convertTo(hsv,CV_32F,1.0/255.0);
         cvtColor(hsv,hsv,CV_BGR2HSV);
 
-        HShist=Mat_<double>(nh,ns,0.0);
-        Vhist=Mat_<double>(1,nv,0.0);
-
+        bins.create(img.rows,img.cols);
         for(int i=0;i<img.rows;i++){
+            const Vec3f* pt=hsv.ptr<Vec3f>(i);
+            ushort* bin=bins[i];
             for(int j=0;j<img.cols;j++){
-                const Vec3f& pt=hsv.at<Vec3f>(i,j);
-
-                if(pt.val[1]>0.1 && pt.val[2]>0.2){
-                    HShist(MIN(nh-1,(int)(nh*pt.val[0]/360.0)),MIN(ns-1,(int)(ns*pt.val[1])))++;
+                if(pt[j].val[1]>0.1 && pt[j].val[2]>0.2){
+                    bin[j]=(ushort)(MIN(nh-1,(int)(nh*pt[j].val[0]/360.0))*ns+MIN(ns-1,(int)(ns*pt[j].val[1])));
                 }else{
-                    Vhist(0,MIN(nv-1,(int)(nv*pt.val[2])))++;
+                    bin[j]=(ushort)(nh*ns+MIN(nv-1,(int)(nv*pt[j].val[2])));
                 }
             }}
-
-        double total=*(sum(HShist)+sum(Vhist)).val;
-        HShist/=total;
-        Vhist/=total;
     }
-    double TrackingFunctionPF::TrackingHistogram::dist(const TrackingHistogram& hist)const{
-        double res=1.0;
+    TrackingFunctionPF::TrackingHistogram::TrackingHistogram(const Mat& img,int nh,int ns,int nv):_nh(nh),_ns(ns),_nv(nv){
+        CV_Assert(nh*ns+nv<=HIST_SIZE*HIST_SIZE+HIST_SIZE);
+
+        Mat hsv;
+        Mat_<ushort> bins;
+        computeBins(img,nh,ns,nv,hsv,bins);
+
+        std::vector<int> hist(nh*ns+nv,0);
+        for(int i=0;i<bins.rows;i++){
+            const ushort* bin=bins[i];
+            for(int j=0;j<bins.cols;j++){
+                hist[bin[j]]++;
+            }}
 
-        for(int i=0;i<HShist.rows;i++){
-            for(int j=0;j<HShist.cols;j++){
-                res-=sqrt(HShist(i,j)*hist.HShist(i,j));
+        //every pixel falls into exactly one bin, so the histogram is normalized by the area
+        double total=(double)img.rows*img.cols;
+        _compact.resize(hist.size());
+        for(size_t k=0;k<hist.size();k++){
+            if(hist[k]>0){
+                _compact[k]=(ushort)_sqrtHist.size();
+                _sqrtHist.push_back(sqrt(hist[k]/total));
+            }
+        }
+        for(size_t k=0;k<hist.size();k++){
+            if(hist[k]==0){
+                _compact[k]=(ushort)_sqrtHist.size();
+            }
+        }
+    }
+    void TrackingFunctionPF::TrackingHistogram::quantize(const Mat& img,Mat& hsv,Mat_<ushort>& bins)const{
+        computeBins(img,_nh,_ns,_nv,hsv,bins);
+        const ushort* compact=&_compact[0];
+        for(int i=0;i<bins.rows;i++){
+            ushort* bin=bins[i];
+            for(int j=0;j<bins.cols;j++){
+                bin[j]=compact[bin[j]];
             }}
-        for(int j=0;j<Vhist.cols;j++){
-            res-=sqrt(Vhist(0,j)*hist.Vhist(0,j));
+    }
+    double TrackingFunctionPF::TrackingHistogram::dist(const Mat_<ushort>& bins)const{
+        int nbins=(int)_sqrtHist.size();
+        AutoBuffer<int,HIST_SIZE*HIST_SIZE+HIST_SIZE+1> _counts(nbins+1);
+        int* counts=_counts;
+        std::fill(counts,counts+nbins+1,0);
+        for(int i=0;i<bins.rows;i++){
+            const ushort* bin=bins[i];
+            for(int j=0;j<bins.cols;j++){
+                counts[bin[j]]++;
+            }}
+
+        return dist(counts,bins.rows*bins.cols);
+    }
+    double TrackingFunctionPF::TrackingHistogram::dist(const int* counts,int area)const{
+        double res=0.0;
+        for(int k=0,nbins=(int)_sqrtHist.size();k<nbins;k++){
+            res+=_sqrtHist[k]*sqrt((double)counts[k]);
         }
+        res=1.0-res/sqrt((double)area);
 
-        return sqrt(res);
+        return sqrt(MAX(res,0.0));
     }
     double TrackingFunctionPF::calc(const double* x) const{
         Rect rect=rectFromRow(x);
         if(rect.area()==0){
             return 2.0;
         }
-        return _origHist.dist(TrackingHistogram(_image(rect),_nh,_ns,_nv));
+        if(_integral.empty()){
+            return _origHist.dist(_bins(rect));
+        }
+
+        //the counts of the patch are taken from the four corners of the integral histogram,
+        //the particles are clipped to the frame by correctParams()
+        CV_DbgAssert((rect&Rect(0,0,_bins.cols,_bins.rows))==rect);
+        int nbins=_origHist.getNumBins();
+        size_t rowstep=(size_t)(_bins.cols+1)*nbins;
+        const int* tl=&_integral[0]+rect.y*rowstep+(size_t)rect.x*nbins;
+        const int* tr=tl+(size_t)rect.width*nbins;
+        const int* bl=tl+rect.height*rowstep;
+        const int* br=bl+(size_t)rect.width*nbins;
+        AutoBuffer<int,HIST_SIZE*HIST_SIZE+HIST_SIZE> _counts(nbins);
+        int* counts=_counts;
+        for(int k=0;k<nbins;k++){
+            counts[k]=br[k]-bl[k]-tr[k]+tl[k];
+        }
+        return _origHist.dist(counts,rect.area());
     }
     TrackingFunctionPF::TrackingFunctionPF(const Mat& chosenRect):_nh(HIST_SIZE),_ns(HIST_SIZE),_nv(HIST_SIZE),_origHist(chosenRect,_nh,_ns,_nv){
     }
     void TrackingFunctionPF::update(const Mat& image){
         _image=image;
 
-        TrackingHistogram hist(image,_nh,_ns,_nv);
+        //the color conversion and binning are done once per frame instead of once per particle
+        _origHist.quantize(image,_hsv,_bins);
+
+        //with the integral histogram a particle is evaluated in O(bins) regardless of the size of its patch,
+        //its memory grows with the number of bins of the reference histogram times the frame area
+        int nbins=_origHist.getNumBins();
+        if(nbins==0 || (double)nbins*(_bins.rows+1)*(_bins.cols+1)>MAX_INTEGRAL_HIST_SIZE){
+            _integral.clear();
+            return;
+        }
+        size_t rowstep=(size_t)(_bins.cols+1)*nbins;
+        _integral.resize(rowstep*(_bins.rows+1));
+        std::fill(_integral.begin(),_integral.begin()+rowstep,0);
+        std::vector<int> rowCounts(nbins);
+        for(int i=0;i<_bins.rows;i++){
+            const ushort* bin=_bins[i];
+            const int* prev=&_integral[0]+i*rowstep;
+            int* cur=&_integral[0]+(i+1)*rowstep;
+            std::fill(rowCounts.begin(),rowCounts.end(),0);
+            std::fill(cur,cur+nbins,0);
+            for(int j=0;j<_bins.cols;j++){
+                if(bin[j]<nbins){
+                    rowCounts[bin[j]]++;
+                }
+                prev+=nbins;
+                cur+=nbins;
+                for(int k=0;k<nbins;k++){
+                    cur[k]=prev[k]+rowCounts[k];
+                }
+            }}
     }
     void TrackingFunctionPF::correctParams(double* pt)const{
         pt[0]=CLIP(pt[0],0.0,_image.cols+0.9);
@@ -90,6 +90,39 @@ inline choleskyDecomposition( const _Tp* A, size_t astep, const int asize, _Tp*
     return true;
 }
 
+/* Weighted mean and centered values of the function values at sigma points
+ vals - function values at sigma points, n x N,
+ Wm - weights of the mean, N x 1,
+ Wc - weights of the covariance, N x 1,
+ mean - the weighted mean, n x 1,
+ center - function values minus the mean, n x N,
+ weighted - centered values multiplied by the weights of the covariance, n x N.
+*/
+template<typename _Tp> void
+inline centerSigmaPointValues( const Mat& vals, const Mat& Wm, const Mat& Wc, Mat& mean, Mat& center, Mat& weighted )
+{
+    const _Tp* wm = Wm.ptr<_Tp>();
+    const _Tp* wc = Wc.ptr<_Tp>();
+    int N = vals.cols;
+    for( int i = 0; i < vals.rows; i++ )
+    {
+        const _Tp* v = vals.ptr<_Tp>(i);
+        double s = 0;
+        for( int j = 0; j < N; j++ )
+            s += (double)wm[j]*v[j];
+        _Tp m = (_Tp)s;
+        mean.ptr<_Tp>(i)[0] = m;
+
+        _Tp* c = center.ptr<_Tp>(i);
+        _Tp* w = weighted.ptr<_Tp>(i);
+        for( int j = 0; j < N; j++ )
+        {
+            c[j] = v[j] - m;
+            w[j] = c[j]*wc[j];
+        }
+    }
+}
+
 
 void AugmentedUnscentedKalmanFilterParams::
     init( int dp, int mp, int cp, double processNoiseCovDiag, double measurementNoiseCovDiag,
@@ -135,12 +168,12 @@ class AugmentedUnscentedKalmanFilterImpl: public UnscentedKalmanFilter
     Mat state;                                  // estimate of the system state (x*), DP x 1
     Mat errorCov;                               // estimate of the state cross-covariance matrix (P), DP x DP
 
-    Mat stateAug;                               // augmented state vector (xa*), DAug x 1,
+    Mat stateAug;                               // augmented state vector (xa*), DAug x 1, it keeps the initial x*
                                                 // xa* = ( x*
                                                 //         0
                                                 //        ...
                                                 //         0 )
-    Mat errorCovAug;                            // estimate of the state cross-covariance matrix (Pa), DAug x DAug
+    Mat errorCovAug;                            // estimate of the state cross-covariance matrix (Pa), DAug x DAug, it keeps the initial P
                                                 // Pa = (  P, 0, 0
                                                 //         0, Q, 0
                                                 //         0, 0, R  )
@@ -158,32 +191,41 @@ class AugmentedUnscentedKalmanFilterImpl: public UnscentedKalmanFilter
     double lambda;                              // internal parameter, lambda = alpha*alpha*( DP + k ) - DP;
     double tmpLambda;                           // internal parameter, tmpLambda = alpha*alpha*( DP + k );
 
-// Auxillary members
+// Auxillary members, all of them are allocated once in the constructor
     Mat measurementEstimate;                    // estimate of current measurement (y*), MP x 1
 
-    Mat sigmaPoints;                            // set of sigma points ( x_i, i = 1..2*DP+1 ), DP x 2*DP+1
+    Mat sigmaPoints;                            // set of sigma points ( xa_i, i = 1..2*DAug+1 ), DAug x 2*DAug+1
+    Mat covMatrixL;                             // lower triangular Cholesky factor of Pa, DAug x DAug
+
+    Mat transitionSPFuncVals;                   // set of state function values at sigma points ( f_i, i = 1..2*DAug+1 ), DP x 2*DAug+1
+    Mat measurementSPFuncVals;                  // set of measurement function values at sigma points ( h_i, i = 1..2*DAug+1 ), MP x 2*DAug+1
 
-    Mat transitionSPFuncVals;                   // set of state function values at sigma points ( f_i, i = 1..2*DP+1 ), DP x 2*DP+1
-    Mat measurementSPFuncVals;                  // set of measurement function values at sigma points ( h_i, i = 1..2*DP+1 ), MP x 2*DP+1
+    Mat transitionSPFuncValsCenter;             // set of state function values at sigma points minus estimate of state ( fc_i, i = 1..2*DAug+1 ), DP x 2*DAug+1
+    Mat measurementSPFuncValsCenter;            // set of measurement function values at sigma points minus estimate of measurement ( hc_i, i = 1..2*DAug+1 ), MP x 2*DAug+1
 
-    Mat transitionSPFuncValsCenter;             // set of state function values at sigma points minus estimate of state ( fc_i, i = 1..2*DP+1 ), DP x 2*DP+1
-    Mat measurementSPFuncValsCenter;            // set of measurement function values at sigma points minus estimate of measurement ( hc_i, i = 1..2*DP+1 ), MP x 2*DP+1
+    Mat transitionSPFuncValsWeighted;           // fc_i multiplied by the weights of the covariance ( Wc[i]*fc_i, i = 1..2*DAug+1 ), DP x 2*DAug+1
+    Mat measurementSPFuncValsWeighted;          // hc_i multiplied by the weights of the covariance ( Wc[i]*hc_i, i = 1..2*DAug+1 ), MP x 2*DAug+1
 
-    Mat Wm;                                     // vector of weights for estimate mean, 2*DP+1 x 1
-    Mat Wc;                                     // matrix of weights for estimate covariance, 2*DP+1 x 2*DP+1
+    Mat Wm;                                     // vector of weights for estimate mean, 2*DAug+1 x 1
+    Mat Wc;                                     // vector of weights for estimate covariance, 2*DAug+1 x 1
 
     Mat gain;                                   // Kalman gain matrix (K), DP x MP
     Mat xyCov;                                  // estimate of the covariance between x* and y* (Sxy), DP x MP
     Mat yyCov;                                  // estimate of the y* cross-covariance matrix (Syy), MP x MP
+    Mat yyCovInv;                               // inverse of Syy, MP x MP
+    Mat innovation;                             // difference between the measurement and its estimate (y - y*), MP x 1
 
-    Mat r;                                      // zero vector of process noise for getting transitionSPFuncVals,
-    Mat q;                                      // zero vector of measurement noise for getting measurementSPFuncVals
+    Mat x;                                      // state parts of the sigma points, DP x 2*DAug+1
+    Mat q;                                      // process noise parts of the sigma points, DP x 2*DAug+1
+    Mat r;                                      // measurement noise parts of the sigma points, MP x 2*DAug+1
 
 
     template <typename T>
-    Mat getSigmaPoints(const Mat& mean, const Mat& covMatrix, double coef);
+    void getSigmaPoints(const Mat& mean, const Mat& covMatrix, double coef);
 
-    Mat getSigmaPoints(const Mat& mean, const Mat& covMatrix, double coef);
+    void getSigmaPoints(const Mat& mean, const Mat& covMatrix, double coef);
+
+    void getCenteredValues(const Mat& vals, Mat& mean, Mat& center, Mat& weighted);
 
 public:
 
@@ -218,11 +260,14 @@ AugmentedUnscentedKalmanFilterImpl::AugmentedUnscentedKalmanFilterImpl(const Aug
 
     model = params.model;
 
+// the estimates x* and P are kept apart from xa* and Pa, so the sigma points are drawn around the initial
+// augmented state and covariance, as they were when predict() and correct() reassigned the estimates
     stateAug = Mat::zeros( DAug, 1, dataType );
-    state = stateAug( Rect( 0, 0, 1, DP ));
+    Mat stateAugHead = stateAug( Rect( 0, 0, 1, DP ));
 
     CV_Assert( params.stateInit.cols == 1 && params.stateInit.rows == DP );
-    params.stateInit.copyTo(state);
+    params.stateInit.copyTo(stateAugHead);
+    state = stateAugHead.clone();
 
     CV_Assert( params.processNoiseCov.cols == DP && params.processNoiseCov.rows == DP );
     CV_Assert( params.measurementNoiseCov.cols == MP && params.measurementNoiseCov.rows == MP );
@@ -230,18 +275,29 @@ AugmentedUnscentedKalmanFilterImpl::AugmentedUnscentedKalmanFilterImpl(const Aug
     measurementNoiseCov = params.measurementNoiseCov.clone();
 
     errorCovAug = Mat::zeros( DAug, DAug, dataType );
-    errorCov = errorCovAug( Rect( 0, 0, DP, DP ) );
+    Mat P = errorCovAug( Rect( 0, 0, DP, DP ) );
     Mat Q = errorCovAug( Rect( DP, DP, DP, DP ) );
     Mat R = errorCovAug( Rect( 2*DP, 2*DP, MP, MP ) );
     processNoiseCov.copyTo( Q );
     measurementNoiseCov.copyTo( R );
 
     CV_Assert( params.errorCovInit.cols == DP && params.errorCovInit.rows == DP );
-    params.errorCovInit.copyTo( errorCov );
+    params.errorCovInit.copyTo( P );
+    errorCov = P.clone();
 
     measurementEstimate = Mat::zeros( MP, 1, dataType);
 
-    gain = Mat::zeros( DAug, DAug, dataType );
+    gain = Mat::zeros( DP, MP, dataType );
+    xyCov = Mat::zeros( DP, MP, dataType );
+    yyCov = Mat::zeros( MP, MP, dataType );
+    yyCovInv = Mat::zeros( MP, MP, dataType );
+    innovation = Mat::zeros( MP, 1, dataType );
+
+    sigmaPoints = Mat::zeros( DAug, 2*DAug+1, dataType );
+    covMatrixL = Mat::zeros( DAug, DAug, dataType );
+    x = sigmaPoints.rowRange( 0, DP );
+    q = sigmaPoints.rowRange( DP, 2*DP );
+    r = sigmaPoints.rowRange( 2*DP, DAug );
 
     transitionSPFuncVals = Mat::zeros( DP, 2*DAug+1, dataType );
     measurementSPFuncVals = Mat::zeros( MP, 2*DAug+1, dataType );
@@ -249,13 +305,16 @@ AugmentedUnscentedKalmanFilterImpl::AugmentedUnscentedKalmanFilterImpl(const Aug
     transitionSPFuncValsCenter = Mat::zeros( DP, 2*DAug+1, dataType );
     measurementSPFuncValsCenter = Mat::zeros( MP, 2*DAug+1, dataType );
 
+    transitionSPFuncValsWeighted = Mat::zeros( DP, 2*DAug+1, dataType );
+    measurementSPFuncValsWeighted = Mat::zeros( MP, 2*DAug+1, dataType );
+
     lambda = alpha*alpha*( DAug + k ) - DAug;
     tmpLambda = lambda + DAug;
 
     double tmp2Lambda = 0.5/tmpLambda;
 
     Wm = tmp2Lambda * Mat::ones( 2*DAug+1, 1, dataType );
-    Wc = tmp2Lambda * Mat::eye( 2*DAug+1, 2*DAug+1, dataType );
+    Wc = tmp2Lambda * Mat::ones( 2*DAug+1, 1, dataType );
 
     if ( dataType == CV_64F )
     {
@@ -284,6 +343,7 @@ AugmentedUnscentedKalmanFilterImpl::~AugmentedUnscentedKalmanFilterImpl()
     measurementEstimate.release();
 
     sigmaPoints.release();
+    covMatrixL.release();
 
     transitionSPFuncVals.release();
     measurementSPFuncVals.release();
@@ -291,79 +351,84 @@ AugmentedUnscentedKalmanFilterImpl::~AugmentedUnscentedKalmanFilterImpl()
     transitionSPFuncValsCenter.release();
     measurementSPFuncValsCenter.release();
 
+    transitionSPFuncValsWeighted.release();
+    measurementSPFuncValsWeighted.release();
+
     Wm.release();
     Wc.release();
 
     gain.release();
     xyCov.release();
     yyCov.release();
+    yyCovInv.release();
+    innovation.release();
 
+    x.release();
     r.release();
     q.release();
 
 }
 
 template <typename T>
-Mat AugmentedUnscentedKalmanFilterImpl::getSigmaPoints(const Mat &mean, const Mat &covMatrix, double coef)
+void AugmentedUnscentedKalmanFilterImpl::getSigmaPoints(const Mat &mean, const Mat &covMatrix, double coef)
 {
 // x_0 = mean
 // x_i = mean + coef * cholesky( covMatrix ), i = 1..n
 // x_(i+n) = mean - coef * cholesky( covMatrix ), i = 1..n
 
     int n = mean.rows;
-    Mat points = repeat(mean, 1, 2*n+1);
 
 // covMatrixL = cholesky( covMatrix )
-    Mat covMatrixL = covMatrix.clone();
     covMatrixL.setTo(0);
-
     choleskyDecomposition<T>( covMatrix.ptr<T>(), covMatrix.step, covMatrix.rows, covMatrixL.ptr<T>() );
-    covMatrixL = coef * covMatrixL;
 
-    Mat p_plus = points( Rect( 1, 0, n, n ) );
-    Mat p_minus = points( Rect( n+1, 0, n, n ) );
-
-    add(p_plus, covMatrixL, p_plus);
-    subtract(p_minus, covMatrixL, p_minus);
+    for ( int i = 0; i < n; i++ )
+    {
+        T m = mean.ptr<T>(i)[0];
+        const T* l = covMatrixL.ptr<T>(i);
+        T* p = sigmaPoints.ptr<T>(i);
 
-    return points;
+        p[0] = m;
+        for ( int j = 0; j < n; j++ )
+        {
+            T d = (T)(coef*l[j]);
+            p[1 + j] = m + d;
+            p[1 + n + j] = m - d;
+        }
+    }
 }
 
-Mat AugmentedUnscentedKalmanFilterImpl::getSigmaPoints(const Mat& mean, const Mat& covMatrix, double coef)
+void AugmentedUnscentedKalmanFilterImpl::getSigmaPoints(const Mat& mean, const Mat& covMatrix, double coef)
 {
-    if ( dataType == CV_64F ) return getSigmaPoints<double>(mean, covMatrix, coef);
-    if ( dataType == CV_32F ) return getSigmaPoints<float>(mean, covMatrix, coef);
+    if ( dataType == CV_64F ) getSigmaPoints<double>(mean, covMatrix, coef);
+    if ( dataType == CV_32F ) getSigmaPoints<float>(mean, covMatrix, coef);
+}
 
-    return Mat();
+void AugmentedUnscentedKalmanFilterImpl::getCenteredValues(const Mat& vals, Mat& mean, Mat& center, Mat& weighted)
+{
+    CV_Assert( vals.cols == 2*DAug+1 && vals.rows == mean.rows && vals.type() == dataType );
+    if ( dataType == CV_64F ) centerSigmaPointValues<double>(vals, Wm, Wc, mean, center, weighted);
+    if ( dataType == CV_32F ) centerSigmaPointValues<float>(vals, Wm, Wc, mean, center, weighted);
 }
 
 Mat AugmentedUnscentedKalmanFilterImpl::predict(const Mat& control)
 {
 // get sigma points from xa* and Pa
-    sigmaPoints = getSigmaPoints( stateAug, errorCovAug, sqrt( tmpLambda ) );
+    getSigmaPoints( stateAug, errorCovAug, sqrt( tmpLambda ) );
 
-// compute f-function values at sigma points
+// compute f-function values at all sigma points in one call
 // f_i = f(x_i[0:DP-1], control, x_i[DP:2*DP-1]), i = 0..2*DAug
-    Mat x, fx;
-    for ( int i = 0; i<2*DAug+1; i++)
-    {
-        x = sigmaPoints( Rect( i, 0, 1, DP) );
-        q = sigmaPoints( Rect( i, DP, 1, DP) );
-        fx = transitionSPFuncVals( Rect( i, 0, 1, DP) );
-        model->stateConversionFunction( x, control, q, fx );
-    }
+    model->stateConversionFunctionBatch( x, control, q, transitionSPFuncVals );
 
 // compute the estimate of state as mean f-function value at sigma point
 // x* = SUM_{i=0}^{2*DAug}( Wm[i]*f_i )
-    state = transitionSPFuncVals * Wm;
-
-// compute f-function values at sigma points minus estimate of state
+// and f-function values at sigma points minus estimate of state
 // fc_i = f_i - x*, i = 0..2*DAug
-    subtract(transitionSPFuncVals, repeat( state, 1, 2*DAug+1 ), transitionSPFuncValsCenter);
+    getCenteredValues( transitionSPFuncVals, state, transitionSPFuncValsCenter, transitionSPFuncValsWeighted );
 
 // compute the estimate of the state cross-covariance matrix
 // P = SUM_{i=0}^{2*DAug}( Wc[i]*fc_i*fc_i.t )
-    errorCov = transitionSPFuncValsCenter * Wc * transitionSPFuncValsCenter.t();
+    gemm( transitionSPFuncValsWeighted, transitionSPFuncValsCenter, 1.0, noArray(), 0.0, errorCov, GEMM_2_T );
 
     return state.clone();
 }
@@ -371,47 +436,39 @@ Mat AugmentedUnscentedKalmanFilterImpl::predict(const Mat& control)
 Mat AugmentedUnscentedKalmanFilterImpl::correct(const Mat& measurement)
 {
 // get sigma points from xa* and Pa
-    sigmaPoints = getSigmaPoints( stateAug, errorCovAug, sqrt( tmpLambda ) );
+    getSigmaPoints( stateAug, errorCovAug, sqrt( tmpLambda ) );
 
-// compute h-function values at sigma points
+// compute h-function values at all sigma points in one call
 // h_i = h(x_i[0:DP-1], x_i[2*DP:DAug-1]), i = 0..2*DAug
-    Mat x, hx;
-    measurementEstimate.setTo(0);
-    for ( int i = 0; i<2*DAug+1; i++)
-    {
-        x = transitionSPFuncVals( Rect( i, 0, 1, DP) );
-        r = sigmaPoints( Rect( i, 2*DP, 1, MP) );
-        hx = measurementSPFuncVals( Rect( i, 0, 1, MP) );
-        model->measurementFunction( x, r, hx );
-    }
+    model->measurementFunctionBatch( transitionSPFuncVals, r, measurementSPFuncVals );
 
 // compute the estimate of measurement as mean h-function value at sigma point
 // y* = SUM_{i=0}^{2*DAug}( Wm[i]*h_i )
-    measurementEstimate = measurementSPFuncVals * Wm;
-
-// compute h-function values at sigma points minus estimate of state
+// and h-function values at sigma points minus estimate of state
 // hc_i = h_i - y*, i = 0..2*DAug
-    subtract(measurementSPFuncVals, repeat( measurementEstimate, 1, 2*DAug+1 ), measurementSPFuncValsCenter);
+    getCenteredValues( measurementSPFuncVals, measurementEstimate, measurementSPFuncValsCenter, measurementSPFuncValsWeighted );
 
 // compute the estimate of the y* cross-covariance matrix
 // Syy = SUM_{i=0}^{2*DAug}( Wc[i]*hc_i*hc_i.t )
-    yyCov = measurementSPFuncValsCenter * Wc * measurementSPFuncValsCenter.t();
+    gemm( measurementSPFuncValsWeighted, measurementSPFuncValsCenter, 1.0, noArray(), 0.0, yyCov, GEMM_2_T );
 
 // compute the estimate of the covariance between x* and y*
 // Sxy = SUM_{i=0}^{2*DAug}( Wc[i]*fc_i*hc_i.t )
-    xyCov = transitionSPFuncValsCenter * Wc * measurementSPFuncValsCenter.t();
+    gemm( transitionSPFuncValsWeighted, measurementSPFuncValsCenter, 1.0, noArray(), 0.0, xyCov, GEMM_2_T );
 
 // compute the Kalman gain matrix
 // K = Sxy * Syy^(-1)
-    gain = xyCov * yyCov.inv(DECOMP_SVD);
+    invert( yyCov, yyCovInv, DECOMP_SVD );
+    gemm( xyCov, yyCovInv, 1.0, noArray(), 0.0, gain );
 
 // compute the corrected estimate of state
 // x* = x* + K*(y - y*), y - current measurement
-    state = state + gain * ( measurement - measurementEstimate );
+    subtract( measurement, measurementEstimate, innovation );
+    gemm( gain, innovation, 1.0, state, 1.0, state );
 
 // compute the corrected estimate of the state cross-covariance matrix
 // P = P - K*Sxy.t
-    errorCov = errorCov - gain * xyCov.t();
+    gemm( gain, xyCov, -1.0, errorCov, 1.0, errorCov, GEMM_2_T );
 
     return state.clone();
 }
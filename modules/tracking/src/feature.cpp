@@ -257,6 +257,101 @@ float CvHaarEvaluator::operator()( int featureIdx, int /*sampleIdx*/)
   return res;
 }
 
+/*
+ * Evaluates the features on the patches of the range, the patches have the same size and row step,
+ * so the offsets of the corners of all areas are shared by them
+ */
+template<typename T>
+class HaarBatchInvoker : public ParallelLoopBody
+{
+ public:
+  HaarBatchInvoker( const std::vector<Mat>& _images, const std::vector<int>& _featureIdx, const std::vector<int>& _firstArea,
+                    const std::vector<int>& _offsets, const std::vector<float>& _weights, Mat& _response ) :
+      images( _images ),
+      featureIdx( _featureIdx ),
+      firstArea( _firstArea ),
+      offsets( _offsets ),
+      weights( _weights ),
+      response( _response )
+  {
+  }
+
+  virtual void operator()( const Range& r ) const
+  {
+    for ( size_t j = 0; j < featureIdx.size(); j++ )
+    {
+      float* dst = response.ptr<float>( featureIdx[j] );
+      for ( int i = r.start; i < r.end; i++ )
+      {
+        const T* patch = images[i].ptr<T>();
+        const int* offset = &offsets[firstArea[j] * 4];
+        float result = 0.0f;
+        for ( int area = firstArea[j]; area < firstArea[j + 1]; area++, offset += 4 )
+          result += static_cast<float>( patch[offset[0]] + patch[offset[1]] - patch[offset[2]] - patch[offset[3]] ) * weights[area];
+        dst[i] = result;
+      }
+    }
+  }
+
+ private:
+  const std::vector<Mat>& images;
+  const std::vector<int>& featureIdx;
+  const std::vector<int>& firstArea;
+  const std::vector<int>& offsets;
+  const std::vector<float>& weights;
+  Mat& response;
+
+  HaarBatchInvoker& operator=( const HaarBatchInvoker& );
+};
+
+void CvHaarEvaluator::evalBatch( const std::vector<Mat>& images, const std::vector<int>& featureIdx, Mat& response ) const
+{
+  CV_Assert( response.type() == CV_32FC1 && response.cols == (int) images.size() );
+  if( images.empty() || featureIdx.empty() )
+    return;
+
+  const Mat& first = images[0];
+  int depth = first.depth();
+  bool uniform = ( depth == CV_32S || depth == CV_32F || depth == CV_64F ) && first.channels() == 1 && first.step[0] % first.elemSize() == 0;
+  for ( size_t i = 1; i < images.size() && uniform; i++ )
+    uniform = images[i].size() == first.size() && images[i].type() == first.type() && images[i].step[0] == first.step[0];
+
+  if( !uniform )
+  {
+    for ( size_t i = 0; i < images.size(); i++ )
+    {
+      for ( size_t j = 0; j < featureIdx.size(); j++ )
+      {
+        float res = 0;
+        features[featureIdx[j]].eval( images[i], Rect( 0, 0, images[i].cols, images[i].rows ), &res );
+        response.at<float>( featureIdx[j], (int) i ) = res;
+      }
+    }
+    return;
+  }
+
+  //offsets of the corners of the areas of all features, the areas of the j-th feature are [firstArea[j], firstArea[j+1])
+  int step = (int) ( first.step[0] / first.elemSize() );
+  std::vector<int> firstArea( featureIdx.size() + 1, 0 );
+  for ( size_t j = 0; j < featureIdx.size(); j++ )
+    firstArea[j + 1] = firstArea[j] + (int) features[featureIdx[j]].getAreas().size();
+  std::vector<int> offsets( firstArea.back() * 4 );
+  std::vector<float> weights( firstArea.back() );
+  for ( size_t j = 0; j < featureIdx.size(); j++ )
+  {
+    if( firstArea[j + 1] > firstArea[j] )
+      features[featureIdx[j]].getIntegralOffsets( first.size(), step, &offsets[firstArea[j] * 4], &weights[firstArea[j]] );
+  }
+
+  Range range( 0, (int) images.size() );
+  if( depth == CV_32S )
+    parallel_for_( range, HaarBatchInvoker<int>( images, featureIdx, firstArea, offsets, weights, response ) );
+  else if( depth == CV_32F )
+    parallel_for_( range, HaarBatchInvoker<float>( images, featureIdx, firstArea, offsets, weights, response ) );
+  else
+    parallel_for_( range, HaarBatchInvoker<double>( images, featureIdx, firstArea, offsets, weights, response ) );
+}
+
 void CvHaarEvaluator::setWinSize( Size patchSize )
 {
   winSize.width = patchSize.width;
@@ -754,6 +849,27 @@ float CvHaarEvaluator::FeatureHaar::getSum( const Mat& image, Rect imageROI ) co
   return value;
 }
 
+void CvHaarEvaluator::FeatureHaar::getIntegralOffsets( Size patchSize, int step, int* offsets, float* weights ) const
+{
+  for ( int curArea = 0; curArea < m_numAreas; curArea++, offsets += 4 )
+  {
+    //the same clipping as in getSum()
+    const Rect& area = m_areas[curArea];
+    int width = area.width;
+    int height = area.height;
+    if( area.x + width >= patchSize.width - 1 )
+      width = ( patchSize.width - 1 ) - area.x;
+    if( area.y + height >= patchSize.height - 1 )
+      height = ( patchSize.height - 1 ) - area.y;
+
+    offsets[0] = ( area.y + height ) * step + area.x + width;
+    offsets[1] = area.y * step + area.x;
+    offsets[2] = area.y * step + area.x + width;
+    offsets[3] = ( area.y + height ) * step + area.x;
+    weights[curArea] = m_scaleWeights[curArea];
+  }
+}
+
 int CvHaarEvaluator::FeatureHaar::getNumAreas()
 {
   return m_numAreas;
@@ -40,11 +40,12 @@
  //M*/
 
 #include "precomp.hpp"
+#include "sharedFrame.hpp"
 
 namespace cv {
 
   // constructor
-  MultiTracker::MultiTracker(const String& trackerType):defaultAlgorithm(trackerType){};
+  MultiTracker::MultiTracker(const String& trackerType):defaultAlgorithm(trackerType),parallelUpdate(false){};
 
   // destructor
   MultiTracker::~MultiTracker(){};
@@ -81,6 +82,9 @@ namespace cv {
     // status of the tracker addition
     bool stat=false;
 
+    // the trackers share preprocessed versions of the image
+    SharedFrame frame(image);
+
     // add tracker for all input objects
     for(unsigned i =0;i<boundingBox.size();i++){
       stat=add(trackerType,image,boundingBox[i]);
@@ -102,14 +106,43 @@ namespace cv {
     return add(defaultAlgorithm.c_str(), image, boundingBox);
   };
 
+  // updates a range of the trackers, each tracker is updated by one thread
+  class MultiTrackerUpdateInvoker : public ParallelLoopBody{
+  public:
+    MultiTrackerUpdateInvoker(const Mat& _image, std::vector< Ptr<Tracker> >& _trackerList, std::vector<Rect2d>& _objects)
+      :image(_image),trackerList(_trackerList),objects(_objects){}
+
+    void operator()(const Range& range) const{
+      for(int i=range.start;i<range.end;i++){
+        trackerList[i]->update(image, objects[i]);
+      }
+    }
+
+  private:
+    const Mat& image;
+    std::vector< Ptr<Tracker> >& trackerList;
+    std::vector<Rect2d>& objects;
+  };
+
   // update position of the tracked objects, the result is stored in internal storage
   bool MultiTracker::update( const Mat& image){
-    for(unsigned i=0;i< trackerList.size(); i++){
-      trackerList[i]->update(image, objects[i]);
-    }
+    // the trackers share preprocessed versions of the image
+    SharedFrame frame(image);
+
+    MultiTrackerUpdateInvoker invoker(image, trackerList, objects);
+    Range range(0, (int)trackerList.size());
+    if(parallelUpdate)
+      parallel_for_(range, invoker, (double)range.size());
+    else
+      invoker(range);
     return true;
   };
 
+  // switch between the sequential and parallel update of the trackers
+  void MultiTracker::setParallelUpdate(bool parallel){
+    parallelUpdate=parallel;
+  };
+
   // update position of the tracked objects, the result is copied to external variable
   bool MultiTracker::update( const Mat& image, std::vector<Rect2d> & boundingBox ){
     update(image);
@@ -0,0 +1,140 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2015, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "precomp.hpp"
+#include "opencv2/tracking/kalman_filters.hpp"
+
+namespace cv
+{
+namespace tracking
+{
+
+class MultiUKFPredictInvoker : public ParallelLoopBody
+{
+public:
+    MultiUKFPredictInvoker( const std::vector<Ptr<UnscentedKalmanFilter> >& _filters, const std::vector<Mat>& _controls,
+                            std::vector<Mat>& _states ) :
+        filters(_filters), controls(_controls), states(_states)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        for ( int i = range.start; i < range.end; i++ )
+            states[i] = controls.empty() ? filters[i]->predict() : filters[i]->predict( controls[i] );
+    }
+
+private:
+    const std::vector<Ptr<UnscentedKalmanFilter> >& filters;
+    const std::vector<Mat>& controls;
+    std::vector<Mat>& states;
+
+    MultiUKFPredictInvoker& operator=( const MultiUKFPredictInvoker& );
+};
+
+class MultiUKFCorrectInvoker : public ParallelLoopBody
+{
+public:
+    MultiUKFCorrectInvoker( const std::vector<Ptr<UnscentedKalmanFilter> >& _filters, const std::vector<Mat>& _measurements,
+                            std::vector<Mat>& _states ) :
+        filters(_filters), measurements(_measurements), states(_states)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        for ( int i = range.start; i < range.end; i++ )
+            if ( !measurements[i].empty() )
+                states[i] = filters[i]->correct( measurements[i] );
+    }
+
+private:
+    const std::vector<Ptr<UnscentedKalmanFilter> >& filters;
+    const std::vector<Mat>& measurements;
+    std::vector<Mat>& states;
+
+    MultiUKFCorrectInvoker& operator=( const MultiUKFCorrectInvoker& );
+};
+
+int MultiUnscentedKalmanFilter::add( const Ptr<UnscentedKalmanFilter>& filter )
+{
+    CV_Assert( !filter.empty() );
+    filters.push_back( filter );
+    states.push_back( filter->getState() );
+    return (int)filters.size() - 1;
+}
+
+void MultiUnscentedKalmanFilter::clear()
+{
+    filters.clear();
+    states.clear();
+}
+
+int MultiUnscentedKalmanFilter::size() const
+{
+    return (int)filters.size();
+}
+
+Ptr<UnscentedKalmanFilter> MultiUnscentedKalmanFilter::getFilter( int idx ) const
+{
+    CV_Assert( idx >= 0 && idx < (int)filters.size() );
+    return filters[idx];
+}
+
+void MultiUnscentedKalmanFilter::predict( const std::vector<Mat>& controls )
+{
+    CV_Assert( controls.empty() || controls.size() == filters.size() );
+    parallel_for_( Range( 0, (int)filters.size() ), MultiUKFPredictInvoker( filters, controls, states ) );
+}
+
+void MultiUnscentedKalmanFilter::correct( const std::vector<Mat>& measurements )
+{
+    CV_Assert( measurements.size() == filters.size() );
+    parallel_for_( Range( 0, (int)filters.size() ), MultiUKFCorrectInvoker( filters, measurements, states ) );
+}
+
+const std::vector<Mat>& MultiUnscentedKalmanFilter::getStates() const
+{
+    return states;
+}
+
+} // tracking
+} // cv
@@ -296,12 +296,15 @@ void BaseClassifier::trainClassifier( const Mat& image, int target, float import
     K++;
   }
 
-  for ( int curK = 0; curK <= K; curK++ )
+  //the weak classifiers are independent, so each one is trained K+1 times in a row while its statistics are hot
+  for ( int curWeakClassifier = 0; curWeakClassifier < m_numWeakClassifier + m_iterationInit; curWeakClassifier++ )
   {
-    for ( int curWeakClassifier = 0; curWeakClassifier < m_numWeakClassifier + m_iterationInit; curWeakClassifier++ )
-    {
-      errorMask[curWeakClassifier] = weakClassifier[curWeakClassifier]->update( image.at<float>( curWeakClassifier ), target );
-    }
+    WeakClassifierHaarFeature* weak = weakClassifier[curWeakClassifier];
+    float value = image.at<float>( curWeakClassifier );
+    bool error = false;
+    for ( int curK = 0; curK <= K; curK++ )
+      error = weak->update( value, target );
+    errorMask[curWeakClassifier] = error;
   }
 
 }
@@ -537,6 +540,40 @@ int WeakClassifierHaarFeature::eval( float value )
   return m_classifier->eval( value );
 }
 
+//confidences of the patches of a grid row block, the strong classifier is only read
+class DetectorEvalInvoker : public ParallelLoopBody
+{
+ public:
+  DetectorEvalInvoker( StrongClassifierDirectSelection* _classifier, const std::vector<Mat>& _images, std::vector<float>& _confidences,
+                       Mat_<float>& _confMatrix ) :
+      classifier( _classifier ), images( _images ), confidences( _confidences ), confMatrix( _confMatrix )
+  {
+  }
+
+  void operator()( const Range& range ) const
+  {
+    for ( int row = range.start; row < range.end; row++ )
+    {
+      int curPatch = row * confMatrix.cols;
+      for ( int col = 0; col < confMatrix.cols; col++, curPatch++ )
+      {
+        confidences[curPatch] = classifier->eval( images[curPatch] );
+
+        // fill matrix
+        confMatrix( row, col ) = confidences[curPatch];
+      }
+    }
+  }
+
+ private:
+  StrongClassifierDirectSelection* classifier;
+  const std::vector<Mat>& images;
+  std::vector<float>& confidences;
+  Mat_<float>& confMatrix;
+
+  DetectorEvalInvoker& operator=( const DetectorEvalInvoker& );
+};
+
 Detector::Detector( StrongClassifierDirectSelection* classifier ) :
     m_sizeDetections( 0 )
 {
@@ -602,19 +639,8 @@ void Detector::classifySmooth( const std::vector<Mat>& images, float minMargin )
     m_confImageDisplay.create( patchGrid.height, patchGrid.width );
   }
 
-  int curPatch = 0;
   // Eval and filter
-  for ( int row = 0; row < patchGrid.height; row++ )
-  {
-    for ( int col = 0; col < patchGrid.width; col++ )
-    {
-      m_confidences[curPatch] = m_classifier->eval( images[curPatch] );
-
-      // fill matrix
-      m_confMatrix( row, col ) = m_confidences[curPatch];
-      curPatch++;
-    }
-  }
+  parallel_for_( Range( 0, patchGrid.height ), DetectorEvalInvoker( m_classifier, images, m_confidences, m_confMatrix ) );
 
   // Filter
   //cv::GaussianBlur(m_confMatrix,m_confMatrixSmooth,cv::Size(3,3),0.8);
@@ -634,7 +660,7 @@ void Detector::classifySmooth( const std::vector<Mat>& images, float minMargin )
   }
 
   // Get best detection
-  curPatch = 0;
+  int curPatch = 0;
   for ( int row = 0; row < patchGrid.height; row++ )
   {
     for ( int col = 0; col < patchGrid.width; col++ )
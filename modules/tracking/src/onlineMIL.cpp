@@ -41,59 +41,163 @@
 
 #include "precomp.hpp"
 #include "opencv2/tracking/onlineMIL.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #define  sign(s)  ((s > 0 ) ? 1 : ((s<0) ? -1 : 0))
 
-template<class T> class SortableElementRev
+namespace cv
+{
+
+static void addRow( const float* x, const float* y, float* dst, int len )
+{
+  int i = 0;
+#if CV_SIMD128
+  for ( ; i <= len - 4; i += 4 )
+    v_store( dst + i, v_load( x + i ) + v_load( y + i ) );
+#endif
+  for ( ; i < len; i++ )
+    dst[i] = x[i] + y[i];
+}
+
+//replaces exp(z) by bias + 1 / (1 + exp(z)), i.e. bias + 1 - sigmoid(z)
+static void complementSigmoidRow( float* buf, float bias, int len )
+{
+  int i = 0;
+#if CV_SIMD128
+  v_float32x4 v_one = v_setall_f32( 1.0f ), v_bias = v_setall_f32( bias );
+  for ( ; i <= len - 4; i += 4 )
+    v_store( buf + i, v_bias + v_one / ( v_one + v_load( buf + i ) ) );
+#endif
+  for ( ; i < len; i++ )
+    buf[i] = bias + 1.0f / ( 1.0f + buf[i] );
+}
+
+class ClfMilBoostTrainInvoker : public ParallelLoopBody
 {
  public:
-  T _val;
-  int _ind;
-  SortableElementRev() :
-      _ind( 0 )
-  {
-  }
-  SortableElementRev( T val, int ind )
+  ClfMilBoostTrainInvoker( const std::vector<ClfOnlineStump*>& _weakclf, const Mat& _posx, const Mat& _negx, Mat& _pospred, Mat& _negpred ) :
+      weakclf( _weakclf ), posx( _posx ), negx( _negx ), pospred( _pospred ), negpred( _negpred )
   {
-    _val = val;
-    _ind = ind;
   }
-  bool operator<( SortableElementRev<T> &b )
+
+  void operator()( const Range& range ) const
   {
-    return ( _val < b._val );
+    int numpos = posx.empty() ? 0 : posx.cols;
+    int numneg = negx.empty() ? 0 : negx.cols;
+    for ( int m = range.start; m < range.end; m++ )
+    {
+      const float* pos = numpos > 0 ? posx.ptr<float>( m ) : 0;
+      const float* neg = numneg > 0 ? negx.ptr<float>( m ) : 0;
+      weakclf[m]->update( pos, numpos, neg, numneg );
+      if( numpos > 0 )
+        weakclf[m]->classifySetF( pos, numpos, pospred.ptr<float>( m ) );
+      if( numneg > 0 )
+        weakclf[m]->classifySetF( neg, numneg, negpred.ptr<float>( m ) );
+    }
   }
-  ;
+
+ private:
+  const std::vector<ClfOnlineStump*>& weakclf;
+  const Mat& posx;
+  const Mat& negx;
+  Mat& pospred;
+  Mat& negpred;
+
+  ClfMilBoostTrainInvoker& operator=( const ClfMilBoostTrainInvoker& );
 };
 
-static bool CompareSortableElementRev( const SortableElementRev<float>& i, const SortableElementRev<float>& j )
+//bag likelihood of the strong classifier extended by each of the not yet selected weak classifiers
+class ClfMilBoostLikelihoodInvoker : public ParallelLoopBody
 {
-  return i._val < j._val;
-}
+ public:
+  ClfMilBoostLikelihoodInvoker( const Mat& _pospred, const Mat& _negpred, const std::vector<float>& _Hpos, const std::vector<float>& _Hneg,
+                                const std::vector<uchar>& _selected, std::vector<float>& _likl ) :
+      pospred( _pospred ), negpred( _negpred ), Hpos( _Hpos ), Hneg( _Hneg ), selected( _selected ), likl( _likl )
+  {
+  }
+
+  void operator()( const Range& range ) const
+  {
+    int numpos = (int) Hpos.size();
+    int numneg = (int) Hneg.size();
+    AutoBuffer<float> _buf( std::max( numpos, numneg ) + 1 );
+    float* buf = _buf;
+    Mat posbuf( 1, numpos, CV_32F, buf ), negbuf( 1, numneg, CV_32F, buf );
+
+    for ( int w = range.start; w < range.end; w++ )
+    {
+      if( selected[w] )
+      {
+        likl[w] = FLT_MAX;
+        continue;
+      }
+
+      //probability that no positive sample is positive
+      float lll = 1.0f;
+      if( numpos > 0 )
+      {
+        addRow( &Hpos[0], pospred.ptr<float>( w ), buf, numpos );
+        exp( posbuf, posbuf );
+        complementSigmoidRow( buf, 0.0f, numpos );
+        for ( int j = 0; j < numpos; j++ )
+          lll *= buf[j];
+      }
+      float poslikl = (float) -log( 1 - lll + 1e-5 );
+
+      float neglikl = 0.0f;
+      if( numneg > 0 )
+      {
+        addRow( &Hneg[0], negpred.ptr<float>( w ), buf, numneg );
+        exp( negbuf, negbuf );
+        complementSigmoidRow( buf, 1e-5f, numneg );
+        log( negbuf, negbuf );
+        for ( int j = 0; j < numneg; j++ )
+          neglikl -= buf[j];
+      }
+
+      likl[w] = poslikl / numpos + neglikl / numneg;
+    }
+  }
 
-template<class T> void sort_order_des( std::vector<T> &v, std::vector<int> &order )
+ private:
+  const Mat& pospred;
+  const Mat& negpred;
+  const std::vector<float>& Hpos;
+  const std::vector<float>& Hneg;
+  const std::vector<uchar>& selected;
+  std::vector<float>& likl;
+
+  ClfMilBoostLikelihoodInvoker& operator=( const ClfMilBoostLikelihoodInvoker& );
+};
+
+class ClfMilBoostClassifyInvoker : public ParallelLoopBody
 {
-  uint n = (uint) v.size();
-  std::vector<SortableElementRev<T> > v2;
-  v2.resize( n );
-  order.clear();
-  order.resize( n );
-  for ( uint i = 0; i < n; i++ )
+ public:
+  ClfMilBoostClassifyInvoker( const std::vector<ClfOnlineStump*>& _weakclf, const std::vector<int>& _selectors, const Mat& _x,
+                              std::vector<float>& _res ) :
+      weakclf( _weakclf ), selectors( _selectors ), x( _x ), res( _res )
   {
-    v2[i]._ind = i;
-    v2[i]._val = v[i];
   }
-  //std::sort( v2.begin(), v2.end() );
-  std::sort( v2.begin(), v2.end(), CompareSortableElementRev );
-  for ( uint i = 0; i < n; i++ )
+
+  void operator()( const Range& range ) const
   {
-    order[i] = v2[i]._ind;
-    v[i] = v2[i]._val;
+    for ( int j = range.start; j < range.end; j++ )
+    {
+      float r = 0.0f;
+      for ( size_t w = 0; w < selectors.size(); w++ )
+        r += weakclf[selectors[w]]->classifyF( x, j );
+      res[j] = r;
+    }
   }
-}
-;
 
-namespace cv
-{
+ private:
+  const std::vector<ClfOnlineStump*>& weakclf;
+  const std::vector<int>& selectors;
+  const Mat& x;
+  std::vector<float>& res;
+
+  ClfMilBoostClassifyInvoker& operator=( const ClfMilBoostClassifyInvoker& );
+};
 
 //implementations for strong classifier
 
@@ -137,8 +241,10 @@ void ClfMilBoost::init( const ClfMilBoost::Params &parameters )
 
 void ClfMilBoost::update( const Mat& posx, const Mat& negx )
 {
+  CV_Assert( posx.type() == CV_32F && negx.type() == CV_32F );
   int numneg = negx.rows;
   int numpos = posx.rows;
+  int numweak = (int) _weakclf.size();
 
   // compute ftrs
   //if( !posx.ftrsComputed() )
@@ -147,74 +253,42 @@ void ClfMilBoost::update( const Mat& posx, const Mat& negx )
   //  Ftr::compute( negx, _ftrs );
 
   // initialize H
-  static std::vector<float> Hpos, Hneg;
-  Hpos.clear();
-  Hneg.clear();
-  Hpos.resize( posx.rows, 0.0f ), Hneg.resize( negx.rows, 0.0f );
+  std::vector<float> Hpos( numpos, 0.0f ), Hneg( numneg, 0.0f );
 
   _selectors.clear();
-  std::vector<float> posw( posx.rows ), negw( negx.rows );
-  std::vector<std::vector<float> > pospred( _weakclf.size() ), negpred( _weakclf.size() );
+
+  // feature-major layout, so that the values of a weak classifier are contiguous over the samples
+  transpose( posx, _posx );
+  transpose( negx, _negx );
+  _pospred.create( numweak, numpos, CV_32F );
+  _negpred.create( numweak, numneg, CV_32F );
 
   // train all weak classifiers without weights
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-  for ( int m = 0; m < _myParams._numFeat; m++ )
-  {
-    _weakclf[m]->update( posx, negx );
-    pospred[m] = _weakclf[m]->classifySetF( posx );
-    negpred[m] = _weakclf[m]->classifySetF( negx );
-  }
+  parallel_for_( Range( 0, numweak ), ClfMilBoostTrainInvoker( _weakclf, _posx, _negx, _pospred, _negpred ) );
 
   // pick the best features
+  std::vector<float> likl( numweak );
+  std::vector<uchar> selected( numweak, 0 );
   for ( int s = 0; s < _myParams._numSel; s++ )
   {
-
     // compute errors/likl for all weak clfs
-    std::vector<float> poslikl( _weakclf.size(), 1.0f ), neglikl( _weakclf.size() ), likl( _weakclf.size() );
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-    for ( int w = 0; w < (int) _weakclf.size(); w++ )
-    {
-      float lll = 1.0f;
-      for ( int j = 0; j < numpos; j++ )
-        lll *= ( 1 - sigmoid( Hpos[j] + pospred[w][j] ) );
-      poslikl[w] = (float) -log( 1 - lll + 1e-5 );
-
-      lll = 0.0f;
-      for ( int j = 0; j < numneg; j++ )
-        lll += (float) -log( 1e-5f + 1 - sigmoid( Hneg[j] + negpred[w][j] ) );
-      neglikl[w] = lll;
-
-      likl[w] = poslikl[w] / numpos + neglikl[w] / numneg;
-    }
-
-    // pick best weak clf
-    std::vector<int> order;
-    sort_order_des( likl, order );
-
-    // find best weakclf that isn't already included
-    for ( uint k = 0; k < order.size(); k++ )
-      if( std::count( _selectors.begin(), _selectors.end(), order[k] ) == 0 )
-      {
-        _selectors.push_back( order[k] );
-        break;
-      }
+    parallel_for_( Range( 0, numweak ), ClfMilBoostLikelihoodInvoker( _pospred, _negpred, Hpos, Hneg, selected, likl ) );
+
+    // pick best weak clf that isn't already included, the first one on ties
+    int best = -1;
+    for ( int w = 0; w < numweak; w++ )
+      if( !selected[w] && ( best < 0 || likl[w] < likl[best] ) )
+        best = w;
+    if( best < 0 )
+      break;
+    _selectors.push_back( best );
+    selected[best] = 1;
 
     // update H = H + h_m
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-    for ( int k = 0; k < posx.rows; k++ )
-      Hpos[k] += pospred[_selectors[s]][k];
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-    for ( int k = 0; k < negx.rows; k++ )
-      Hneg[k] += negpred[_selectors[s]][k];
-
+    if( numpos > 0 )
+      addRow( &Hpos[0], _pospred.ptr<float>( best ), &Hpos[0], numpos );
+    if( numneg > 0 )
+      addRow( &Hneg[0], _negpred.ptr<float>( best ), &Hneg[0], numneg );
   }
 
   //if( _myParams->_storeFtrHistory )
@@ -230,26 +304,12 @@ std::vector<float> ClfMilBoost::classify( const Mat& x, bool logR )
 {
   int numsamples = x.rows;
   std::vector<float> res( numsamples );
-  std::vector<float> tr;
 
-  for ( uint w = 0; w < _selectors.size(); w++ )
-  {
-    tr = _weakclf[_selectors[w]]->classifySetF( x );
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-    for ( int j = 0; j < numsamples; j++ )
-    {
-      res[j] += tr[j];
-    }
-  }
+  parallel_for_( Range( 0, numsamples ), ClfMilBoostClassifyInvoker( _weakclf, _selectors, x, res ) );
 
   // return probabilities or log odds ratio
   if( !logR )
   {
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
     for ( int j = 0; j < (int) res.size(); j++ )
     {
       res[j] = sigmoid( res[j] );
@@ -287,67 +347,56 @@ void ClfOnlineStump::init()
 void ClfOnlineStump::update( const Mat& posx, const Mat& negx, const Mat_<float>& /*posw*/, const Mat_<float>& /*negw*/)
 {
   //std::cout << " ClfOnlineStump::update" << _ind << std::endl;
-  float posmu = 0.0, negmu = 0.0;
+  Mat pos, neg;
   if( posx.cols > 0 )
-    posmu = float( mean( posx.col( _ind ) )[0] );
+    posx.col( _ind ).copyTo( pos );
   if( negx.cols > 0 )
-    negmu = float( mean( negx.col( _ind ) )[0] );
+    negx.col( _ind ).copyTo( neg );
 
-  if( _trained )
+  update( pos.ptr<float>(), pos.rows, neg.ptr<float>(), neg.rows );
+}
+
+static void updateGaussian( const float* x, int n, float lRate, bool trained, float& mu, float& sig )
+{
+  Mat values( 1, n, CV_32F, (void*) x );
+  if( trained )
   {
-    if( posx.cols > 0 )
-    {
-      _mu1 = ( _lRate * _mu1 + ( 1 - _lRate ) * posmu );
-      cv::Mat diff = posx.col( _ind ) - _mu1;
-      _sig1 = _lRate * _sig1 + ( 1 - _lRate ) * float( mean( diff.mul( diff ) )[0] );
-    }
-    if( negx.cols > 0 )
+    mu = ( lRate * mu + ( 1 - lRate ) * float( mean( values )[0] ) );
+    double sqsum = 0;
+    for ( int k = 0; k < n; k++ )
     {
-      _mu0 = ( _lRate * _mu0 + ( 1 - _lRate ) * negmu );
-      cv::Mat diff = negx.col( _ind ) - _mu0;
-      _sig0 = _lRate * _sig0 + ( 1 - _lRate ) * float( mean( diff.mul( diff ) )[0] );
+      float diff = x[k] - mu;
+      sqsum += diff * diff;
     }
-
-    _q = ( _mu1 - _mu0 ) / 2;
-    _s = sign( _mu1 - _mu0 );
-    _log_n0 = std::log( float( 1.0f / pow( _sig0, 0.5f ) ) );
-    _log_n1 = std::log( float( 1.0f / pow( _sig1, 0.5f ) ) );
-    //_e1 = -1.0f/(2.0f*_sig1+1e-99f);
-    //_e0 = -1.0f/(2.0f*_sig0+1e-99f);
-    _e1 = -1.0f / ( 2.0f * _sig1 + std::numeric_limits<float>::min() );
-    _e0 = -1.0f / ( 2.0f * _sig0 + std::numeric_limits<float>::min() );
-
+    sig = lRate * sig + ( 1 - lRate ) * float( sqsum / n );
   }
   else
   {
-    _trained = true;
-    if( posx.cols > 0 )
-    {
-      _mu1 = posmu;
-      cv::Scalar scal_mean, scal_std_dev;
-      cv::meanStdDev( posx.col( _ind ), scal_mean, scal_std_dev );
-      _sig1 = float( scal_std_dev[0] ) * float( scal_std_dev[0] ) + 1e-9f;
-    }
-
-    if( negx.cols > 0 )
-    {
-      _mu0 = negmu;
-      cv::Scalar scal_mean, scal_std_dev;
-      cv::meanStdDev( negx.col( _ind ), scal_mean, scal_std_dev );
-      _sig0 = float( scal_std_dev[0] ) * float( scal_std_dev[0] ) + 1e-9f;
-    }
-
-    _q = ( _mu1 - _mu0 ) / 2;
-    _s = sign( _mu1 - _mu0 );
-    _log_n0 = std::log( float( 1.0f / pow( _sig0, 0.5f ) ) );
-    _log_n1 = std::log( float( 1.0f / pow( _sig1, 0.5f ) ) );
-    //_e1 = -1.0f/(2.0f*_sig1+1e-99f);
-    //_e0 = -1.0f/(2.0f*_sig0+1e-99f);
-    _e1 = -1.0f / ( 2.0f * _sig1 + std::numeric_limits<float>::min() );
-    _e0 = -1.0f / ( 2.0f * _sig0 + std::numeric_limits<float>::min() );
+    cv::Scalar scal_mean, scal_std_dev;
+    cv::meanStdDev( values, scal_mean, scal_std_dev );
+    mu = float( scal_mean[0] );
+    sig = float( scal_std_dev[0] ) * float( scal_std_dev[0] ) + 1e-9f;
   }
 }
 
+void ClfOnlineStump::update( const float* posx, int numpos, const float* negx, int numneg )
+{
+  if( numpos > 0 )
+    updateGaussian( posx, numpos, _lRate, _trained, _mu1, _sig1 );
+  if( numneg > 0 )
+    updateGaussian( negx, numneg, _lRate, _trained, _mu0, _sig0 );
+  _trained = true;
+
+  _q = ( _mu1 - _mu0 ) / 2;
+  _s = sign( _mu1 - _mu0 );
+  _log_n0 = std::log( float( 1.0f / pow( _sig0, 0.5f ) ) );
+  _log_n1 = std::log( float( 1.0f / pow( _sig1, 0.5f ) ) );
+  //_e1 = -1.0f/(2.0f*_sig1+1e-99f);
+  //_e0 = -1.0f/(2.0f*_sig0+1e-99f);
+  _e1 = -1.0f / ( 2.0f * _sig1 + std::numeric_limits<float>::min() );
+  _e0 = -1.0f / ( 2.0f * _sig0 + std::numeric_limits<float>::min() );
+}
+
 bool ClfOnlineStump::classify( const Mat& x, int i )
 {
   float xx = x.at<float>( i, _ind );
@@ -368,9 +417,6 @@ inline std::vector<float> ClfOnlineStump::classifySetF( const Mat& x )
 {
   std::vector<float> res( x.rows );
 
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
   for ( int k = 0; k < (int) res.size(); k++ )
   {
     res[k] = classifyF( x, k );
@@ -378,4 +424,25 @@ inline std::vector<float> ClfOnlineStump::classifySetF( const Mat& x )
   return res;
 }
 
+void ClfOnlineStump::classifySetF( const float* x, int n, float* res ) const
+{
+  int k = 0;
+#if CV_SIMD128
+  v_float32x4 v_mu0 = v_setall_f32( _mu0 ), v_mu1 = v_setall_f32( _mu1 );
+  v_float32x4 v_e0 = v_setall_f32( _e0 ), v_e1 = v_setall_f32( _e1 );
+  v_float32x4 v_log_n0 = v_setall_f32( _log_n0 ), v_log_n1 = v_setall_f32( _log_n1 );
+  for ( ; k <= n - 4; k += 4 )
+  {
+    v_float32x4 v_x = v_load( x + k );
+    v_float32x4 d0 = v_x - v_mu0, d1 = v_x - v_mu1;
+    v_store( res + k, ( d1 * d1 * v_e1 + v_log_n1 ) - ( d0 * d0 * v_e0 + v_log_n0 ) );
+  }
+#endif
+  for ( ; k < n; k++ )
+  {
+    float d0 = x[k] - _mu0, d1 = x[k] - _mu1;
+    res[k] = ( d1 * d1 * _e1 + _log_n1 ) - ( d0 * d0 * _e0 + _log_n0 );
+  }
+}
+
 } /* namespace cv */
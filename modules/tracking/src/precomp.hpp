@@ -48,7 +48,9 @@
 
 namespace cv
 {
-	extern const double ColorNames[][10];
+	extern const uchar ColorNames[][10];
+	extern const double ColorNamesScale[10];
+	extern const double ColorNamesShift[10];
 }
 
 #endif
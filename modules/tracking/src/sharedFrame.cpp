@@ -0,0 +1,163 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "sharedFrame.hpp"
+#include "opencv2/imgproc.hpp"
+#include <algorithm>
+
+namespace cv
+{
+
+struct SharedFrameEntry
+{
+  SharedFrameEntry( SharedFrame::Preprocessing _fn, SharedFrame::PyramidPreprocessing _pyramidFn ) :
+      fn( _fn ), pyramidFn( _pyramidFn ), ready( false ) {}
+
+  SharedFrame::Preprocessing fn;
+  SharedFrame::PyramidPreprocessing pyramidFn;
+  Mutex mutex;
+  bool ready;
+  Mat result;
+  std::vector<Mat> pyramid;
+};
+
+struct SharedFrame::Data
+{
+  Mat image;
+  Mutex mutex;
+  std::vector<Ptr<SharedFrameEntry> > entries;
+
+  bool isFrameOf( const Mat& other ) const
+  {
+    return image.data == other.data && image.size() == other.size() && image.type() == other.type() && image.step == other.step;
+  }
+
+  Ptr<SharedFrameEntry> getEntry( Preprocessing fn, PyramidPreprocessing pyramidFn )
+  {
+    AutoLock lock( mutex );
+    for ( size_t i = 0; i < entries.size(); i++ )
+    {
+      if( entries[i]->fn == fn && entries[i]->pyramidFn == pyramidFn )
+        return entries[i];
+    }
+    entries.push_back( makePtr<SharedFrameEntry>( fn, pyramidFn ) );
+    return entries.back();
+  }
+};
+
+//frames which are shared at the moment
+static Mutex sharedFramesMutex;
+static std::vector<Ptr<SharedFrame::Data> > sharedFrames;
+
+SharedFrame::SharedFrame( const Mat& image ) :
+    data( makePtr<Data>() )
+{
+  data->image = image;
+
+  AutoLock lock( sharedFramesMutex );
+  sharedFrames.push_back( data );
+}
+
+SharedFrame::~SharedFrame()
+{
+  AutoLock lock( sharedFramesMutex );
+  sharedFrames.erase( std::find( sharedFrames.begin(), sharedFrames.end(), data ) );
+}
+
+static Ptr<SharedFrame::Data> findSharedFrame( const Mat& image )
+{
+  AutoLock lock( sharedFramesMutex );
+  for ( size_t i = 0; i < sharedFrames.size(); i++ )
+  {
+    if( sharedFrames[i]->isFrameOf( image ) )
+      return sharedFrames[i];
+  }
+  return Ptr<SharedFrame::Data>();
+}
+
+void SharedFrame::preprocess( const Mat& image, Preprocessing fn, Mat& result )
+{
+  Ptr<Data> frame = findSharedFrame( image );
+  if( frame.empty() )
+  {
+    fn( image, result );
+    return;
+  }
+
+  //different preprocessings of the frame can be computed simultaneously
+  Ptr<SharedFrameEntry> entry = frame->getEntry( fn, NULL );
+  AutoLock lock( entry->mutex );
+  if( !entry->ready )
+  {
+    fn( frame->image, entry->result );
+    entry->ready = true;
+  }
+  result = entry->result;
+}
+
+void SharedFrame::preprocess( const Mat& image, PyramidPreprocessing fn, std::vector<Mat>& result )
+{
+  Ptr<Data> frame = findSharedFrame( image );
+  if( frame.empty() )
+  {
+    fn( image, result );
+    return;
+  }
+
+  Ptr<SharedFrameEntry> entry = frame->getEntry( NULL, fn );
+  AutoLock lock( entry->mutex );
+  if( !entry->ready )
+  {
+    fn( frame->image, entry->pyramid );
+    entry->ready = true;
+  }
+  result = entry->pyramid;
+}
+
+void convertToGray( const Mat& image, Mat& gray )
+{
+  if( image.channels() == 1 )
+    gray = image;
+  else
+    cvtColor( image, gray, COLOR_BGR2GRAY );
+}
+
+} /* namespace cv */
@@ -0,0 +1,99 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#ifndef __OPENCV_SHARED_FRAME_HPP__
+#define __OPENCV_SHARED_FRAME_HPP__
+
+#include "precomp.hpp"
+
+namespace cv
+{
+
+/**
+ * \brief Cache of preprocessed versions of the frame, e.g. grayscale or integral images,
+ * shared by the trackers which are updated with the same frame.
+ *
+ * Preprocessed images are cached only while the SharedFrame object for the frame exists,
+ * MultiTracker creates it for the duration of add() and update(). Otherwise preprocess()
+ * just computes the result.
+ */
+class SharedFrame
+{
+ public:
+  typedef void (*Preprocessing)( const Mat& image, Mat& result );
+  typedef void (*PyramidPreprocessing)( const Mat& image, std::vector<Mat>& result );
+
+  /**
+   * \brief Makes preprocessed versions of the image available to the trackers while the object exists
+   */
+  explicit SharedFrame( const Mat& image );
+  ~SharedFrame();
+
+  /**
+   * \brief Computes fn( image, result ) or takes the result computed for the shared frame.
+   * Each preprocessing of the shared frame is computed once, by the first tracker which requests it.
+   * The result must not be modified by the caller. Thread-safe.
+   */
+  static void preprocess( const Mat& image, Preprocessing fn, Mat& result );
+
+  /**
+   * \brief The same for the preprocessings which produce several images, e.g. image pyramids
+   */
+  static void preprocess( const Mat& image, PyramidPreprocessing fn, std::vector<Mat>& result );
+
+  struct Data;
+
+ private:
+  Ptr<Data> data;
+
+  SharedFrame( const SharedFrame& );
+  SharedFrame& operator=( const SharedFrame& );
+};
+
+/**
+ * \brief Converts BGR or BGRA image to grayscale, grayscale image is returned as is.
+ * Can be passed to SharedFrame::preprocess()
+ */
+void convertToGray( const Mat& image, Mat& gray );
+
+} /* namespace cv */
+
+#endif
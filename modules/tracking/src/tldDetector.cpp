@@ -45,11 +45,77 @@ namespace cv
 {
 	namespace tld
 	{
+		// Evaluates the ensemble classifier on the windows of one pyramid level, the windows are split across the threads
+		class EnsembleClassifierInvoker : public ParallelLoopBody
+		{
+		public:
+			EnsembleClassifierInvoker(const Mat& _img, const std::vector<Point>& _windows, const std::vector<TLDEnsembleClassifier>& _classifiers,
+				const std::vector<int>& _offsets, std::vector<uchar>& _passed) :
+				img(_img), windows(_windows), classifiers(_classifiers), offsets(_offsets), passed(_passed)
+			{
+			}
+
+			void operator()(const Range& range) const
+			{
+				int numClassifiers = (int)classifiers.size();
+				for (int i = range.start; i < range.end; i++)
+				{
+					const uchar* data = img.ptr<uchar>(windows[i].y) + windows[i].x;
+					const int* offset = &offsets[0];
+					double p = 0;
+					for (int k = 0; k < numClassifiers; k++)
+					{
+						const TLDEnsembleClassifier& classifier = classifiers[k];
+						int position = 0;
+						for (int n = 0, nmax = (int)classifier.measurements.size(); n < nmax; n++, offset += 2)
+							position = (position << 1) + (data[offset[0]] < data[offset[1]] ? 1 : 0);
+
+						const Point2i& posAndNeg = classifier.posAndNeg[position];
+						if (posAndNeg.x + posAndNeg.y > 0)
+							p += (double)posAndNeg.x / (posAndNeg.x + posAndNeg.y);
+					}
+					passed[i] = p / numClassifiers > ENSEMBLE_THRESHOLD;
+				}
+			}
+
+		private:
+			const Mat& img;
+			const std::vector<Point>& windows;
+			const std::vector<TLDEnsembleClassifier>& classifiers;
+			const std::vector<int>& offsets;
+			std::vector<uchar>& passed;
+
+			EnsembleClassifierInvoker& operator=(const EnsembleClassifierInvoker&);
+		};
+
 		// Calculate offsets for classifiers
 		void TLDDetector::prepareClassifiers(int rowstep)
 		{
+			offsets.clear();
 			for (int i = 0; i < (int)classifiers.size(); i++)
+			{
 				classifiers[i].prepareClassifier(rowstep);
+				for (int j = 0; j < (int)classifiers[i].offset.size(); j++)
+				{
+					offsets.push_back(classifiers[i].offset[j].x);
+					offsets.push_back(classifiers[i].offset[j].y);
+				}
+			}
+		}
+
+		// Filter the windows of one pyramid level by the ensemble classifier, the passed windows are appended to res in the same order
+		void TLDDetector::ensembleClassify(const Mat& imgBlurred, const std::vector<Point>& windows, std::vector<Point>& res)
+		{
+			if (windows.empty())
+				return;
+
+			prepareClassifiers((int)imgBlurred.step[0]);
+			ensemblePassed.resize(windows.size());
+			parallel_for_(Range(0, (int)windows.size()), EnsembleClassifierInvoker(imgBlurred, windows, classifiers, offsets, ensemblePassed));
+
+			for (size_t i = 0; i < windows.size(); i++)
+				if (ensemblePassed[i])
+					res.push_back(windows[i]);
 		}
 
 		// Calculate posterior probability, that the patch belongs to the current EC model
@@ -302,56 +368,18 @@ namespace cv
 		{
 			patches.clear();
 			Mat_<uchar> standardPatch(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE);
-			Mat tmp;
-			int dx = initSize.width / 10, dy = initSize.height / 10;
-			Size2d size = img.size();
-			double scale = 1.0;
 			int npos = 0, nneg = 0;
 			double maxSc = -5.0;
 			Rect2d maxScRect;
-			int scaleID;
-			std::vector <Mat> resized_imgs, blurred_imgs;
-			std::vector <Point> varBuffer, ensBuffer;
-			std::vector <int> varScaleIDs, ensScaleIDs;
+			std::vector <Mat> resized_imgs;
+			std::vector <std::vector <Point> > ensBuffers;
+			std::vector <std::vector <int> > ensScaleIDsBuffers;
 
 			//Detection part
-			//Generate windows and filter by variance
-			scaleID = 0;
-			resized_imgs.push_back(img);
-			blurred_imgs.push_back(imgBlurred);
-			do
-			{
-				Mat_<double> intImgP, intImgP2;
-				computeIntegralImages(resized_imgs[scaleID], intImgP, intImgP2);
-				for (int i = 0, imax = cvFloor((0.0 + resized_imgs[scaleID].cols - initSize.width) / dx); i < imax; i++)
-				{
-					for (int j = 0, jmax = cvFloor((0.0 + resized_imgs[scaleID].rows - initSize.height) / dy); j < jmax; j++)
-					{
-						if (!patchVariance(intImgP, intImgP2, originalVariancePtr, Point(dx * i, dy * j), initSize))
-							continue;
-						varBuffer.push_back(Point(dx * i, dy * j));
-						varScaleIDs.push_back(scaleID);
-					}
-				}
-				scaleID++;
-				size.width /= SCALE_STEP;
-				size.height /= SCALE_STEP;
-				scale *= SCALE_STEP;
-				resize(img, tmp, size, 0, 0, DOWNSCALE_MODE);
-				resized_imgs.push_back(tmp);
-				GaussianBlur(resized_imgs[scaleID], tmp, GaussBlurKernelSize, 0.0f);
-				blurred_imgs.push_back(tmp);
-			} while (size.width >= initSize.width && size.height >= initSize.height);
-
-			//Encsemble classification
-			for (int i = 0; i < (int)varBuffer.size(); i++)
-			{
-				prepareClassifiers(static_cast<int> (blurred_imgs[varScaleIDs[i]].step[0]));
-				if (ensembleClassifierNum(&blurred_imgs[varScaleIDs[i]].at<uchar>(varBuffer[i].y, varBuffer[i].x)) <= ENSEMBLE_THRESHOLD)
-					continue;
-				ensBuffer.push_back(varBuffer[i]);
-				ensScaleIDs.push_back(varScaleIDs[i]);
-			}
+			//Generate windows and filter them by variance and by the ensemble classifier
+			scanPyramid(img, imgBlurred, initSize, std::vector<TLDDetector*>(1, this), resized_imgs, ensBuffers, ensScaleIDsBuffers);
+			const std::vector <Point>& ensBuffer = ensBuffers[0];
+			const std::vector <int>& ensScaleIDs = ensScaleIDsBuffers[0];
 
 			//NN classification
 			for (int i = 0; i < (int)ensBuffer.size(); i++)
@@ -402,56 +430,18 @@ namespace cv
 		{
 			patches.clear();
 			Mat_<uchar> standardPatch(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE);
-			Mat tmp;
-			int dx = initSize.width / 10, dy = initSize.height / 10;
-			Size2d size = img.size();
-			double scale = 1.0;
 			int npos = 0, nneg = 0;
 			double maxSc = -5.0;
 			Rect2d maxScRect;
-			int scaleID;
-			std::vector <Mat> resized_imgs, blurred_imgs;
-			std::vector <Point> varBuffer, ensBuffer;
-			std::vector <int> varScaleIDs, ensScaleIDs;
+			std::vector <Mat> resized_imgs;
+			std::vector <std::vector <Point> > ensBuffers;
+			std::vector <std::vector <int> > ensScaleIDsBuffers;
 
 			//Detection part
-			//Generate windows and filter by variance
-			scaleID = 0;
-			resized_imgs.push_back(img);
-			blurred_imgs.push_back(imgBlurred);
-			do
-			{
-				Mat_<double> intImgP, intImgP2;
-				computeIntegralImages(resized_imgs[scaleID], intImgP, intImgP2);
-				for (int i = 0, imax = cvFloor((0.0 + resized_imgs[scaleID].cols - initSize.width) / dx); i < imax; i++)
-				{
-					for (int j = 0, jmax = cvFloor((0.0 + resized_imgs[scaleID].rows - initSize.height) / dy); j < jmax; j++)
-					{
-						if (!patchVariance(intImgP, intImgP2, originalVariancePtr, Point(dx * i, dy * j), initSize))
-							continue;
-						varBuffer.push_back(Point(dx * i, dy * j));
-						varScaleIDs.push_back(scaleID);
-					}
-				}
-				scaleID++;
-				size.width /= SCALE_STEP;
-				size.height /= SCALE_STEP;
-				scale *= SCALE_STEP;
-				resize(img, tmp, size, 0, 0, DOWNSCALE_MODE);
-				resized_imgs.push_back(tmp);
-				GaussianBlur(resized_imgs[scaleID], tmp, GaussBlurKernelSize, 0.0f);
-				blurred_imgs.push_back(tmp);
-			} while (size.width >= initSize.width && size.height >= initSize.height);
-
-			//Encsemble classification
-			for (int i = 0; i < (int)varBuffer.size(); i++)
-			{
-				prepareClassifiers((int)blurred_imgs[varScaleIDs[i]].step[0]);
-				if (ensembleClassifierNum(&blurred_imgs[varScaleIDs[i]].at<uchar>(varBuffer[i].y, varBuffer[i].x)) <= ENSEMBLE_THRESHOLD)
-					continue;
-				ensBuffer.push_back(varBuffer[i]);
-				ensScaleIDs.push_back(varScaleIDs[i]);
-			}
+			//Generate windows and filter them by variance and by the ensemble classifier
+			scanPyramid(img, imgBlurred, initSize, std::vector<TLDDetector*>(1, this), resized_imgs, ensBuffers, ensScaleIDsBuffers);
+			const std::vector <Point>& ensBuffer = ensBuffers[0];
+			const std::vector <int>& ensScaleIDs = ensScaleIDsBuffers[0];
 
 			//NN classification
 			//Prepare batch of patches
@@ -514,29 +504,76 @@ namespace cv
 		}
 #endif // HAVE_OPENCL
 
-		// Computes the variance of subimage given by box, with the help of two integral
-		// images intImgP and intImgP2 (sum of squares), which should be also provided.
-		bool TLDDetector::patchVariance(Mat_<double>& intImgP, Mat_<double>& intImgP2, double *originalVariance, Point pt, Size size)
+		// Computes the variances of all windows of the scan grid with the help of the integral images of the level.
+		// The windows are enumerated column by column, as they are scanned by the detector.
+		void TLDDetector::computeWindowVariances(const Mat& img, Size size, int dx, int dy, std::vector<Point>& windows, std::vector<double>& variances)
 		{
-			int x = (pt.x), y = (pt.y), width = (size.width), height = (size.height);
-			CV_Assert(0 <= x && (x + width) < intImgP.cols && (x + width) < intImgP2.cols);
-			CV_Assert(0 <= y && (y + height) < intImgP.rows && (y + height) < intImgP2.rows);
-			double p = 0, p2 = 0;
-			double A, B, C, D;
-
-			A = intImgP(y, x);
-			B = intImgP(y, x + width);
-			C = intImgP(y + height, x);
-			D = intImgP(y + height, x + width);
-			p = (A + D - B - C) / (width * height);
-
-			A = intImgP2(y, x);
-			B = intImgP2(y, x + width);
-			C = intImgP2(y + height, x);
-			D = intImgP2(y + height, x + width);
-			p2 = (A + D - B - C) / (width * height);
-
-			return ((p2 - p * p) > VARIANCE_THRESHOLD * *originalVariance);
+			Mat_<double> intImgP, intImgP2;
+			computeIntegralImages(img, intImgP, intImgP2);
+
+			int imax = std::max(cvFloor((0.0 + img.cols - size.width) / dx), 0);
+			int jmax = std::max(cvFloor((0.0 + img.rows - size.height) / dy), 0);
+			double area = size.width * size.height;
+			windows.resize(imax * jmax);
+			variances.resize(imax * jmax);
+			for (int j = 0; j < jmax; j++)
+			{
+				int y = dy * j;
+				const double *top = intImgP[y], *bottom = intImgP[y + size.height];
+				const double *top2 = intImgP2[y], *bottom2 = intImgP2[y + size.height];
+				for (int i = 0; i < imax; i++)
+				{
+					int x = dx * i;
+					double p = (top[x] + bottom[x + size.width] - top[x + size.width] - bottom[x]) / area;
+					double p2 = (top2[x] + bottom2[x + size.width] - top2[x + size.width] - bottom2[x]) / area;
+					windows[i * jmax + j] = Point(x, y);
+					variances[i * jmax + j] = p2 - p * p;
+				}
+			}
+		}
+
+		// Scans the image pyramid by the sliding window and filters the windows by the variance and the ensemble classifier
+		// of every detector. The pyramid levels are processed one by one: the integral images and the variances of the windows
+		// are computed once per level and shared by all detectors. The windows passed both filters are returned per detector
+		// in the scale-major order together with the indices of their levels.
+		void TLDDetector::scanPyramid(const Mat& img, const Mat& imgBlurred, Size initSize, const std::vector<TLDDetector*>& detectors,
+			std::vector<Mat>& resized_imgs, std::vector<std::vector<Point> >& windows, std::vector<std::vector<int> >& scaleIDs)
+		{
+			int dx = initSize.width / 10, dy = initSize.height / 10;
+			Size2d size = img.size();
+			Mat resized, blurred = imgBlurred;
+			std::vector<Point> grid, varBuffer;
+			std::vector<double> variances;
+
+			resized_imgs.clear();
+			resized_imgs.push_back(img);
+			windows.assign(detectors.size(), std::vector<Point>());
+			scaleIDs.assign(detectors.size(), std::vector<int>());
+			for (int scaleID = 0;; scaleID++)
+			{
+				computeWindowVariances(resized_imgs[scaleID], initSize, dx, dy, grid, variances);
+				for (size_t k = 0; k < detectors.size(); k++)
+				{
+					double threshold = VARIANCE_THRESHOLD * *detectors[k]->originalVariancePtr;
+					varBuffer.clear();
+					for (size_t i = 0; i < grid.size(); i++)
+						if (variances[i] > threshold)
+							varBuffer.push_back(grid[i]);
+
+					detectors[k]->ensembleClassify(blurred, varBuffer, windows[k]);
+					scaleIDs[k].resize(windows[k].size(), scaleID);
+				}
+
+				size.width /= SCALE_STEP;
+				size.height /= SCALE_STEP;
+				if (size.width < initSize.width || size.height < initSize.height)
+					break;
+				resize(img, resized, size, 0, 0, DOWNSCALE_MODE);
+				resized_imgs.push_back(resized);
+				blurred = Mat();
+				GaussianBlur(resized, blurred, GaussBlurKernelSize, 0.0f);
+				resized = Mat();
+			}
 		}
 
 	}
@@ -75,6 +75,7 @@ namespace cv
 			~TLDDetector(){}
 			double ensembleClassifierNum(const uchar* data);
 			void prepareClassifiers(int rowstep);
+			void ensembleClassify(const Mat& imgBlurred, const std::vector<Point>& windows, std::vector<Point>& res);
 			double Sr(const Mat_<uchar>& patch);
 			double Sc(const Mat_<uchar>& patch);
 #ifdef HAVE_OPENCL
@@ -84,6 +85,8 @@ namespace cv
 #endif
 
 			std::vector<TLDEnsembleClassifier> classifiers;
+			std::vector<int> offsets; //offsets of the measurements of all classifiers, two per measurement
+			std::vector<uchar> ensemblePassed;
 			Mat *posExp, *negExp;
 			int *posNum, *negNum;
 			std::vector<Mat_<uchar> > *positiveExamples, *negativeExamples;
@@ -101,7 +104,9 @@ namespace cv
 
 			friend class MyMouseCallbackDEBUG;
 			static void computeIntegralImages(const Mat& img, Mat_<double>& intImgP, Mat_<double>& intImgP2){ integral(img, intImgP, intImgP2, CV_64F); }
-			static inline bool patchVariance(Mat_<double>& intImgP, Mat_<double>& intImgP2, double *originalVariance, Point pt, Size size);
+			static void computeWindowVariances(const Mat& img, Size size, int dx, int dy, std::vector<Point>& windows, std::vector<double>& variances);
+			static void scanPyramid(const Mat& img, const Mat& imgBlurred, Size initSize, const std::vector<TLDDetector*>& detectors,
+				std::vector<Mat>& resized_imgs, std::vector<std::vector<Point> >& windows, std::vector<std::vector<int> >& scaleIDs);
 		};
 
 
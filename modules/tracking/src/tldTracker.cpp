@@ -40,6 +40,7 @@
  //M*/
 
 #include "tldTracker.hpp"
+#include "sharedFrame.hpp"
 
 
 namespace cv
@@ -104,16 +105,29 @@ bool TrackerTLDImpl::initImpl(const Mat& image, const Rect2d& boundingBox)
     return true;
 }
 
+//blurred grayscale frame is shared by the trackers which don't rescale it
+static void computeBlurredGray(const Mat& image, Mat& blurred)
+{
+    Mat image_gray;
+    SharedFrame::preprocess( image, convertToGray, image_gray );
+    GaussianBlur(image_gray, blurred, GaussBlurKernelSize, 0.0);
+}
+
 bool TrackerTLDImpl::updateImpl(const Mat& image, Rect2d& boundingBox)
 {
     Mat image_gray, image_blurred, imageForDetector;
-    cvtColor( image, image_gray, COLOR_BGR2GRAY );
+    SharedFrame::preprocess( image, convertToGray, image_gray );
     double scale = data->getScale();
     if( scale > 1.0 )
+    {
         resize(image_gray, imageForDetector, Size(cvRound(image.cols*scale), cvRound(image.rows*scale)), 0, 0, DOWNSCALE_MODE);
+        GaussianBlur(imageForDetector, image_blurred, GaussBlurKernelSize, 0.0);
+    }
     else
+    {
         imageForDetector = image_gray;
-    GaussianBlur(imageForDetector, image_blurred, GaussBlurKernelSize, 0.0);
+        SharedFrame::preprocess( image, computeBlurredGray, image_blurred );
+    }
     TrackerTLDModel* tldModel = ((TrackerTLDModel*)static_cast<TrackerModel*>(model));
     data->frameNum++;
     Mat_<uchar> standardPatch(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE);
@@ -40,6 +40,7 @@
  //M*/
 
 #include "precomp.hpp"
+#include "sharedFrame.hpp"
 #include "trackerBoostingModel.hpp"
 
 namespace cv
@@ -116,15 +117,20 @@ void TrackerBoostingImpl::write( cv::FileStorage& fs ) const
   params.write( fs );
 }
 
+//integral image of the grayscale frame, shared by the trackers updated with the same frame
+static void computeIntegral( const Mat& image, Mat& intImage )
+{
+  Mat image_;
+  cvtColor( image, image_, CV_RGB2GRAY );
+  integral( image_, intImage, CV_32S );
+}
+
 bool TrackerBoostingImpl::initImpl( const Mat& image, const Rect2d& boundingBox )
 {
   srand (1);
   //sampling
   Mat_<int> intImage;
-  Mat_<double> intSqImage;
-  Mat image_;
-  cvtColor( image, image_, CV_RGB2GRAY );
-  integral( image_, intImage, intSqImage, CV_32S );
+  SharedFrame::preprocess( image, computeIntegral, intImage );
   TrackerSamplerCS::Params CSparameters;
   CSparameters.overlap = params.samplerOverlap;
   CSparameters.searchFactor = params.samplerSearchFactor;
@@ -203,10 +209,7 @@ bool TrackerBoostingImpl::initImpl( const Mat& image, const Rect2d& boundingBox
 bool TrackerBoostingImpl::updateImpl( const Mat& image, Rect2d& boundingBox )
 {
   Mat_<int> intImage;
-  Mat_<double> intSqImage;
-  Mat image_;
-  cvtColor( image, image_, CV_RGB2GRAY );
-  integral( image_, intImage, intSqImage, CV_32S );
+  SharedFrame::preprocess( image, computeIntegral, intImage );
   //get the last location [AAM] X(k-1)
   Ptr<TrackerTargetState> lastLocation = model->getLastTargetState();
   Rect lastBoundingBox( (int)lastLocation->getTargetPosition().x, (int)lastLocation->getTargetPosition().y, lastLocation->getTargetWidth(),
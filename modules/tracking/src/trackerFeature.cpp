@@ -203,67 +203,16 @@ bool TrackerFeatureHAAR::extractSelected( const std::vector<int> selFeatures, co
   }
 
   int numFeatures = featureEvaluator->getNumFeatures();
-  int numSelFeatures = (int)selFeatures.size();
 
-  //response = Mat_<float>( Size( images.size(), numFeatures ) );
   response.create( Size( (int)images.size(), numFeatures ), CV_32F );
   response.setTo( 0 );
 
-  //double t = getTickCount();
-  //for each sample compute #n_feature -> put each feature (n Rect) in response
-  for ( size_t i = 0; i < images.size(); i++ )
-  {
-    int c = images[i].cols;
-    int r = images[i].rows;
-    for ( int j = 0; j < numSelFeatures; j++ )
-    {
-      float res = 0;
-      //const feat
-      CvHaarEvaluator::FeatureHaar& feature = featureEvaluator->getFeatures( selFeatures[j] );
-      feature.eval( images[i], Rect( 0, 0, c, r ), &res );
-      //( Mat_<float>( response ) )( j, i ) = res;
-      response.at<float>( selFeatures[j], (int)i ) = res;
-    }
-  }
-  //t = ( (double) getTickCount() - t ) / getTickFrequency();
-  //std::cout << "StrongClassifierDirectSelection time " << t << std::endl;
+  //for each sample compute the selected features -> put each feature (n Rect) in response
+  featureEvaluator->evalBatch( images, selFeatures, response );
 
   return true;
 }
 
-class Parallel_compute : public cv::ParallelLoopBody
-{
- private:
-  Ptr<CvHaarEvaluator> featureEvaluator;
-  std::vector<Mat> images;
-  Mat response;
-  //std::vector<CvHaarEvaluator::FeatureHaar> features;
- public:
-  Parallel_compute( Ptr<CvHaarEvaluator>& fe, const std::vector<Mat>& img, Mat& resp ) :
-      featureEvaluator( fe ),
-      images( img ),
-      response( resp )
-  {
-
-    //features = featureEvaluator->getFeatures();
-  }
-
-  virtual void operator()( const cv::Range &r ) const
-  {
-    for ( register int jf = r.start; jf != r.end; ++jf )
-    {
-      int cols = images[jf].cols;
-      int rows = images[jf].rows;
-      for ( int j = 0; j < featureEvaluator->getNumFeatures(); j++ )
-      {
-        float res = 0;
-        featureEvaluator->getFeatures()[j].eval( images[jf], Rect( 0, 0, cols, rows ), &res );
-        ( Mat_<float>( response ) )( j, jf ) = res;
-      }
-    }
-  }
-};
-
 bool TrackerFeatureHAAR::computeImpl( const std::vector<Mat>& images, Mat& response )
 {
   if( images.empty() )
@@ -273,23 +222,13 @@ bool TrackerFeatureHAAR::computeImpl( const std::vector<Mat>& images, Mat& respo
 
   int numFeatures = featureEvaluator->getNumFeatures();
 
-  response = Mat_<float>( Size( (int)images.size(), numFeatures ) );
+  response.create( Size( (int)images.size(), numFeatures ), CV_32F );
 
-  std::vector<CvHaarEvaluator::FeatureHaar> f = featureEvaluator->getFeatures();
   //for each sample compute #n_feature -> put each feature (n Rect) in response
-  parallel_for_( Range( 0, (int)images.size() ), Parallel_compute( featureEvaluator, images, response ) );
-
-  /*for ( size_t i = 0; i < images.size(); i++ )
-  {
-    int c = images[i].cols;
-    int r = images[i].rows;
-    for ( int j = 0; j < numFeatures; j++ )
-    {
-      float res = 0;
-      featureEvaluator->getFeatures( j ).eval( images[i], Rect( 0, 0, c, r ), &res );
-      ( Mat_<float>( response ) )( j, i ) = res;
-    }
-  }*/
+  std::vector<int> featureIdx( numFeatures );
+  for ( int j = 0; j < numFeatures; j++ )
+    featureIdx[j] = j;
+  featureEvaluator->evalBatch( images, featureIdx, response );
 
   return true;
 }
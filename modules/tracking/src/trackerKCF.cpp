@@ -41,6 +41,7 @@
 
 #include "precomp.hpp"
 #include <complex>
+#include <cfloat>
 
 /*---------------------------
 |  TrackerKCFModel
@@ -91,16 +92,20 @@ namespace cv{
     void inline fft2(const Mat src, std::vector<Mat> & dest, std::vector<Mat> & layers_data) const;
     void inline fft2(const Mat src, Mat & dest) const;
     void inline ifft2(const Mat src, Mat & dest) const;
-    void inline pixelWiseMult(const std::vector<Mat> src1, const std::vector<Mat>  src2, std::vector<Mat>  & dest, const int flags, const bool conjB=false) const;
-    void inline sumChannels(std::vector<Mat> src, Mat & dest) const;
+    void inline pixelWiseMultSum(const std::vector<Mat> & src1, const std::vector<Mat> & src2, Mat & dest) const;
+    void inline divSpectrums(const Mat & src1, const Mat & src2, Mat & dest) const;
     void inline updateProjectionMatrix(const Mat src, Mat & old_cov,Mat &  proj_matrix,double pca_rate, int compressed_sz,
-                                       std::vector<Mat> & layers_pca,std::vector<Scalar> & average, Mat pca_data, Mat new_cov, Mat w, Mat u, Mat v) const;
-    void inline compress(const Mat proj_matrix, const Mat src, Mat & dest, Mat & data, Mat & compressed) const;
-    bool getSubWindow(const Mat img, const Rect roi, Mat& feat, Mat& patch, TrackerKCF::MODE desc = GRAY) const;
-    bool getSubWindow(const Mat img, const Rect roi, Mat& feat, void (*f)(const Mat, const Rect, Mat& )) const;
-    void extractCN(Mat patch_data, Mat & cnFeatures) const;
-    void denseGaussKernel(const double sigma, const Mat , const Mat y_data, Mat & k_data,
-                          std::vector<Mat> & layers_data,std::vector<Mat> & xf_data,std::vector<Mat> & yf_data, std::vector<Mat> xyf_v, Mat xy, Mat xyf ) const;
+                                       Mat & average, Mat & new_cov, Mat & w, Mat & u, Mat & vt) const;
+    void inline compress(const Mat proj_matrix, const Mat src, Mat & dest) const;
+    void inline mergeFeatures(const Mat & pca, const Mat & npca, Mat & buffer, Mat & dest) const;
+    Rect scaledRoi(double scale) const;
+    bool getFeatures(const Mat & img, double scale);
+    bool getPatch(const Mat & img, const Rect roi, Mat & patch);
+    void getDescriptor(const Mat & patch, Mat& feat, TrackerKCF::MODE desc = GRAY);
+    bool getSubWindow(const Mat img, const Rect roi, Mat& feat, void (*f)(const Mat, const Rect, Mat& ));
+    void extractCN(const Mat & patch_data, const Mat & window, Mat & cnFeatures) const;
+    void denseGaussKernel(const double sigma, const std::vector<Mat> & xf_data, const double xx,
+                          const std::vector<Mat> & yf_data, const double yy, Mat & k_data, Mat & xyf, Mat & xy) const;
     void calcResponse(const Mat alphaf_data, const Mat kf_data, Mat & response_data, Mat & spec_data) const;
     void calcResponse(const Mat alphaf_data, const Mat alphaf_den_data, const Mat kf_data, Mat & response_data, Mat & spec_data, Mat & spec2_data) const;
 
@@ -110,9 +115,15 @@ namespace cv{
 
   private:
     double output_sigma;
-    Rect2d roi;
+    Rect2d roi; // sub-window of the unit scale, its size is the size of the filter
+    Size2d target_size; // size of the bounding box at the unit scale
+
+    // scale estimation
+    std::vector<double> scale_factors; // relative scales of the searched sub-windows, in ascending order
+    double current_scale; // scale of the target relative to the first frame
+    double min_scale, max_scale;
     Mat hann; 	//hann window filter
-    Mat hann_cn; //10 dimensional hann-window filter for CN features,
+    Mat hann_custom; //hann window filter for the custom features, rebuilt if the number of channels changes
 
     Mat y,yf; 	// training response and its FFT
     Mat x; 	// observation and its FFT
@@ -124,18 +135,17 @@ namespace cv{
     Mat response; // detection result
     Mat old_cov_mtx, proj_mtx; // for feature compression
 
-    // pre-defined Mat variables for optimization of private functions
+    // pre-allocated Mat variables, which are reused by the private functions on each frame
     Mat spec, spec2;
     std::vector<Mat> layers;
-    std::vector<Mat> vxf,vyf,vxyf;
+    std::vector<Mat> vxf,vzf;
     Mat xy_data,xyf_data;
-    Mat data_temp, compress_data;
-    std::vector<Mat> layers_pca_data;
-    std::vector<Scalar> average_data;
-    Mat img_Patch;
+    Rect window_roi; // region of img_window, the sub-windows of all scales are cropped from it
+    Mat img_window, img_scaled, img_region, img_resized, gray_patch;
+    Mat x_merged, z_merged;
 
-    // storage for the extracted features, KRLS model, KRLS compressed model
-    Mat X[2],Z[2],Zc[2];
+    // storage for the extracted features, KRLS model, KRLS compressed model, compressed features
+    Mat X[2],Z[2],Zc[2],Xc;
 
     // storage of the extracted features
     std::vector<Mat> features_pca;
@@ -144,7 +154,7 @@ namespace cv{
     std::vector<MODE> descriptors_npca;
 
     // optimization variables for updateProjectionMatrix
-    Mat data_pca, new_covar,w_data,u_data,vt_data;
+    Mat average_data, new_covar,w_data,u_data,vt_data;
 
     // custom feature extractor
     bool use_custom_extractor_pca;
@@ -153,6 +163,7 @@ namespace cv{
     std::vector<void(*)(const Mat img, const Rect roi, Mat& output)> extractor_npca;
 
     bool resizeImage; // resize the image whenever needed and the patch size is large
+    bool compressFeatures; // compress the features by PCA
 
     int frame;
   };
@@ -168,6 +179,9 @@ namespace cv{
   {
     isInit = false;
     resizeImage = false;
+    compressFeatures = false;
+    current_scale = 1.0;
+    min_scale = max_scale = 1.0;
     use_custom_extractor_pca = false;
     use_custom_extractor_npca = false;
 
@@ -187,10 +201,13 @@ namespace cv{
    * - ROI padding
    * - creating a gaussian response for the training ground-truth
    * - perform FFT to the gaussian response
+   * - allocation of the buffers reused by the update
+   * - selection of the searched scales
    */
-  bool TrackerKCFImpl::initImpl( const Mat& /*image*/, const Rect2d& boundingBox ){
+  bool TrackerKCFImpl::initImpl( const Mat& image, const Rect2d& boundingBox ){
     frame=0;
     roi = boundingBox;
+    target_size = boundingBox.size();
 
     //calclulate output sigma
     output_sigma=sqrt(roi.width*roi.height)*params.output_sigma_factor;
@@ -211,13 +228,26 @@ namespace cv{
     roi.width*=2;
     roi.height*=2;
 
+    // enlarge the padded roi to the size which is fast for DFT, the target stays in the center
+    double width=getOptimalDFTSize(cvRound(roi.width)), height=getOptimalDFTSize(cvRound(roi.height));
+    roi.x-=(width-roi.width)/2;
+    roi.y-=(height-roi.height)/2;
+    roi.width=width;
+    roi.height=height;
+
+    // relative scales of the searched sub-windows, the scale of the window is kept
+    // between 16 pixels and the size of the image
+    scale_factors.clear();
+    int scales = params.scale_estimation ? std::max(params.scale_count,1) : 1;
+    for(int i=0;i<scales;i++)
+      scale_factors.push_back(std::pow(params.scale_step,i-(scales-1)/2.0));
+    current_scale=1.0;
+    min_scale=std::min(std::max(16.0/roi.width,16.0/roi.height),1.0);
+    max_scale=std::max(std::min(image.cols/(resizeImage?2:1)/roi.width,image.rows/(resizeImage?2:1)/roi.height),1.0);
+
     // initialize the hann window filter
     createHanningWindow(hann, roi.size(), CV_64F);
 
-    // hann window filter for CN feature
-    Mat _layer[] = {hann, hann, hann, hann, hann, hann, hann, hann, hann, hann};
-    merge(_layer, 10, hann_cn);
-
     // create gaussian response
     y=Mat::zeros((int)roi.height,(int)roi.width,CV_64F);
     for(unsigned i=0;i<roi.height;i++){
@@ -232,6 +262,18 @@ namespace cv{
     // perform fourier transfor to the gaussian response
     fft2(y,yf);
 
+    // buffers of the kernel, the spectrums and the response have the size of the window
+    k.create(yf.rows, yf.cols, CV_64F);
+    kf.create(yf.rows, yf.cols, CV_64FC2);
+    kf_lambda.create(yf.rows, yf.cols, CV_64FC2);
+    new_alphaf.create(yf.rows, yf.cols, CV_64FC2);
+    new_alphaf_den.create(yf.rows, yf.cols, CV_64FC2);
+    spec.create(yf.rows, yf.cols, CV_64FC2);
+    spec2.create(yf.rows, yf.cols, CV_64FC2);
+    xyf_data.create(yf.rows, yf.cols, CV_64FC2);
+    xy_data.create(yf.rows, yf.cols, CV_64F);
+    response.create(yf.rows, yf.cols, CV_64F);
+
     model=Ptr<TrackerKCFModel>(new TrackerKCFModel(params));
 
     // record the non-compressed descriptors
@@ -246,6 +288,8 @@ namespace cv{
     if(use_custom_extractor_pca)descriptors_pca.push_back(CUSTOM);
     features_pca.resize(descriptors_pca.size());
 
+    compressFeatures = params.desc_pca != 0 || use_custom_extractor_pca;
+
     // accept only the available descriptor modes
     CV_Assert(
       (params.desc_pca & GRAY) == GRAY
@@ -266,163 +310,133 @@ namespace cv{
   bool TrackerKCFImpl::updateImpl( const Mat& image, Rect2d& boundingBox ){
     double minVal, maxVal;	// min-max response
     Point minLoc,maxLoc;	// min-max location
+    double normX, normZ;	// squared norms of the features and of the model
 
-    Mat img=image.clone();
     // check the channels of the input image, grayscale is preferred
-    CV_Assert(img.channels() == 1 || img.channels() == 3);
+    CV_Assert(image.channels() == 1 || image.channels() == 3);
 
-    // resize the image whenever needed
-    if(resizeImage)resize(img,img,Size(img.cols/2,img.rows/2));
+    // custom extractors get the whole image, so it is resized for them
+    // the patches of the built-in descriptors are resized by getPatch()
+    if(resizeImage && (extractor_pca.size()>0 || extractor_npca.size()>0))
+      resize(image,img_resized,Size(image.cols/2,image.rows/2));
 
     // detection part
     if(frame>0){
 
-      // extract and pre-process the patch
-      // get non compressed descriptors
-      for(unsigned i=0;i<descriptors_npca.size()-extractor_npca.size();i++){
-        if(!getSubWindow(img,roi, features_npca[i], img_Patch, descriptors_npca[i]))return false;
-      }
-      //get non-compressed custom descriptors
-      for(unsigned i=0,j=(unsigned)(descriptors_npca.size()-extractor_npca.size());i<extractor_npca.size();i++,j++){
-        if(!getSubWindow(img,roi, features_npca[j], extractor_npca[i]))return false;
+      //compress the KRSL model, it is shared by all scales
+      if(compressFeatures){
+        compress(proj_mtx,Z[0],Zc[0]);
+      }else{
+        Zc[0] = Z[0];
       }
-      if(features_npca.size()>0)merge(features_npca,X[1]);
+      mergeFeatures(Zc[0],Z[1],z_merged,z);
+
+      // the spectrums of the model are computed only once
+      fft2(z,vzf,layers);
+      normZ=norm(z);
+      normZ*=normZ;
+
+      // extract the sub-window of the largest scale, the other scales are cropped from it
+      window_roi=scaledRoi(current_scale*scale_factors.back());
+      if(!getPatch(image,window_roi,img_window))return false;
+
+      double bestVal=-DBL_MAX;
+      Point bestLoc;
+      size_t bestScale=0;
+      for(size_t s=0;s<scale_factors.size();s++){
+        // extract and pre-process the patch
+        if(!getFeatures(image,current_scale*scale_factors[s]))return false;
+
+        //compress the features
+        if(compressFeatures){
+          compress(proj_mtx,X[0],Xc);
+        }else{
+          Xc = X[0];
+        }
 
-      // get compressed descriptors
-      for(unsigned i=0;i<descriptors_pca.size()-extractor_pca.size();i++){
-        if(!getSubWindow(img,roi, features_pca[i], img_Patch, descriptors_pca[i]))return false;
-      }
-      //get compressed custom descriptors
-      for(unsigned i=0,j=(unsigned)(descriptors_pca.size()-extractor_pca.size());i<extractor_pca.size();i++,j++){
-        if(!getSubWindow(img,roi, features_pca[j], extractor_pca[i]))return false;
-      }
-      if(features_pca.size()>0)merge(features_pca,X[0]);
+        // merge all features
+        mergeFeatures(Xc,X[1],x_merged,x);
 
-      //compress the features and the KRSL model
-      if(params.desc_pca !=0){
-        compress(proj_mtx,X[0],X[0],data_temp,compress_data);
-        compress(proj_mtx,Z[0],Zc[0],data_temp,compress_data);
-      }
+        //compute the gaussian kernel
+        fft2(x,vxf,layers);
+        normX=norm(x);
+        normX*=normX;
+        denseGaussKernel(params.sigma,vxf,normX,vzf,normZ,k,xyf_data,xy_data);
 
-      // copy the compressed KRLS model
-      Zc[1] = Z[1];
+        // compute the fourier transform of the kernel
+        fft2(k,kf);
 
-      // merge all features
-      if(features_npca.size()==0){
-        x = X[0];
-        z = Zc[0];
-      }else if(features_pca.size()==0){
-        x = X[1];
-        z = Z[1];
-      }else{
-        merge(X,2,x);
-        merge(Zc,2,z);
+        // calculate filter response
+        if(params.split_coeff)
+          calcResponse(alphaf,alphaf_den,kf,response, spec, spec2);
+        else
+          calcResponse(alphaf,kf,response, spec);
+
+        // extract the maximum response, the changed scales are penalized
+        minMaxLoc( response, &minVal, &maxVal, &minLoc, &maxLoc );
+        if(scale_factors[s]!=1.0)maxVal*=params.scale_penalty;
+        if(maxVal>bestVal){
+          bestVal=maxVal;
+          bestLoc=maxLoc;
+          bestScale=s;
+        }
       }
 
-      //compute the gaussian kernel
-      denseGaussKernel(params.sigma,x,z,k,layers,vxf,vyf,vxyf,xy_data,xyf_data);
-
-      // compute the fourier transform of the kernel
-      fft2(k,kf);
-      if(frame==1)spec2=Mat_<Vec2d >(kf.rows, kf.cols);
+      // the response is measured in the coordinates of the filter
+      double scale=current_scale*scale_factors[bestScale];
+      roi.x+=(bestLoc.x-roi.width/2+1)*scale;
+      roi.y+=(bestLoc.y-roi.height/2+1)*scale;
+      current_scale=std::min(std::max(scale,min_scale),max_scale);
 
-      // calculate filter response
-      if(params.split_coeff)
-        calcResponse(alphaf,alphaf_den,kf,response, spec, spec2);
-      else
-        calcResponse(alphaf,kf,response, spec);
-
-      // extract the maximum response
-      minMaxLoc( response, &minVal, &maxVal, &minLoc, &maxLoc );
-      roi.x+=(maxLoc.x-roi.width/2+1);
-      roi.y+=(maxLoc.y-roi.height/2+1);
-
-      // update the bounding box
-      boundingBox.x=(resizeImage?roi.x*2:roi.x)+boundingBox.width/2;
-      boundingBox.y=(resizeImage?roi.y*2:roi.y)+boundingBox.height/2;
+      // update the bounding box, the target is in the center of the roi
+      if(params.scale_estimation){
+        boundingBox.width=target_size.width*current_scale;
+        boundingBox.height=target_size.height*current_scale;
+      }
+      boundingBox.x=(resizeImage?2:1)*(roi.x+roi.width/2)-boundingBox.width/2;
+      boundingBox.y=(resizeImage?2:1)*(roi.y+roi.height/2)-boundingBox.height/2;
     }
 
     // extract the patch for learning purpose
-    // get non compressed descriptors
-    for(unsigned i=0;i<descriptors_npca.size()-extractor_npca.size();i++){
-      if(!getSubWindow(img,roi, features_npca[i], img_Patch, descriptors_npca[i]))return false;
-    }
-    //get non-compressed custom descriptors
-    for(unsigned i=0,j=(unsigned)(descriptors_npca.size()-extractor_npca.size());i<extractor_npca.size();i++,j++){
-      if(!getSubWindow(img,roi, features_npca[j], extractor_npca[i]))return false;
-    }
-    if(features_npca.size()>0)merge(features_npca,X[1]);
-
-    // get compressed descriptors
-    for(unsigned i=0;i<descriptors_pca.size()-extractor_pca.size();i++){
-      if(!getSubWindow(img,roi, features_pca[i], img_Patch, descriptors_pca[i]))return false;
-    }
-    //get compressed custom descriptors
-    for(unsigned i=0,j=(unsigned)(descriptors_pca.size()-extractor_pca.size());i<extractor_pca.size();i++,j++){
-      if(!getSubWindow(img,roi, features_pca[j], extractor_pca[i]))return false;
-    }
-    if(features_pca.size()>0)merge(features_pca,X[0]);
+    window_roi=scaledRoi(current_scale);
+    if(!getPatch(image,window_roi,img_window))return false;
+    if(!getFeatures(image,current_scale))return false;
 
     //update the training data
     if(frame==0){
       Z[0] = X[0].clone();
       Z[1] = X[1].clone();
     }else{
-      Z[0]=(1.0-params.interp_factor)*Z[0]+params.interp_factor*X[0];
-      Z[1]=(1.0-params.interp_factor)*Z[1]+params.interp_factor*X[1];
+      if(!X[0].empty())addWeighted(Z[0],1.0-params.interp_factor,X[0],params.interp_factor,0.0,Z[0]);
+      if(!X[1].empty())addWeighted(Z[1],1.0-params.interp_factor,X[1],params.interp_factor,0.0,Z[1]);
     }
 
-    if(params.desc_pca !=0 || use_custom_extractor_pca){
-      // initialize the vector of Mat variables
-      if(frame==0){
-        layers_pca_data.resize(Z[0].channels());
-        average_data.resize(Z[0].channels());
-      }
-
+    if(compressFeatures){
       // feature compression
-      updateProjectionMatrix(Z[0],old_cov_mtx,proj_mtx,params.pca_learning_rate,params.compressed_size,layers_pca_data,average_data,data_pca, new_covar,w_data,u_data,vt_data);
-      compress(proj_mtx,X[0],X[0],data_temp,compress_data);
+      updateProjectionMatrix(Z[0],old_cov_mtx,proj_mtx,params.pca_learning_rate,params.compressed_size,average_data,new_covar,w_data,u_data,vt_data);
+      compress(proj_mtx,X[0],Xc);
+    }else{
+      Xc = X[0];
     }
 
     // merge all features
-    if(features_npca.size()==0)
-      x = X[0];
-    else if(features_pca.size()==0)
-      x = X[1];
-    else
-      merge(X,2,x);
-
-    // initialize some required Mat variables
-    if(frame==0){
-      layers.resize(x.channels());
-      vxf.resize(x.channels());
-      vyf.resize(x.channels());
-      vxyf.resize(vyf.size());
-      new_alphaf=Mat_<Vec2d >(yf.rows, yf.cols);
-    }
+    mergeFeatures(Xc,X[1],x_merged,x);
 
     // Kernel Regularized Least-Squares, calculate alphas
-    denseGaussKernel(params.sigma,x,x,k,layers,vxf,vyf,vxyf,xy_data,xyf_data);
+    fft2(x,vxf,layers);
+    normX=norm(x);
+    normX*=normX;
+    denseGaussKernel(params.sigma,vxf,normX,vxf,normX,k,xyf_data,xy_data);
 
     // compute the fourier transform of the kernel and add a small value
     fft2(k,kf);
-    kf_lambda=kf+params.lambda;
+    add(kf,Scalar(params.lambda),kf_lambda);
 
-    double den;
     if(params.split_coeff){
       mulSpectrums(yf,kf,new_alphaf,0);
       mulSpectrums(kf,kf_lambda,new_alphaf_den,0);
     }else{
-      for(int i=0;i<yf.rows;i++){
-        for(int j=0;j<yf.cols;j++){
-          den = 1.0/(kf_lambda.at<Vec2d>(i,j)[0]*kf_lambda.at<Vec2d>(i,j)[0]+kf_lambda.at<Vec2d>(i,j)[1]*kf_lambda.at<Vec2d>(i,j)[1]);
-
-          new_alphaf.at<Vec2d>(i,j)[0]=
-          (yf.at<Vec2d>(i,j)[0]*kf_lambda.at<Vec2d>(i,j)[0]+yf.at<Vec2d>(i,j)[1]*kf_lambda.at<Vec2d>(i,j)[1])*den;
-          new_alphaf.at<Vec2d>(i,j)[1]=
-          (yf.at<Vec2d>(i,j)[1]*kf_lambda.at<Vec2d>(i,j)[0]-yf.at<Vec2d>(i,j)[0]*kf_lambda.at<Vec2d>(i,j)[1])*den;
-        }
-      }
+      divSpectrums(yf,kf_lambda,new_alphaf);
     }
 
     // update the RLS model
@@ -430,8 +444,8 @@ namespace cv{
       alphaf=new_alphaf.clone();
       if(params.split_coeff)alphaf_den=new_alphaf_den.clone();
     }else{
-      alphaf=(1.0-params.interp_factor)*alphaf+params.interp_factor*new_alphaf;
-      if(params.split_coeff)alphaf_den=(1.0-params.interp_factor)*alphaf_den+params.interp_factor*new_alphaf_den;
+      addWeighted(alphaf,1.0-params.interp_factor,new_alphaf,params.interp_factor,0.0,alphaf);
+      if(params.split_coeff)addWeighted(alphaf_den,1.0-params.interp_factor,new_alphaf_den,params.interp_factor,0.0,alphaf_den);
     }
 
     frame++;
@@ -490,6 +504,7 @@ namespace cv{
 
   void inline TrackerKCFImpl::fft2(const Mat src, std::vector<Mat> & dest, std::vector<Mat> & layers_data) const {
     split(src, layers_data);
+    dest.resize(src.channels());
 
     for(int i=0;i<src.channels();i++){
       dft(layers_data[i],dest[i],DFT_COMPLEX_OUTPUT);
@@ -504,21 +519,49 @@ namespace cv{
   }
 
   /*
-   * Point-wise multiplication of two Multichannel Mat data
+   * Point-wise multiplication of the spectrums of the first array by the conjugated spectrums of the second one,
+   * summed over the channels. The spectrums of all channels are processed in one pass over the output.
    */
-  void inline TrackerKCFImpl::pixelWiseMult(const std::vector<Mat> src1, const std::vector<Mat>  src2, std::vector<Mat>  & dest, const int flags, const bool conjB) const {
-    for(unsigned i=0;i<src1.size();i++){
-      mulSpectrums(src1[i], src2[i], dest[i],flags,conjB);
+  void inline TrackerKCFImpl::pixelWiseMultSum(const std::vector<Mat> & src1, const std::vector<Mat> & src2, Mat & dest) const {
+    dest.create(src1[0].rows, src1[0].cols, CV_64FC2);
+    int cols = 2*dest.cols;
+
+    for(int i=0;i<dest.rows;i++){
+      double* dst = dest.ptr<double>(i);
+      for(int j=0;j<cols;j++)
+        dst[j]=0.0;
+
+      for(size_t c=0;c<src1.size();c++){
+        const double* a = src1[c].ptr<double>(i);
+        const double* b = src2[c].ptr<double>(i);
+        for(int j=0;j<cols;j+=2){
+          //(a+bi)*conj(c+di)=(ac+bd)+i(bc-ad)
+          dst[j]+=a[j]*b[j]+a[j+1]*b[j+1];
+          dst[j+1]+=a[j+1]*b[j]-a[j]*b[j+1];
+        }
+      }
     }
   }
 
   /*
-   * Combines all channels in a multi-channels Mat data into a single channel
+   * Point-wise division of two spectrums
    */
-  void inline TrackerKCFImpl::sumChannels(std::vector<Mat> src, Mat & dest) const {
-    dest=src[0].clone();
-    for(unsigned i=1;i<src.size();i++){
-      dest+=src[i];
+  void inline TrackerKCFImpl::divSpectrums(const Mat & src1, const Mat & src2, Mat & dest) const {
+    dest.create(src1.rows, src1.cols, CV_64FC2);
+    int cols = 2*dest.cols;
+
+    //z=(a+bi)/(c+di)=[(ac+bd)+i(bc-ad)]/(c^2+d^2)
+    for(int i=0;i<dest.rows;i++){
+      const double* a = src1.ptr<double>(i);
+      const double* b = src2.ptr<double>(i);
+      double* dst = dest.ptr<double>(i);
+      for(int j=0;j<cols;j+=2){
+        double den=1.0/(b[j]*b[j]+b[j+1]*b[j+1]);
+        double re=(a[j]*b[j]+a[j+1]*b[j+1])*den;
+        double im=(a[j+1]*b[j]-a[j]*b[j+1])*den;
+        dst[j]=re;
+        dst[j+1]=im;
+      }
     }
   }
 
@@ -526,21 +569,13 @@ namespace cv{
    * obtains the projection matrix using PCA
    */
   void inline TrackerKCFImpl::updateProjectionMatrix(const Mat src, Mat & old_cov,Mat &  proj_matrix, double pca_rate, int compressed_sz,
-                                                     std::vector<Mat> & layers_pca,std::vector<Scalar> & average, Mat pca_data, Mat new_cov, Mat w, Mat u, Mat vt) const {
+                                                     Mat & average, Mat & new_cov, Mat & w, Mat & u, Mat & vt) const {
     CV_Assert(compressed_sz<=src.channels());
 
-    split(src,layers_pca);
-
-    for (int i=0;i<src.channels();i++){
-      average[i]=mean(layers_pca[i]);
-      layers_pca[i]-=average[i];
-    }
-
-    // calc covariance matrix
-    merge(layers_pca,pca_data);
-    pca_data=pca_data.reshape(1,src.rows*src.cols);
-
-    new_cov=1.0/(double)(src.rows*src.cols-1)*(pca_data.t()*pca_data);
+    // calc covariance matrix of the features with subtracted average
+    Mat pca_data=src.reshape(1,src.rows*src.cols);
+    reduce(pca_data,average,0,REDUCE_AVG);
+    mulTransposed(pca_data,new_cov,true,average,1.0/(double)(src.rows*src.cols-1));
     if(old_cov.rows==0)old_cov=new_cov.clone();
 
     // calc PCA
@@ -558,74 +593,147 @@ namespace cv{
   }
 
   /*
-   * compress the features
+   * compress the features, the result is written to the buffer of dest
+   */
+  void inline TrackerKCFImpl::compress(const Mat proj_matrix, const Mat src, Mat & dest) const {
+    dest.create(src.rows, src.cols, CV_MAKETYPE(CV_64F, proj_matrix.cols));
+    Mat data=src.reshape(1,src.rows*src.cols);
+    Mat compressed=dest.reshape(1,src.rows*src.cols);
+    gemm(data,proj_matrix,1.0,noArray(),0.0,compressed);
+  }
+
+  /*
+   * merge the compressed and non-compressed features, buffer is used only if both are present
+   */
+  void inline TrackerKCFImpl::mergeFeatures(const Mat & pca, const Mat & npca, Mat & buffer, Mat & dest) const {
+    if(features_npca.size()==0){
+      dest = pca;
+    }else if(features_pca.size()==0){
+      dest = npca;
+    }else{
+      Mat parts[] = {pca, npca};
+      merge(parts,2,buffer);
+      dest = buffer;
+    }
+  }
+
+  /*
+   * region of the sub-window of the given scale, the sub-window keeps the center of the roi
    */
-  void inline TrackerKCFImpl::compress(const Mat proj_matrix, const Mat src, Mat & dest, Mat & data, Mat & compressed) const {
-    data=src.reshape(1,src.rows*src.cols);
-    compressed=data*proj_matrix;
-    dest=compressed.reshape(proj_matrix.cols,src.rows).clone();
+  Rect TrackerKCFImpl::scaledRoi(double scale) const {
+    int width=cvRound(roi.width*scale), height=cvRound(roi.height*scale);
+    return Rect(cvRound(roi.x+(roi.width-width)/2.0),cvRound(roi.y+(roi.height-height)/2.0),width,height);
   }
 
   /*
-   * obtain the patch and apply hann window filter to it
+   * extract all descriptors of the sub-window of the given scale, X[0] gets the descriptors to compress, X[1] - the non-compressed ones.
+   * The sub-window is cropped from img_window, which should be extracted before, and resized to the size of the filter.
    */
-  bool TrackerKCFImpl::getSubWindow(const Mat img, const Rect _roi, Mat& feat, Mat& patch, TrackerKCF::MODE desc) const {
+  bool TrackerKCFImpl::getFeatures(const Mat & img, double scale){
+    const Mat & customImg = resizeImage ? img_resized : img;
+    Rect region=scaledRoi(scale);
+
+    Rect crop=Rect(region.x-window_roi.x,region.y-window_roi.y,region.width,region.height)&Rect(0,0,img_window.cols,img_window.rows);
+    if(crop.width<=0 || crop.height<=0)return false;
+    Mat patch=img_window(crop);
+    if(patch.size()!=hann.size()){
+      resize(patch,img_scaled,hann.size());
+      patch=img_scaled;
+    }
 
+    // get non compressed descriptors
+    for(unsigned i=0;i<descriptors_npca.size()-extractor_npca.size();i++){
+      getDescriptor(patch, features_npca[i], descriptors_npca[i]);
+    }
+    //get non-compressed custom descriptors
+    for(unsigned i=0,j=(unsigned)(descriptors_npca.size()-extractor_npca.size());i<extractor_npca.size();i++,j++){
+      if(!getSubWindow(customImg,region, features_npca[j], extractor_npca[i]))return false;
+    }
+    if(features_npca.size()>0)merge(features_npca,X[1]);
+
+    // get compressed descriptors
+    for(unsigned i=0;i<descriptors_pca.size()-extractor_pca.size();i++){
+      getDescriptor(patch, features_pca[i], descriptors_pca[i]);
+    }
+    //get compressed custom descriptors
+    for(unsigned i=0,j=(unsigned)(descriptors_pca.size()-extractor_pca.size());i<extractor_pca.size();i++,j++){
+      if(!getSubWindow(customImg,region, features_pca[j], extractor_pca[i]))return false;
+    }
+    if(features_pca.size()>0)merge(features_pca,X[0]);
+
+    return true;
+  }
+
+  /*
+   * obtain the patch of the image, which is scaled by half if resizeImage is set
+   */
+  bool TrackerKCFImpl::getPatch(const Mat & img, const Rect _roi, Mat& patch) {
+    int scale = resizeImage ? 2 : 1;
+    int cols = img.cols/scale, rows = img.rows/scale;
     Rect region=_roi;
 
     // return false if roi is outside the image
     if((_roi.x+_roi.width<0)
       ||(_roi.y+_roi.height<0)
-      ||(_roi.x>=img.cols)
-      ||(_roi.y>=img.rows)
+      ||(_roi.x>=cols)
+      ||(_roi.y>=rows)
     )return false;
 
     // extract patch inside the image
     if(_roi.x<0){region.x=0;region.width+=_roi.x;}
     if(_roi.y<0){region.y=0;region.height+=_roi.y;}
-    if(_roi.x+_roi.width>img.cols)region.width=img.cols-_roi.x;
-    if(_roi.y+_roi.height>img.rows)region.height=img.rows-_roi.y;
-    if(region.width>img.cols)region.width=img.cols;
-    if(region.height>img.rows)region.height=img.rows;
-
-    patch=img(region).clone();
+    if(_roi.x+_roi.width>cols)region.width=cols-_roi.x;
+    if(_roi.y+_roi.height>rows)region.height=rows-_roi.y;
+    if(region.width>cols)region.width=cols;
+    if(region.height>rows)region.height=rows;
+    if(region.width<=0 || region.height<=0)return false;
 
     // add some padding to compensate when the patch is outside image border
     int addTop,addBottom, addLeft, addRight;
     addTop=region.y-_roi.y;
-    addBottom=(_roi.height+_roi.y>img.rows?_roi.height+_roi.y-img.rows:0);
+    addBottom=(_roi.height+_roi.y>rows?_roi.height+_roi.y-rows:0);
     addLeft=region.x-_roi.x;
-    addRight=(_roi.width+_roi.x>img.cols?_roi.width+_roi.x-img.cols:0);
+    addRight=(_roi.width+_roi.x>cols?_roi.width+_roi.x-cols:0);
 
-    copyMakeBorder(patch,patch,addTop,addBottom,addLeft,addRight,BORDER_REPLICATE);
-    if(patch.rows==0 || patch.cols==0)return false;
+    // only the region of the image is resized, the buffers are reused
+    if(scale == 1){
+      copyMakeBorder(img(region),patch,addTop,addBottom,addLeft,addRight,BORDER_REPLICATE);
+    }else{
+      Rect srcRegion(region.x*scale, region.y*scale, region.width*scale, region.height*scale);
+      resize(img(srcRegion),img_region,region.size());
+      copyMakeBorder(img_region,patch,addTop,addBottom,addLeft,addRight,BORDER_REPLICATE);
+    }
+
+    return patch.rows>0 && patch.cols>0;
+  }
+
+  /*
+   * extract the descriptor of the patch and apply hann window filter to it
+   */
+  void TrackerKCFImpl::getDescriptor(const Mat & patch, Mat& feat, TrackerKCF::MODE desc) {
 
     // extract the desired descriptors
     switch(desc){
       case CN:
-        CV_Assert(img.channels() == 3);
-        extractCN(patch,feat);
-        feat=feat.mul(hann_cn); // hann window filter
+        CV_Assert(patch.channels() == 3);
+        extractCN(patch,hann,feat); // the hann window filter is applied by extractCN
         break;
       default: // GRAY
-        if(img.channels()>1)
-          cvtColor(patch,feat, CV_BGR2GRAY);
-        else
-          feat=patch;
-        feat.convertTo(feat,CV_64F);
-        feat=feat/255.0-0.5; // normalize to range -0.5 .. 0.5
-        feat=feat.mul(hann); // hann window filter
+        if(patch.channels()>1){
+          cvtColor(patch,gray_patch, CV_BGR2GRAY);
+          gray_patch.convertTo(feat,CV_64F,1.0/255.0,-0.5); // normalize to range -0.5 .. 0.5
+        }else{
+          patch.convertTo(feat,CV_64F,1.0/255.0,-0.5);
+        }
+        multiply(feat,hann,feat); // hann window filter
         break;
     }
-
-    return true;
-
   }
 
   /*
    * get feature using external function
    */
-  bool TrackerKCFImpl::getSubWindow(const Mat img, const Rect _roi, Mat& feat, void (*f)(const Mat, const Rect, Mat& )) const{
+  bool TrackerKCFImpl::getSubWindow(const Mat img, const Rect _roi, Mat& feat, void (*f)(const Mat, const Rect, Mat& )) {
 
     // return false if roi is outside the image
     if((_roi.x+_roi.width<0)
@@ -641,36 +749,40 @@ namespace cv{
       printf("Rules: roi.width==feat.cols && roi.height = feat.rows \n");
     }
 
-    Mat hann_win;
-    std::vector<Mat> _layers;
-
-    for(int i=0;i<feat.channels();i++)
-      _layers.push_back(hann);
+    // the features of the other scales are resized to the size of the filter
+    if(feat.size() != hann.size()){
+      Mat scaled;
+      resize(feat,scaled,hann.size());
+      feat=scaled;
+    }
 
-    merge(_layers, hann_win);
+    if(hann_custom.channels() != feat.channels()){
+      std::vector<Mat> _layers(feat.channels(), hann);
+      merge(_layers, hann_custom);
+    }
 
-    feat=feat.mul(hann_win); // hann window filter
+    multiply(feat,hann_custom,feat); // hann window filter
 
     return true;
   }
 
-  /* Convert BGR to ColorNames
+  /* Convert BGR to ColorNames and apply the hann window filter in the same pass
    */
-  void TrackerKCFImpl::extractCN(Mat patch_data, Mat & cnFeatures) const {
-    Vec3b & pixel = patch_data.at<Vec3b>(0,0);
-    unsigned index;
+  void TrackerKCFImpl::extractCN(const Mat & patch_data, const Mat & window, Mat & cnFeatures) const {
+    CV_Assert(patch_data.type() == CV_8UC3 && window.size() == patch_data.size());
 
-    if(cnFeatures.type() != CV_64FC(10))
-      cnFeatures = Mat::zeros(patch_data.rows,patch_data.cols,CV_64FC(10));
+    cnFeatures.create(patch_data.rows,patch_data.cols,CV_64FC(10));
 
     for(int i=0;i<patch_data.rows;i++){
-      for(int j=0;j<patch_data.cols;j++){
-        pixel=patch_data.at<Vec3b>(i,j);
-        index=(unsigned)(floor((float)pixel[2]/8)+32*floor((float)pixel[1]/8)+32*32*floor((float)pixel[0]/8));
+      const uchar* pixel=patch_data.ptr<uchar>(i);
+      const double* w=window.ptr<double>(i);
+      double* dst=cnFeatures.ptr<double>(i);
+      for(int j=0;j<patch_data.cols;j++,pixel+=3,dst+=10){
+        const uchar* cn=ColorNames[(pixel[0]>>3)*32*32+(pixel[1]>>3)*32+(pixel[2]>>3)];
 
-        //copy the values
+        // dequantize the values
         for(int _k=0;_k<10;_k++){
-          cnFeatures.at<Vec<double,10> >(i,j)[_k]=ColorNames[index][_k];
+          dst[_k]=w[j]*(ColorNamesShift[_k]+ColorNamesScale[_k]*cn[_k]);
         }
       }
     }
@@ -678,43 +790,32 @@ namespace cv{
   }
 
   /*
-   *  dense gauss kernel function
+   *  dense gauss kernel function, the spectrums and the squared norms of the features are given
+   *  so they are computed only once when the features are correlated several times
    */
-  void TrackerKCFImpl::denseGaussKernel(const double sigma, const Mat x_data, const Mat y_data, Mat & k_data,
-                                        std::vector<Mat> & layers_data,std::vector<Mat> & xf_data,std::vector<Mat> & yf_data, std::vector<Mat> xyf_v, Mat xy, Mat xyf ) const {
-    double normX, normY;
-
-    fft2(x_data,xf_data,layers_data);
-    fft2(y_data,yf_data,layers_data);
-
-    normX=norm(x_data);
-    normX*=normX;
-    normY=norm(y_data);
-    normY*=normY;
-
-    pixelWiseMult(xf_data,yf_data,xyf_v,0,true);
-    sumChannels(xyf_v,xyf);
-    ifft2(xyf,xyf);
+  void TrackerKCFImpl::denseGaussKernel(const double sigma, const std::vector<Mat> & xf_data, const double xx,
+                                        const std::vector<Mat> & yf_data, const double yy, Mat & k_data, Mat & xyf, Mat & xy) const {
+    pixelWiseMultSum(xf_data,yf_data,xyf);
+    ifft2(xyf,xy);
 
     if(params.wrap_kernel){
-      shiftRows(xyf, x_data.rows/2);
-      shiftCols(xyf, x_data.cols/2);
+      shiftRows(xy, xy.rows/2);
+      shiftCols(xy, xy.cols/2);
     }
 
-    //(xx + yy - 2 * xy) / numel(x)
-    xy=(normX+normY-2*xyf)/(x_data.rows*x_data.cols*x_data.channels());
-
-    // TODO: check wether we really need thresholding or not
-    //threshold(xy,xy,0.0,0.0,THRESH_TOZERO);//max(0, (xx + yy - 2 * xy) / numel(x))
+    //exp(-max(0, (xx + yy - 2 * xy) / numel(x)) / sigma^2)
+    double sig=-1.0/(sigma*sigma);
+    double scale=1.0/(xy.rows*xy.cols*(double)xf_data.size());
+    k_data.create(xy.rows, xy.cols, CV_64F);
     for(int i=0;i<xy.rows;i++){
+      const double* src=xy.ptr<double>(i);
+      double* dst=k_data.ptr<double>(i);
       for(int j=0;j<xy.cols;j++){
-        if(xy.at<double>(i,j)<0.0)xy.at<double>(i,j)=0.0;
+        double d=(xx+yy-2*src[j])*scale;
+        dst[j]=sig*(d<0.0?0.0:d);
       }
     }
-
-    double sig=-1.0/(sigma*sigma);
-    xy=sig*xy;
-    exp(xy,k_data);
+    exp(k_data,k_data);
 
   }
 
@@ -784,19 +885,7 @@ namespace cv{
   void TrackerKCFImpl::calcResponse(const Mat alphaf_data, const Mat _alphaf_den, const Mat kf_data, Mat & response_data, Mat & spec_data, Mat & spec2_data) const {
 
     mulSpectrums(alphaf_data,kf_data,spec_data,0,false);
-
-    //z=(a+bi)/(c+di)=[(ac+bd)+i(bc-ad)]/(c^2+d^2)
-    double den;
-    for(int i=0;i<kf_data.rows;i++){
-      for(int j=0;j<kf_data.cols;j++){
-        den=1.0/(_alphaf_den.at<Vec2d>(i,j)[0]*_alphaf_den.at<Vec2d>(i,j)[0]+_alphaf_den.at<Vec2d>(i,j)[1]*_alphaf_den.at<Vec2d>(i,j)[1]);
-        spec2_data.at<Vec2d>(i,j)[0]=
-          (spec_data.at<Vec2d>(i,j)[0]*_alphaf_den.at<Vec2d>(i,j)[0]+spec_data.at<Vec2d>(i,j)[1]*_alphaf_den.at<Vec2d>(i,j)[1])*den;
-        spec2_data.at<Vec2d>(i,j)[1]=
-          (spec_data.at<Vec2d>(i,j)[1]*_alphaf_den.at<Vec2d>(i,j)[0]-spec_data.at<Vec2d>(i,j)[0]*_alphaf_den.at<Vec2d>(i,j)[1])*den;
-      }
-    }
-
+    divSpectrums(spec_data,_alphaf_den,spec2_data);
     ifft2(spec2_data,response_data);
   }
 
@@ -830,6 +919,12 @@ namespace cv{
       compress_feature=true;
       compressed_size=2;
       pca_learning_rate=0.15;
+
+      //scale estimation
+      scale_estimation=false;
+      scale_count=3;
+      scale_step=1.05;
+      scale_penalty=0.95;
   }
 
   void TrackerKCF::Params::read( const cv::FileNode& /*fn*/ ){}
@@ -40,6 +40,7 @@
  //M*/
 
 #include "precomp.hpp"
+#include "sharedFrame.hpp"
 #include "trackerMILModel.hpp"
 
 namespace cv
@@ -56,7 +57,7 @@ class TrackerMILImpl : public TrackerMIL
 
   bool initImpl( const Mat& image, const Rect2d& boundingBox );
   bool updateImpl( const Mat& image, Rect2d& boundingBox );
-  void compute_integral( const Mat & img, Mat & ii_img );
+  static void compute_integral( const Mat & img, Mat & ii_img );
 
   TrackerMIL::Params params;
 };
@@ -137,7 +138,7 @@ bool TrackerMILImpl::initImpl( const Mat& image, const Rect2d& boundingBox )
 {
   srand (1);
   Mat intImage;
-  compute_integral( image, intImage );
+  SharedFrame::preprocess( image, compute_integral, intImage );
   TrackerSamplerCSC::Params CSCparameters;
   CSCparameters.initInRad = params.samplerInitInRadius;
   CSCparameters.searchWinSize = params.samplerSearchWinSize;
@@ -198,7 +199,7 @@ bool TrackerMILImpl::initImpl( const Mat& image, const Rect2d& boundingBox )
 bool TrackerMILImpl::updateImpl( const Mat& image, Rect2d& boundingBox )
 {
   Mat intImage;
-  compute_integral( image, intImage );
+  SharedFrame::preprocess( image, compute_integral, intImage );
 
   //get the last location [AAM] X(k-1)
   Ptr<TrackerTargetState> lastLocation = model->getLastTargetState();
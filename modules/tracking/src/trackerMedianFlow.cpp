@@ -40,6 +40,7 @@
  //M*/
 
 #include "precomp.hpp"
+#include "sharedFrame.hpp"
 #include "opencv2/video/tracking.hpp"
 #include "opencv2/imgproc.hpp"
 #include <algorithm>
@@ -69,11 +70,13 @@ namespace cv
  *
  * FIXME:
  * when patch is cut from image to compute NCC, there can be problem with size
- * optimize (allocation<-->reallocation)
- * optimize (remove vector.erase() calls)
  *       bring "out" all the parameters to TrackerMedianFlow::Param
  */
 
+//parameters of the Lucas-Kanade passes, the pyramids are built for them
+static const int LK_WIN_SIZE = 3;
+static const int LK_MAX_LEVEL = 5;
+
 class TrackerMedianFlowImpl : public TrackerMedianFlow{
  public:
      TrackerMedianFlowImpl(TrackerMedianFlow::Params paramsIn):termcrit(TermCriteria::COUNT|TermCriteria::EPS,20,0.3){params=paramsIn;isInit=false;}
@@ -82,7 +85,7 @@ class TrackerMedianFlowImpl : public TrackerMedianFlow{
  private:
      bool initImpl( const Mat& image, const Rect2d& boundingBox );
      bool updateImpl( const Mat& image, Rect2d& boundingBox );
-     bool medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& oldBox);
+     bool medianFlowImpl(const std::vector<Mat>& oldPyramid,const std::vector<Mat>& newPyramid,Rect2d& oldBox);
      Rect2d vote(const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,const Rect2d& oldRect,Point2f& mD);
      //FIXME: this can be optimized: current method uses sort->select approach, there are O(n) selection algo for median; besides
           //it makes copy all the time
@@ -91,7 +94,7 @@ class TrackerMedianFlowImpl : public TrackerMedianFlow{
      float dist(Point2f p1,Point2f p2);
      std::string type2str(int type);
      void computeStatistics(std::vector<float>& data,int size=-1);
-     void check_FB(const Mat& oldImage,const Mat& newImage,
+     void check_FB(const std::vector<Mat>& oldPyramid,const std::vector<Mat>& newPyramid,
              const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,std::vector<bool>& status);
      void check_NCC(const Mat& oldImage,const Mat& newImage,
              const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,std::vector<bool>& status);
@@ -106,11 +109,11 @@ class TrackerMedianFlowModel : public TrackerModel{
   TrackerMedianFlowModel(TrackerMedianFlow::Params /*params*/){}
   Rect2d getBoundingBox(){return boundingBox_;}
   void setBoudingBox(Rect2d boundingBox){boundingBox_=boundingBox;}
-  Mat getImage(){return image_;}
-  void setImage(const Mat& image){image.copyTo(image_);}
+  const std::vector<Mat>& getPyramid(){return pyramid_;}
+  void setPyramid(const std::vector<Mat>& pyramid){pyramid_=pyramid;}
  protected:
   Rect2d boundingBox_;
-  Mat image_;
+  std::vector<Mat> pyramid_;
   void modelEstimationImpl( const std::vector<Mat>& /*responses*/ ){}
   void modelUpdateImpl(){}
 };
@@ -144,22 +147,36 @@ Ptr<TrackerMedianFlow> TrackerMedianFlow::createTracker(const TrackerMedianFlow:
     return Ptr<TrackerMedianFlowImpl>(new TrackerMedianFlowImpl(parameters));
 }
 
+//grayscale pyramid with the derivatives, it serves both Lucas-Kanade passes:
+//as the next image in the forward pass and as the previous image in the backward pass of the next frame
+static void buildPyramid( const Mat& image, std::vector<Mat>& pyramid ){
+    Mat image_gray;
+    SharedFrame::preprocess( image, convertToGray, image_gray );
+    buildOpticalFlowPyramid( image_gray, pyramid, Size(LK_WIN_SIZE,LK_WIN_SIZE), LK_MAX_LEVEL, true );
+}
+
 bool TrackerMedianFlowImpl::initImpl( const Mat& image, const Rect2d& boundingBox ){
+    std::vector<Mat> pyramid;
+    SharedFrame::preprocess( image, buildPyramid, pyramid );
     model=Ptr<TrackerMedianFlowModel>(new TrackerMedianFlowModel(params));
-    ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setImage(image);
+    ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setPyramid(pyramid);
     ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setBoudingBox(boundingBox);
     return true;
 }
 
 bool TrackerMedianFlowImpl::updateImpl( const Mat& image, Rect2d& boundingBox ){
-    Mat oldImage=((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->getImage();
+    const std::vector<Mat>& oldPyramid=((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->getPyramid();
+
+    //the pyramid of the frame is built once and kept for the next frame
+    std::vector<Mat> pyramid;
+    SharedFrame::preprocess( image, buildPyramid, pyramid );
 
     Rect2d oldBox=((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->getBoundingBox();
-    if(!medianFlowImpl(oldImage,image,oldBox)){
+    if(!medianFlowImpl(oldPyramid,pyramid,oldBox)){
         return false;
     }
     boundingBox=oldBox;
-    ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setImage(image);
+    ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setPyramid(pyramid);
     ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setBoudingBox(oldBox);
     return true;
 }
@@ -186,20 +203,10 @@ std::string TrackerMedianFlowImpl::type2str(int type) {
 
   return r;
 }
-bool TrackerMedianFlowImpl::medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& oldBox){
+//pyramids are grayscale with derivatives, the model keeps the pyramid of the previous frame
+bool TrackerMedianFlowImpl::medianFlowImpl(const std::vector<Mat>& oldPyramid,const std::vector<Mat>& newPyramid,Rect2d& oldBox){
     std::vector<Point2f> pointsToTrackOld,pointsToTrackNew;
 
-    Mat oldImage_gray,newImage_gray;
-    if (oldImage.channels() != 1)
-        cvtColor( oldImage, oldImage_gray, COLOR_BGR2GRAY );
-    else
-        oldImage.copyTo(oldImage_gray);
-
-    if (newImage.channels() != 1)
-        cvtColor( newImage, newImage_gray, COLOR_BGR2GRAY );
-    else
-        newImage.copyTo(newImage_gray);
-
     //"open ended" grid
     for(int i=0;i<params.pointsInGrid;i++){
         for(int j=0;j<params.pointsInGrid;j++){
@@ -211,7 +218,7 @@ bool TrackerMedianFlowImpl::medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& old
 
     std::vector<uchar> status(pointsToTrackOld.size());
     std::vector<float> errors(pointsToTrackOld.size());
-    calcOpticalFlowPyrLK(oldImage_gray, newImage_gray,pointsToTrackOld,pointsToTrackNew,status,errors,Size(3,3),5,termcrit,0);
+    calcOpticalFlowPyrLK(oldPyramid,newPyramid,pointsToTrackOld,pointsToTrackNew,status,errors,Size(LK_WIN_SIZE,LK_WIN_SIZE),LK_MAX_LEVEL,termcrit,0);
     dprintf(("\t%d after LK forward\n",(int)pointsToTrackOld.size()));
 
     std::vector<Point2f> di;
@@ -222,18 +229,20 @@ bool TrackerMedianFlowImpl::medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& old
     }
 
     std::vector<bool> filter_status;
-    check_FB(oldImage_gray,newImage_gray,pointsToTrackOld,pointsToTrackNew,filter_status);
-    check_NCC(oldImage_gray,newImage_gray,pointsToTrackOld,pointsToTrackNew,filter_status);
+    check_FB(oldPyramid,newPyramid,pointsToTrackOld,pointsToTrackNew,filter_status);
+    check_NCC(oldPyramid[0],newPyramid[0],pointsToTrackOld,pointsToTrackNew,filter_status);
 
     // filter
+    int numPoints=0;
     for(int i=0;i<(int)pointsToTrackOld.size();i++){
-        if(!filter_status[i]){
-            pointsToTrackOld.erase(pointsToTrackOld.begin()+i);
-            pointsToTrackNew.erase(pointsToTrackNew.begin()+i);
-            filter_status.erase(filter_status.begin()+i);
-            i--;
+        if(filter_status[i]){
+            pointsToTrackOld[numPoints]=pointsToTrackOld[i];
+            pointsToTrackNew[numPoints]=pointsToTrackNew[i];
+            numPoints++;
         }
     }
+    pointsToTrackOld.resize(numPoints);
+    pointsToTrackNew.resize(numPoints);
     dprintf(("\t%d after LK backward\n",(int)pointsToTrackOld.size()));
 
     if(pointsToTrackOld.size()==0 || di.size()==0){
@@ -255,7 +264,6 @@ bool TrackerMedianFlowImpl::medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& old
 }
 
 Rect2d TrackerMedianFlowImpl::vote(const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,const Rect2d& oldRect,Point2f& mD){
-    static int iteration=0;//FIXME -- we don't want this static var in final release
     Rect2d newRect;
     Point2d newCenter(oldRect.x+oldRect.width/2.0,oldRect.y+oldRect.height/2.0);
     int n=(int)oldPoints.size();
@@ -297,7 +305,7 @@ Rect2d TrackerMedianFlowImpl::vote(const std::vector<Point2f>& oldPoints,const s
     }
 
     double scale=getMedian(buf,n*(n-1)/2);
-    dprintf(("iter %d %f %f %f\n",iteration,xshift,yshift,scale));
+    dprintf(("%f %f %f\n",xshift,yshift,scale));
     newRect.x=newCenter.x-scale*oldRect.width/2.0;
     newRect.y=newCenter.y-scale*oldRect.height/2.0;
     newRect.width=scale*oldRect.width;
@@ -308,7 +316,6 @@ Rect2d TrackerMedianFlowImpl::vote(const std::vector<Point2f>& oldPoints,const s
     dprintf(("rect old [%f %f %f %f]\n",oldRect.x,oldRect.y,oldRect.width,oldRect.height));
     dprintf(("rect [%f %f %f %f]\n",newRect.x,newRect.y,newRect.width,newRect.height));
 
-    iteration++;
     return newRect;
 }
 
@@ -344,7 +351,7 @@ double TrackerMedianFlowImpl::l2distance(Point2f p1,Point2f p2){
     double dx=p1.x-p2.x, dy=p1.y-p2.y;
     return sqrt(dx*dx+dy*dy);
 }
-void TrackerMedianFlowImpl::check_FB(const Mat& oldImage,const Mat& newImage,
+void TrackerMedianFlowImpl::check_FB(const std::vector<Mat>& oldPyramid,const std::vector<Mat>& newPyramid,
         const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,std::vector<bool>& status){
 
     if(status.size()==0){
@@ -355,7 +362,7 @@ void TrackerMedianFlowImpl::check_FB(const Mat& oldImage,const Mat& newImage,
     std::vector<float> errors(oldPoints.size());
     std::vector<double> FBerror(oldPoints.size());
     std::vector<Point2f> pointsToTrackReprojection;
-    calcOpticalFlowPyrLK(newImage, oldImage,newPoints,pointsToTrackReprojection,LKstatus,errors,Size(3,3),5,termcrit,0);
+    calcOpticalFlowPyrLK(newPyramid,oldPyramid,newPoints,pointsToTrackReprojection,LKstatus,errors,Size(LK_WIN_SIZE,LK_WIN_SIZE),LK_MAX_LEVEL,termcrit,0);
 
     for(int i=0;i<(int)oldPoints.size();i++){
         FBerror[i]=l2distance(oldPoints[i],pointsToTrackReprojection[i]);
@@ -367,29 +374,57 @@ void TrackerMedianFlowImpl::check_FB(const Mat& oldImage,const Mat& newImage,
         status[i]=(FBerror[i]<FBerrorMedian);
     }
 }
+//NCC of the 30x30 patches around the point pairs
+static void computePatchNCC(const Mat& oldImage,const Mat& newImage,
+        const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,std::vector<float>& NCC){
+
+    CV_Assert(oldImage.type()==CV_8UC1 && newImage.type()==CV_8UC1);
+
+    const int N=900;
+    int numPoints=(int)oldPoints.size();
+    NCC.assign(numPoints,0.0f);
+    Size patch(30,30);
+
+    //patches of all points are cut first, then the correlations are computed in one pass over them
+    Mat oldPatches(numPoints*patch.height,patch.width,oldImage.type());
+    Mat newPatches(numPoints*patch.height,patch.width,newImage.type());
+    for (int i = 0; i < numPoints; i++) {
+        Mat p1=oldPatches.rowRange(i*patch.height,(i+1)*patch.height);
+        Mat p2=newPatches.rowRange(i*patch.height,(i+1)*patch.height);
+        getRectSubPix( oldImage, patch, oldPoints[i],p1);
+        getRectSubPix( newImage, patch, newPoints[i],p2);
+    }
+
+    for (int i = 0; i < numPoints; i++) {
+        const uchar* p1=oldPatches.ptr<uchar>(i*patch.height);
+        const uchar* p2=newPatches.ptr<uchar>(i*patch.height);
+
+        //sums, sums of squares and the dot product are integers for the 8-bit patches
+        int s1=0,s2=0,q1=0,q2=0,p12=0;
+        for(int j=0;j<N;j++){
+            int a=p1[j],b=p2[j];
+            s1+=a;
+            s2+=b;
+            q1+=a*a;
+            q2+=b*b;
+            p12+=a*b;
+        }
+
+        double sq1=sqrt(q1-(double)s1*s1/N),sq2=sqrt(q2-(double)s2*s2/N);
+        double ares=(sq2==0)?sq1/abs(sq1):(p12-(double)s1*s2/N)/sq1/sq2;
+
+        NCC[i] = (float)ares;
+    }
+}
+
 void TrackerMedianFlowImpl::check_NCC(const Mat& oldImage,const Mat& newImage,
         const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,std::vector<bool>& status){
 
-    std::vector<float> NCC(oldPoints.size(),0.0);
-    Size patch(30,30);
-    Mat p1,p2;
-
-	for (int i = 0; i < (int)oldPoints.size(); i++) {
-		getRectSubPix( oldImage, patch, oldPoints[i],p1);
-		getRectSubPix( newImage, patch, newPoints[i],p2);
-
-        const int N=900;
-        double s1=sum(p1)(0),s2=sum(p2)(0);
-        double n1=norm(p1),n2=norm(p2);
-        double prod=p1.dot(p2);
-        double sq1=sqrt(n1*n1-s1*s1/N),sq2=sqrt(n2*n2-s2*s2/N);
-        double ares=(sq2==0)?sq1/abs(sq1):(prod-s1*s2/N)/sq1/sq2;
-
-		NCC[i] = (float)ares;
-	}
-	float median = getMedian(NCC);
-	for(int i = 0; i < (int)oldPoints.size(); i++) {
+    std::vector<float> NCC;
+    computePatchNCC(oldImage,newImage,oldPoints,newPoints,NCC);
+    float median = getMedian(NCC);
+    for(int i = 0; i < (int)oldPoints.size(); i++) {
         status[i] = status[i] && (NCC[i]>median);
-	}
+    }
 }
 } /* namespace cv */
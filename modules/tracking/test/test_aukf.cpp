@@ -434,3 +434,143 @@ TEST(AUKF, ungm_mean_squared_error)
 
     ASSERT_GE( mse_treshold, average_error );
 }
+
+// AUKF written with matrix expressions, as the filter was before its working matrices were preallocated.
+// The estimates x* and P are reassigned by every step, so the sigma points are drawn around the initial xa* and Pa.
+class AugmentedUnscentedKalmanFilterReference
+{
+public:
+    AugmentedUnscentedKalmanFilterReference( const AugmentedUnscentedKalmanFilterParams& params ) : model( params.model )
+    {
+        DP = params.DP;
+        MP = params.MP;
+        DAug = DP + DP + MP;
+
+        stateAug = Mat::zeros( DAug, 1, CV_64F );
+        Mat x = stateAug( Rect( 0, 0, 1, DP ) );
+        params.stateInit.copyTo( x );
+
+        errorCovAug = Mat::zeros( DAug, DAug, CV_64F );
+        Mat P = errorCovAug( Rect( 0, 0, DP, DP ) );
+        Mat Q = errorCovAug( Rect( DP, DP, DP, DP ) );
+        Mat R = errorCovAug( Rect( 2*DP, 2*DP, MP, MP ) );
+        params.errorCovInit.copyTo( P );
+        params.processNoiseCov.copyTo( Q );
+        params.measurementNoiseCov.copyTo( R );
+
+        state = params.stateInit.clone();
+        errorCov = params.errorCovInit.clone();
+
+        double lambda = params.alpha*params.alpha*( DAug + params.k ) - DAug;
+        tmpLambda = lambda + DAug;
+        Wm = 0.5/tmpLambda * Mat::ones( 2*DAug+1, 1, CV_64F );
+        Wc = 0.5/tmpLambda * Mat::eye( 2*DAug+1, 2*DAug+1, CV_64F );
+        Wm.at<double>(0, 0) = lambda/tmpLambda;
+        Wc.at<double>(0, 0) = lambda/tmpLambda + 1.0 - params.alpha*params.alpha + params.beta;
+
+        transitionSPFuncVals = Mat::zeros( DP, 2*DAug+1, CV_64F );
+        measurementSPFuncVals = Mat::zeros( MP, 2*DAug+1, CV_64F );
+    }
+
+    Mat predict( const Mat& control )
+    {
+        Mat sigmaPoints = getSigmaPoints();
+        for (int i = 0; i < 2*DAug+1; i++)
+        {
+            Mat fx = transitionSPFuncVals( Rect( i, 0, 1, DP ) );
+            model->stateConversionFunction( sigmaPoints( Rect( i, 0, 1, DP ) ), control, sigmaPoints( Rect( i, DP, 1, DP ) ), fx );
+        }
+
+        state = transitionSPFuncVals * Wm;
+        transitionSPFuncValsCenter = transitionSPFuncVals - repeat( state, 1, 2*DAug+1 );
+        errorCov = transitionSPFuncValsCenter * Wc * transitionSPFuncValsCenter.t();
+        return state.clone();
+    }
+
+    Mat correct( const Mat& measurement )
+    {
+        Mat sigmaPoints = getSigmaPoints();
+        for (int i = 0; i < 2*DAug+1; i++)
+        {
+            Mat hx = measurementSPFuncVals( Rect( i, 0, 1, MP ) );
+            model->measurementFunction( transitionSPFuncVals( Rect( i, 0, 1, DP ) ), sigmaPoints( Rect( i, 2*DP, 1, MP ) ), hx );
+        }
+
+        Mat measurementEstimate = measurementSPFuncVals * Wm;
+        Mat measurementSPFuncValsCenter = measurementSPFuncVals - repeat( measurementEstimate, 1, 2*DAug+1 );
+        Mat yyCov = measurementSPFuncValsCenter * Wc * measurementSPFuncValsCenter.t();
+        Mat xyCov = transitionSPFuncValsCenter * Wc * measurementSPFuncValsCenter.t();
+        Mat gain = xyCov * yyCov.inv( DECOMP_SVD );
+
+        state = state + gain * ( measurement - measurementEstimate );
+        errorCov = errorCov - gain * xyCov.t();
+        return state.clone();
+    }
+
+    Mat getErrorCov() const
+    {
+        return errorCov.clone();
+    }
+
+private:
+    Mat getSigmaPoints() const
+    {
+        // lower Cholesky factor of Pa
+        Mat L = Mat::zeros( DAug, DAug, CV_64F );
+        for (int i = 0; i < DAug; i++)
+        {
+            for (int j = 0; j <= i; j++)
+            {
+                double s = errorCovAug.at<double>(i, j);
+                for (int k = 0; k < j; k++)
+                    s -= L.at<double>(i, k)*L.at<double>(j, k);
+                L.at<double>(i, j) = ( i == j ) ? sqrt( s ) : s/L.at<double>(j, j);
+            }
+        }
+        L *= sqrt( tmpLambda );
+
+        Mat points = repeat( stateAug, 1, 2*DAug+1 );
+        Mat p_plus = points( Rect( 1, 0, DAug, DAug ) );
+        Mat p_minus = points( Rect( DAug+1, 0, DAug, DAug ) );
+        p_plus += L;
+        p_minus -= L;
+        return points;
+    }
+
+    Ptr<UkfSystemModel> model;
+    int DP, MP, DAug;
+    double tmpLambda;
+    Mat state, errorCov, stateAug, errorCovAug, Wm, Wc;
+    Mat transitionSPFuncVals, transitionSPFuncValsCenter, measurementSPFuncVals;
+};
+
+TEST(AUKF, ungm_matches_reference)
+{
+    Ptr<UnivariateNonstationaryGrowthModel> model( new UnivariateNonstationaryGrowthModel() );
+    AugmentedUnscentedKalmanFilterParams params( 1, 1, 0, 1.0, 1.0, model );
+    params.stateInit.at<double>(0, 0) = 0.5;
+    params.errorCovInit.at<double>(0, 0) = 2.0;
+    params.alpha = 1.5;
+
+    Ptr<UnscentedKalmanFilter> aukf = createAugmentedUnscentedKalmanFilter( params );
+    AugmentedUnscentedKalmanFilterReference reference( params );
+
+    RNG rng( 216 );
+    Mat state( 1, 1, CV_64F, Scalar( 0.1 ) ), q( 1, 1, CV_64F ), r( 1, 1, CV_64F );
+    Mat u( 1, 1, CV_64F ), measurement( 1, 1, CV_64F );
+    for (int i = 0; i < 100; i++)
+    {
+        rng.fill( q, RNG::NORMAL, Scalar::all(0), Scalar::all(1) );
+        rng.fill( r, RNG::NORMAL, Scalar::all(0), Scalar::all(1) );
+        u.at<double>(0, 0) = (double)i;
+        model->stateConversionFunction( state, u, q, state );
+        model->measurementFunction( state, r, measurement );
+
+        Mat predicted = reference.predict( u );
+        ASSERT_LE( norm( aukf->predict( u ), predicted, NORM_INF ), 1e-9*( 1.0 + norm( predicted, NORM_INF ) ) ) << "step " << i;
+        Mat corrected = reference.correct( measurement );
+        ASSERT_LE( norm( aukf->correct( measurement ), corrected, NORM_INF ), 1e-9*( 1.0 + norm( corrected, NORM_INF ) ) ) << "step " << i;
+        Mat errorCov = reference.getErrorCov();
+        ASSERT_LE( norm( aukf->getErrorCov(), errorCov, NORM_INF ), 1e-9*( 1.0 + norm( errorCov, NORM_INF ) ) ) << "step " << i;
+    }
+}
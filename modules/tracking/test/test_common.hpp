@@ -0,0 +1,109 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#ifndef __OPENCV_TRACKING_TEST_COMMON_HPP__
+#define __OPENCV_TRACKING_TEST_COMMON_HPP__
+
+namespace cvtest
+{
+
+// Synthetic sequence of textured targets over a blurred textured background. The background and the
+// textures of the targets are drawn from the same seeded generator, so the frames are reproducible.
+class SyntheticSequence
+{
+ public:
+  SyntheticSequence( cv::Size frameSize, int type, int backgroundBlur = 5 ) :
+      rng( 0 ), frameType( type )
+  {
+    background = randomTexture( frameSize, backgroundBlur );
+  }
+
+  // adds a target with a random texture of the given size, returns its index
+  int addTarget( cv::Size size, int blur = 3 )
+  {
+    textures.push_back( randomTexture( size, blur ) );
+    return (int)textures.size() - 1;
+  }
+
+  // frame with the targets drawn at the given boxes, the textures are resized to the boxes
+  cv::Mat render( const std::vector<cv::Rect>& boxes ) const
+  {
+    CV_Assert( boxes.size() <= textures.size() );
+    cv::Mat frame = background.clone(), scaled;
+    for ( size_t i = 0; i < boxes.size(); i++ )
+    {
+      if( boxes[i].size() == textures[i].size() )
+        textures[i].copyTo( frame( boxes[i] ) );
+      else
+      {
+        cv::resize( textures[i], scaled, boxes[i].size() );
+        scaled.copyTo( frame( boxes[i] ) );
+      }
+    }
+    return frame;
+  }
+
+  // frame with a single target drawn at the given box
+  cv::Mat render( const cv::Rect& box ) const
+  {
+    return render( std::vector<cv::Rect>( 1, box ) );
+  }
+
+  cv::RNG rng;
+  cv::Mat background;
+  std::vector<cv::Mat> textures;
+
+ private:
+  cv::Mat randomTexture( cv::Size size, int blur )
+  {
+    cv::Mat texture( size, frameType );
+    rng.fill( texture, cv::RNG::UNIFORM, 0, 256 );
+    if( blur > 1 )
+      cv::GaussianBlur( texture, texture, cv::Size( blur, blur ), 0 );
+    return texture;
+  }
+
+  int frameType;
+};
+
+}
+
+#endif
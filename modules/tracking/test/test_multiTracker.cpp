@@ -0,0 +1,104 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2015, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+
+// frames with textured targets moving over textured background
+static void generateFrames( std::vector<Mat>& frames, std::vector<Rect2d>& targets, int numFrames )
+{
+  cvtest::SyntheticSequence sequence( Size( 320, 240 ), CV_8UC3 );
+  const int numTargets = 4;
+  targets.clear();
+  for ( int i = 0; i < numTargets; i++ )
+  {
+    sequence.addTarget( Size( 30, 40 ), 0 );
+    targets.push_back( Rect2d( 30 + 70 * i, 60 + 20 * i, 30, 40 ) );
+  }
+
+  frames.resize( numFrames );
+  std::vector<Rect> boxes( numTargets );
+  for ( int f = 0; f < numFrames; f++ )
+  {
+    for ( int i = 0; i < numTargets; i++ )
+      boxes[i] = Rect( (int)targets[i].x + 2 * f, (int)targets[i].y + ( i % 2 ? f : -f ), 30, 40 );
+    frames[f] = sequence.render( boxes );
+  }
+}
+
+static void track( const String& trackerType, bool parallel, const std::vector<Mat>& frames,
+                   const std::vector<Rect2d>& targets, std::vector<std::vector<Rect2d> >& results )
+{
+  MultiTracker trackers( trackerType );
+  trackers.setParallelUpdate( parallel );
+  ASSERT_TRUE( trackers.add( frames[0], targets ) );
+
+  results.resize( frames.size() - 1 );
+  for ( size_t f = 1; f < frames.size(); f++ )
+    ASSERT_TRUE( trackers.update( frames[f], results[f - 1] ) );
+}
+
+class MultiTrackerTest : public ::testing::TestWithParam<String>
+{
+};
+
+TEST_P( MultiTrackerTest, ParallelUpdate )
+{
+  std::vector<Mat> frames;
+  std::vector<Rect2d> targets;
+  generateFrames( frames, targets, 6 );
+
+  std::vector<std::vector<Rect2d> > sequential, parallel;
+  track( GetParam(), false, frames, targets, sequential );
+  track( GetParam(), true, frames, targets, parallel );
+
+  ASSERT_EQ( sequential.size(), parallel.size() );
+  for ( size_t f = 0; f < sequential.size(); f++ )
+  {
+    ASSERT_EQ( sequential[f].size(), targets.size() );
+    ASSERT_EQ( parallel[f].size(), targets.size() );
+    for ( size_t i = 0; i < targets.size(); i++ )
+      EXPECT_EQ( sequential[f][i], parallel[f][i] ) << "frame " << f << ", target " << i;
+  }
+}
+
+INSTANTIATE_TEST_CASE_P( Tracking, MultiTrackerTest, ::testing::Values( "MEDIANFLOW", "MIL", "KCF", "TLD" ) );
@@ -0,0 +1,245 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "test_precomp.hpp"
+#include "opencv2/tracking/onlineMIL.hpp"
+
+using namespace cv;
+
+static const int numFeat = 40;
+static const int numSel = 10;
+static const float lRate = 0.85f;
+
+// distinct gaps between the classes, so the likelihoods of the weak classifiers are far from ties
+static std::vector<float> generateGaps()
+{
+  std::vector<float> gaps( numFeat );
+  for ( int k = 0; k < numFeat; k++ )
+    gaps[k] = 0.1f + 0.07f * ( ( k * 17 ) % numFeat );
+  return gaps;
+}
+
+// samples with one row per sample, the positive ones are shifted by a different gap in every feature
+static void generateSamples( RNG& rng, const std::vector<float>& gaps, Mat& posx, Mat& negx )
+{
+  posx.create( 31, numFeat, CV_32F );
+  negx.create( 63, numFeat, CV_32F );
+  rng.fill( posx, RNG::NORMAL, 0, 1 );
+  rng.fill( negx, RNG::NORMAL, 0, 1 );
+  for ( int i = 0; i < posx.rows; i++ )
+    for ( int k = 0; k < numFeat; k++ )
+      posx.at<float>( i, k ) += gaps[k];
+}
+
+// scalar MIL boosting as it was before the feature-major rewrite
+struct StumpReference
+{
+  StumpReference() : mu0( 0 ), mu1( 0 ), sig0( 1 ), sig1( 1 ), e0( 0 ), e1( 0 ), log_n0( 0 ), log_n1( 0 ), trained( false ) {}
+
+  void updateGaussian( const Mat& x, float& mu, float& sig )
+  {
+    if( trained )
+    {
+      mu = lRate * mu + ( 1 - lRate ) * float( mean( x )[0] );
+      Mat diff = x - mu;
+      sig = lRate * sig + ( 1 - lRate ) * float( mean( diff.mul( diff ) )[0] );
+    }
+    else
+    {
+      Scalar scal_mean, scal_std_dev;
+      meanStdDev( x, scal_mean, scal_std_dev );
+      mu = float( scal_mean[0] );
+      sig = float( scal_std_dev[0] ) * float( scal_std_dev[0] ) + 1e-9f;
+    }
+  }
+
+  void update( const Mat& posx, const Mat& negx, int ind )
+  {
+    updateGaussian( posx.col( ind ), mu1, sig1 );
+    updateGaussian( negx.col( ind ), mu0, sig0 );
+    trained = true;
+    log_n0 = std::log( float( 1.0f / pow( sig0, 0.5f ) ) );
+    log_n1 = std::log( float( 1.0f / pow( sig1, 0.5f ) ) );
+    e1 = -1.0f / ( 2.0f * sig1 + std::numeric_limits<float>::min() );
+    e0 = -1.0f / ( 2.0f * sig0 + std::numeric_limits<float>::min() );
+  }
+
+  float classifyF( float xx ) const
+  {
+    double log_p0 = ( xx - mu0 ) * ( xx - mu0 ) * e0 + log_n0;
+    double log_p1 = ( xx - mu1 ) * ( xx - mu1 ) * e1 + log_n1;
+    return float( log_p1 - log_p0 );
+  }
+
+  float mu0, mu1, sig0, sig1, e0, e1, log_n0, log_n1;
+  bool trained;
+};
+
+static float sigmoid( float x )
+{
+  return 1.0f / ( 1.0f + exp( -x ) );
+}
+
+static void updateReference( std::vector<StumpReference>& stumps, const Mat& posx, const Mat& negx, std::vector<int>& selectors )
+{
+  int numpos = posx.rows, numneg = negx.rows;
+  std::vector<std::vector<float> > pospred( numFeat, std::vector<float>( numpos ) ), negpred( numFeat, std::vector<float>( numneg ) );
+  for ( int m = 0; m < numFeat; m++ )
+  {
+    stumps[m].update( posx, negx, m );
+    for ( int j = 0; j < numpos; j++ )
+      pospred[m][j] = stumps[m].classifyF( posx.at<float>( j, m ) );
+    for ( int j = 0; j < numneg; j++ )
+      negpred[m][j] = stumps[m].classifyF( negx.at<float>( j, m ) );
+  }
+
+  std::vector<float> Hpos( numpos, 0.0f ), Hneg( numneg, 0.0f );
+  selectors.clear();
+  for ( int s = 0; s < numSel; s++ )
+  {
+    int best = -1;
+    float bestLikl = 0.0f;
+    for ( int w = 0; w < numFeat; w++ )
+    {
+      if( std::find( selectors.begin(), selectors.end(), w ) != selectors.end() )
+        continue;
+
+      float lll = 1.0f;
+      for ( int j = 0; j < numpos; j++ )
+        lll *= ( 1 - sigmoid( Hpos[j] + pospred[w][j] ) );
+      float poslikl = (float) -log( 1 - lll + 1e-5 );
+
+      float neglikl = 0.0f;
+      for ( int j = 0; j < numneg; j++ )
+        neglikl += (float) -log( 1e-5f + 1 - sigmoid( Hneg[j] + negpred[w][j] ) );
+
+      float likl = poslikl / numpos + neglikl / numneg;
+      if( best < 0 || likl < bestLikl )
+      {
+        best = w;
+        bestLikl = likl;
+      }
+    }
+    selectors.push_back( best );
+    for ( int j = 0; j < numpos; j++ )
+      Hpos[j] += pospred[best][j];
+    for ( int j = 0; j < numneg; j++ )
+      Hneg[j] += negpred[best][j];
+  }
+}
+
+static std::vector<float> classifyReference( const std::vector<StumpReference>& stumps, const std::vector<int>& selectors, const Mat& x )
+{
+  std::vector<float> res( x.rows, 0.0f );
+  for ( size_t w = 0; w < selectors.size(); w++ )
+    for ( int j = 0; j < x.rows; j++ )
+      res[j] += stumps[selectors[w]].classifyF( x.at<float>( j, selectors[w] ) );
+  return res;
+}
+
+// a few online updates, each of them followed by the classification of new samples,
+// the responses depend on the weak classifiers selected by the update
+static void runMilBoost( int numThreads, std::vector<std::vector<float> >& responses )
+{
+  int savedThreads = getNumThreads();
+  setNumThreads( numThreads );
+
+  RNG rng( 0 );
+  std::vector<float> gaps = generateGaps();
+
+  ClfMilBoost::Params params;
+  params._numFeat = numFeat;
+  params._numSel = numSel;
+  params._lRate = lRate;
+  ClfMilBoost boost;
+  boost.init( params );
+
+  for ( int u = 0; u < 3; u++ )
+  {
+    Mat posx, negx, x;
+    generateSamples( rng, gaps, posx, negx );
+    boost.update( posx, negx );
+
+    generateSamples( rng, gaps, x, negx );
+    x.push_back( negx );
+    responses.push_back( boost.classify( x ) );
+  }
+
+  setNumThreads( savedThreads );
+}
+
+TEST( ClfMilBoost, ThreadCountDoesNotChangeResults )
+{
+  std::vector<std::vector<float> > single, multi;
+  runMilBoost( 1, single );
+  runMilBoost( 4, multi );
+
+  ASSERT_EQ( single.size(), multi.size() );
+  for ( size_t u = 0; u < single.size(); u++ )
+    EXPECT_EQ( single[u], multi[u] ) << "update " << u;
+}
+
+TEST( ClfMilBoost, MatchesScalarReference )
+{
+  std::vector<std::vector<float> > responses;
+  runMilBoost( 4, responses );
+
+  // the same samples go through the scalar implementation
+  RNG rng( 0 );
+  std::vector<float> gaps = generateGaps();
+  std::vector<StumpReference> stumps( numFeat );
+
+  ASSERT_EQ( responses.size(), 3u );
+  for ( int u = 0; u < 3; u++ )
+  {
+    Mat posx, negx, x;
+    generateSamples( rng, gaps, posx, negx );
+    std::vector<int> selectors;
+    updateReference( stumps, posx, negx, selectors );
+
+    generateSamples( rng, gaps, x, negx );
+    x.push_back( negx );
+    std::vector<float> expected = classifyReference( stumps, selectors, x );
+    ASSERT_EQ( expected.size(), responses[u].size() );
+    for ( size_t j = 0; j < expected.size(); j++ )
+      EXPECT_NEAR( expected[j], responses[u][j], 1e-4 * std::max( 1.0f, std::abs( expected[j] ) ) ) << "update " << u << ", sample " << j;
+  }
+}
@@ -15,5 +15,6 @@
 #include "opencv2/tracking.hpp"
 #include "opencv2/highgui.hpp"
 #include "opencv2/videoio.hpp"
+#include "test_common.hpp"
 
 #endif
@@ -0,0 +1,107 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+
+// frames with a textured target which moves slowly and then jumps to the other side of the frame,
+// where only the detector can find it; the flat region lets the variance filter reject a part of the windows
+static void generateJumpingTarget( std::vector<Mat>& frames, std::vector<Rect2d>& targets, int numFrames, int jumpFrame, double jumpScale )
+{
+  cvtest::SyntheticSequence sequence( Size( 320, 240 ), CV_8UC3 );
+  sequence.background( Rect( 150, 0, 60, 240 ) ).setTo( Scalar::all( 128 ) );
+  sequence.addTarget( Size( 40, 40 ) );
+
+  frames.resize( numFrames );
+  targets.resize( numFrames );
+  for ( int f = 0; f < numFrames; f++ )
+  {
+    Rect roi( 40 + f, 60 + f, 40, 40 );
+    if( f >= jumpFrame )
+    {
+      Size size( cvRound( 40 * jumpScale ), cvRound( 40 * jumpScale ) );
+      roi = Rect( 230, 150, size.width, size.height );
+    }
+    frames[f] = sequence.render( roi );
+    targets[f] = roi;
+  }
+}
+
+static double overlap( const Rect2d& r1, const Rect2d& r2 )
+{
+  double intersection = ( r1 & r2 ).area();
+  return intersection / ( r1.area() + r2.area() - intersection );
+}
+
+// the target lost by the short-term tracker has to be found again by the window scan of the detector
+static void checkRedetection( double jumpScale )
+{
+  const int numFrames = 16, jumpFrame = 10;
+  std::vector<Mat> frames;
+  std::vector<Rect2d> targets;
+  generateJumpingTarget( frames, targets, numFrames, jumpFrame, jumpScale );
+
+  Ptr<Tracker> tracker = TrackerTLD::createTracker();
+  Rect2d boundingBox = targets[0];
+  ASSERT_TRUE( tracker->init( frames[0], boundingBox ) );
+  for ( int f = 1; f < jumpFrame; f++ )
+  {
+    ASSERT_TRUE( tracker->update( frames[f], boundingBox ) ) << "frame " << f;
+    EXPECT_GT( overlap( targets[f], boundingBox ), 0.5 ) << "frame " << f;
+  }
+
+  bool found = false;
+  for ( int f = jumpFrame; f < numFrames && !found; f++ )
+    found = tracker->update( frames[f], boundingBox ) && overlap( targets[f], boundingBox ) > 0.5;
+  EXPECT_TRUE( found );
+}
+
+TEST( TrackerTLD, RedetectsTarget )
+{
+  checkRedetection( 1.0 );
+}
+
+// the grown target is found in the downscaled levels of the pyramid
+TEST( TrackerTLD, RedetectsScaledTarget )
+{
+  checkRedetection( 1.2 );
+}
@@ -0,0 +1,177 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+
+static const Size patchSize( 30, 24 );
+
+// integral image of a random frame in the given depth
+static Mat generateIntegral( int depth )
+{
+  RNG rng( 0 );
+  Mat frame( 120, 160, CV_8U );
+  rng.fill( frame, RNG::UNIFORM, 0, 256 );
+  Mat sum;
+  integral( frame, sum, depth );
+  return sum;
+}
+
+// samples cut from one integral image, as the MIL and Boosting samplers do
+static void cutSamples( const Mat& sum, std::vector<Mat>& samples )
+{
+  samples.clear();
+  for ( int y = 0; y + patchSize.height < sum.rows; y += 13 )
+    for ( int x = 0; x + patchSize.width < sum.cols; x += 11 )
+      samples.push_back( sum( Rect( Point( x, y ), patchSize ) ) );
+}
+
+// responses of the features computed sample by sample: a batch which contains a sample of another type
+// is not uniform, so each of its samples is evaluated separately
+static void checkResponses( TrackerFeatureHAAR& haar, const std::vector<Mat>& samples, const std::vector<int>& featureIdx,
+                            const Mat& response )
+{
+  ASSERT_EQ( response.type(), CV_32FC1 );
+  ASSERT_EQ( response.cols, (int)samples.size() );
+  Mat other32s = generateIntegral( CV_32S )( Rect( Point( 5, 7 ), patchSize ) );
+  Mat other64f = generateIntegral( CV_64F )( Rect( Point( 5, 7 ), patchSize ) );
+  for ( size_t i = 0; i < samples.size(); i++ )
+  {
+    std::vector<Mat> single( 1, samples[i] );
+    single.push_back( samples[i].depth() == CV_32S ? other64f : other32s );
+    Mat expected;
+    haar.compute( single, expected );
+    ASSERT_EQ( 2, expected.cols );
+    for ( size_t j = 0; j < featureIdx.size(); j++ )
+      EXPECT_EQ( expected.at<float>( featureIdx[j], 0 ), response.at<float>( featureIdx[j], (int)i ) ) << "feature " << featureIdx[j] << ", sample " << i;
+  }
+}
+
+class TrackerFeatureHAARTest : public ::testing::TestWithParam<int>
+{
+};
+
+TEST_P( TrackerFeatureHAARTest, BatchMatchesSingle )
+{
+  TrackerFeatureHAAR::Params params;
+  params.numFeatures = 60;
+  params.rectSize = patchSize;
+  params.isIntegral = true;
+  TrackerFeatureHAAR haar( params );
+
+  std::vector<Mat> samples;
+  cutSamples( generateIntegral( GetParam() ), samples );
+
+  Mat response;
+  haar.compute( samples, response );
+  ASSERT_EQ( response.rows, params.numFeatures );
+
+  std::vector<int> featureIdx( params.numFeatures );
+  for ( int j = 0; j < params.numFeatures; j++ )
+    featureIdx[j] = j;
+  checkResponses( haar, samples, featureIdx, response );
+}
+
+TEST_P( TrackerFeatureHAARTest, ExtractSelectedMatchesSingle )
+{
+  TrackerFeatureHAAR::Params params;
+  params.numFeatures = 60;
+  params.rectSize = patchSize;
+  params.isIntegral = true;
+  TrackerFeatureHAAR haar( params );
+
+  std::vector<Mat> samples;
+  cutSamples( generateIntegral( GetParam() ), samples );
+
+  std::vector<int> selFeatures;
+  for ( int j = params.numFeatures - 1; j >= 0; j -= 3 )
+    selFeatures.push_back( j );
+
+  Mat response;
+  ASSERT_TRUE( haar.extractSelected( selFeatures, samples, response ) );
+  ASSERT_EQ( response.rows, params.numFeatures );
+  checkResponses( haar, samples, selFeatures, response );
+
+  // the rows of the features which are not selected stay zero
+  for ( int j = 0; j < params.numFeatures; j++ )
+    if( std::find( selFeatures.begin(), selFeatures.end(), j ) == selFeatures.end() )
+      EXPECT_EQ( 0, countNonZero( response.row( j ) ) ) << "feature " << j;
+}
+
+INSTANTIATE_TEST_CASE_P( Tracking, TrackerFeatureHAARTest, ::testing::Values( (int)CV_32S, (int)CV_64F ) );
+
+TEST( TrackerFeatureHAAR, MixedBatchMatchesSingle )
+{
+  TrackerFeatureHAAR::Params params;
+  params.numFeatures = 60;
+  params.rectSize = patchSize;
+  params.isIntegral = true;
+  TrackerFeatureHAAR haar( params );
+
+  std::vector<Mat> samples32s, samples64f;
+  cutSamples( generateIntegral( CV_32S ), samples32s );
+  cutSamples( generateIntegral( CV_64F ), samples64f );
+
+  // batches which differ from the first sample in size, type or row step are evaluated sample by sample
+  std::vector<std::vector<Mat> > batches( 3 );
+  batches[0] = samples32s;
+  batches[0][1] = generateIntegral( CV_32S )( Rect( Point( 5, 7 ), patchSize + Size( 6, 4 ) ) );
+  batches[1] = samples32s;
+  batches[1][2] = samples64f[2];
+  batches[2] = samples64f;
+  batches[2][3] = samples64f[3].clone();
+
+  std::vector<int> featureIdx( params.numFeatures );
+  for ( int j = 0; j < params.numFeatures; j++ )
+    featureIdx[j] = j;
+
+  for ( size_t b = 0; b < batches.size(); b++ )
+  {
+    SCOPED_TRACE( format( "batch %d", (int)b ) );
+    Mat response;
+    haar.compute( batches[b], response );
+    checkResponses( haar, batches[b], featureIdx, response );
+
+    ASSERT_TRUE( haar.extractSelected( featureIdx, batches[b], response ) );
+    checkResponses( haar, batches[b], featureIdx, response );
+  }
+}
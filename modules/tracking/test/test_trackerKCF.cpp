@@ -0,0 +1,147 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+
+// frames with a textured target growing in the center of a textured background
+static void generateGrowingTarget( std::vector<Mat>& frames, std::vector<Rect2d>& targets, int numFrames, double growth )
+{
+  cvtest::SyntheticSequence sequence( Size( 320, 240 ), CV_8UC3 );
+  Size textureSize( 40, 40 );
+  sequence.addTarget( textureSize );
+
+  frames.resize( numFrames );
+  targets.resize( numFrames );
+  for ( int f = 0; f < numFrames; f++ )
+  {
+    double scale = std::pow( growth, f );
+    Size size( cvRound( textureSize.width * scale ), cvRound( textureSize.height * scale ) );
+    Rect roi( 160 - size.width / 2, 120 - size.height / 2, size.width, size.height );
+    frames[f] = sequence.render( roi );
+    targets[f] = roi;
+  }
+}
+
+// frames with a textured target moving over a textured background by @p step pixels per frame
+static void generateMovingTarget( std::vector<Mat>& frames, std::vector<Rect2d>& targets, int numFrames, Point step )
+{
+  cvtest::SyntheticSequence sequence( Size( 320, 240 ), CV_8UC3 );
+  sequence.addTarget( Size( 40, 40 ) );
+
+  frames.resize( numFrames );
+  targets.resize( numFrames );
+  for ( int f = 0; f < numFrames; f++ )
+  {
+    Rect roi( 100 + f * step.x, 80 + f * step.y, 40, 40 );
+    frames[f] = sequence.render( roi );
+    targets[f] = roi;
+  }
+}
+
+static Rect2d trackKCF( const TrackerKCF::Params& params, const std::vector<Mat>& frames, const Rect2d& target )
+{
+  Ptr<TrackerKCF> tracker = TrackerKCF::createTracker( params );
+  Rect2d boundingBox = target;
+  EXPECT_TRUE( tracker->init( frames[0], boundingBox ) );
+  for ( size_t f = 1; f < frames.size(); f++ )
+    EXPECT_TRUE( tracker->update( frames[f], boundingBox ) );
+  return boundingBox;
+}
+
+TEST( TrackerKCF, ScaleEstimation )
+{
+  std::vector<Mat> frames;
+  std::vector<Rect2d> targets;
+  generateGrowingTarget( frames, targets, 12, 1.03 );
+
+  TrackerKCF::Params params;
+  Rect2d fixed = trackKCF( params, frames, targets[0] );
+  EXPECT_EQ( targets[0].size(), fixed.size() );
+
+  params.scale_estimation = true;
+  Rect2d adaptive = trackKCF( params, frames, targets[0] );
+  const Rect2d& last = targets.back();
+  EXPECT_GT( adaptive.width, 1.15 * targets[0].width );
+  EXPECT_LT( std::abs( adaptive.width - last.width ), std::abs( fixed.width - last.width ) );
+  EXPECT_NEAR( adaptive.x + adaptive.width / 2, last.x + last.width / 2, 5 );
+  EXPECT_NEAR( adaptive.y + adaptive.height / 2, last.y + last.height / 2, 5 );
+}
+
+TEST( TrackerKCF, DefaultParamsTranslation )
+{
+  std::vector<Mat> frames;
+  std::vector<Rect2d> targets;
+  generateMovingTarget( frames, targets, 15, Point( 3, 2 ) );
+
+  Ptr<TrackerKCF> tracker = TrackerKCF::createTracker();
+  Rect2d boundingBox = targets[0];
+  ASSERT_TRUE( tracker->init( frames[0], boundingBox ) );
+  for ( size_t f = 1; f < frames.size(); f++ )
+  {
+    ASSERT_TRUE( tracker->update( frames[f], boundingBox ) );
+    EXPECT_NEAR( targets[f].x, boundingBox.x, 2 ) << "frame " << f;
+    EXPECT_NEAR( targets[f].y, boundingBox.y, 2 ) << "frame " << f;
+    EXPECT_EQ( targets[f].size(), boundingBox.size() ) << "frame " << f;
+  }
+}
+
+// Color-names only, without compression, so the tracking relies on the quantized ColorNames table alone
+TEST( TrackerKCF, ColorNamesTranslation )
+{
+  std::vector<Mat> frames;
+  std::vector<Rect2d> targets;
+  generateMovingTarget( frames, targets, 15, Point( 3, 2 ) );
+
+  TrackerKCF::Params params;
+  params.desc_npca = TrackerKCF::CN;
+  params.desc_pca = 0;
+  Ptr<TrackerKCF> tracker = TrackerKCF::createTracker( params );
+  Rect2d boundingBox = targets[0];
+  ASSERT_TRUE( tracker->init( frames[0], boundingBox ) );
+  for ( size_t f = 1; f < frames.size(); f++ )
+  {
+    ASSERT_TRUE( tracker->update( frames[f], boundingBox ) );
+    EXPECT_NEAR( targets[f].x, boundingBox.x, 2 ) << "frame " << f;
+    EXPECT_NEAR( targets[f].y, boundingBox.y, 2 ) << "frame " << f;
+  }
+}
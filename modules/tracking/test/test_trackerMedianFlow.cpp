@@ -0,0 +1,269 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "test_precomp.hpp"
+#include "opencv2/video/tracking.hpp"
+
+using namespace cv;
+
+// parameters of the Lucas-Kanade passes of MedianFlow
+static const Size lkWinSize( 3, 3 );
+static const int lkMaxLevel = 5;
+static const TermCriteria lkTermCrit( TermCriteria::COUNT | TermCriteria::EPS, 20, 0.3 );
+
+// grayscale frames with textured targets moving over textured background
+static void generateFrames( std::vector<Mat>& frames, std::vector<Rect2d>& targets, int numFrames )
+{
+  cvtest::SyntheticSequence sequence( Size( 320, 240 ), CV_8U );
+  const int numTargets = 2;
+  targets.clear();
+  for ( int i = 0; i < numTargets; i++ )
+  {
+    sequence.addTarget( Size( 40, 50 ) );
+    targets.push_back( Rect2d( 40 + 150 * i, 60 + 40 * i, 40, 50 ) );
+  }
+
+  frames.resize( numFrames );
+  std::vector<Rect> boxes( numTargets );
+  for ( int f = 0; f < numFrames; f++ )
+  {
+    for ( int i = 0; i < numTargets; i++ )
+      boxes[i] = Rect( (int)targets[i].x + 3 * f, (int)targets[i].y + ( i % 2 ? 2 * f : -f ), 40, 50 );
+    frames[f] = sequence.render( boxes );
+  }
+}
+
+// NCC of the patches as MedianFlow computed it with floating-point sums and norms
+static float referenceNCC( const Mat& oldImage, const Mat& newImage, Point2f oldPoint, Point2f newPoint )
+{
+  const int N = 900;
+  Mat p1, p2;
+  getRectSubPix( oldImage, Size( 30, 30 ), oldPoint, p1 );
+  getRectSubPix( newImage, Size( 30, 30 ), newPoint, p2 );
+
+  double s1 = sum( p1 )( 0 ), s2 = sum( p2 )( 0 );
+  double n1 = norm( p1 ), n2 = norm( p2 );
+  double prod = p1.dot( p2 );
+  double sq1 = sqrt( n1 * n1 - s1 * s1 / N ), sq2 = sqrt( n2 * n2 - s2 * s2 / N );
+  return (float)( ( sq2 == 0 ) ? sq1 / std::abs( sq1 ) : ( prod - s1 * s2 / N ) / sq1 / sq2 );
+}
+
+template<typename T>
+static T median( std::vector<T> values )
+{
+  std::sort( values.begin(), values.end() );
+  size_t n = values.size();
+  return n % 2 == 0 ? ( values[n / 2 - 1] + values[n / 2] ) / (T)2.0 : values[n / 2];
+}
+
+static double l2distance( Point2f p1, Point2f p2 )
+{
+  double dx = p1.x - p2.x, dy = p1.y - p2.y;
+  return sqrt( dx * dx + dy * dy );
+}
+
+// one step of MedianFlow with Lucas-Kanade passes on the images, which rebuild the pyramids on every call
+static bool medianFlowReference( const Mat& oldImage, const Mat& newImage, Rect2d& box )
+{
+  const int grid = 10;
+  std::vector<Point2f> oldPoints, newPoints;
+  for ( int i = 0; i < grid; i++ )
+    for ( int j = 0; j < grid; j++ )
+      oldPoints.push_back( Point2f( (float)( box.x + ( ( 1.0 * box.width ) / grid ) * j + .5 * box.width / grid ),
+                                    (float)( box.y + ( ( 1.0 * box.height ) / grid ) * i + .5 * box.height / grid ) ) );
+  int n = (int)oldPoints.size();
+
+  std::vector<uchar> status;
+  std::vector<float> errors;
+  calcOpticalFlowPyrLK( oldImage, newImage, oldPoints, newPoints, status, errors, lkWinSize, lkMaxLevel, lkTermCrit, 0 );
+
+  std::vector<Point2f> di;
+  for ( int i = 0; i < n; i++ )
+    if( status[i] == 1 )
+      di.push_back( newPoints[i] - oldPoints[i] );
+
+  std::vector<Point2f> reprojected;
+  calcOpticalFlowPyrLK( newImage, oldImage, newPoints, reprojected, status, errors, lkWinSize, lkMaxLevel, lkTermCrit, 0 );
+  std::vector<double> fbError( n );
+  std::vector<float> ncc( n );
+  for ( int i = 0; i < n; i++ )
+  {
+    fbError[i] = l2distance( oldPoints[i], reprojected[i] );
+    ncc[i] = referenceNCC( oldImage, newImage, oldPoints[i], newPoints[i] );
+  }
+  double fbMedian = median( fbError );
+  float nccMedian = median( ncc );
+
+  std::vector<Point2f> oldFiltered, newFiltered;
+  for ( int i = 0; i < n; i++ )
+  {
+    if( fbError[i] < fbMedian && ncc[i] > nccMedian )
+    {
+      oldFiltered.push_back( oldPoints[i] );
+      newFiltered.push_back( newPoints[i] );
+    }
+  }
+  if( oldFiltered.empty() || di.empty() )
+    return false;
+
+  // vote
+  int m = (int)oldFiltered.size();
+  std::vector<double> dx( m ), dy( m ), scales;
+  for ( int i = 0; i < m; i++ )
+  {
+    dx[i] = newFiltered[i].x - oldFiltered[i].x;
+    dy[i] = newFiltered[i].y - oldFiltered[i].y;
+    for ( int j = 0; j < i; j++ )
+    {
+      double od = l2distance( oldFiltered[i], oldFiltered[j] );
+      scales.push_back( od == 0.0 ? 0.0 : l2distance( newFiltered[i], newFiltered[j] ) / od );
+    }
+  }
+  double xshift = median( dx ), yshift = median( dy );
+  double scale = m == 1 ? 1.0 : median( scales );
+  Point2d center( box.x + box.width / 2.0 + xshift, box.y + box.height / 2.0 + yshift );
+  Rect2d newBox( center.x - scale * box.width / 2.0, center.y - scale * box.height / 2.0, scale * box.width, scale * box.height );
+
+  // a single point moves the box without setting the median displacement
+  Point2f mD = m == 1 ? Point2f() : Point2f( (float)xshift, (float)yshift );
+  std::vector<double> displacements;
+  for ( size_t i = 0; i < di.size(); i++ )
+  {
+    Point2f d = di[i] - mD;
+    displacements.push_back( sqrt( d.ddot( d ) ) );
+  }
+  if( median( displacements ) > 10 )
+    return false;
+
+  box = newBox;
+  return true;
+}
+
+static void trackReference( const std::vector<Mat>& frames, Rect2d box, std::vector<Rect2d>& results )
+{
+  results.clear();
+  for ( size_t f = 1; f < frames.size(); f++ )
+  {
+    ASSERT_TRUE( medianFlowReference( frames[f - 1], frames[f], box ) ) << "frame " << f;
+    results.push_back( box );
+  }
+}
+
+static void expectBoxNear( const Rect2d& actual, const Rect2d& expected, const std::string& where )
+{
+  const double eps = 1e-4;
+  EXPECT_NEAR( actual.x, expected.x, eps ) << where;
+  EXPECT_NEAR( actual.y, expected.y, eps ) << where;
+  EXPECT_NEAR( actual.width, expected.width, eps ) << where;
+  EXPECT_NEAR( actual.height, expected.height, eps ) << where;
+}
+
+TEST( TrackerMedianFlow, PyramidsMatchImages )
+{
+  std::vector<Mat> frames;
+  std::vector<Rect2d> targets;
+  generateFrames( frames, targets, 2 );
+
+  std::vector<Point2f> points;
+  for ( int y = 20; y < frames[0].rows - 20; y += 17 )
+    for ( int x = 20; x < frames[0].cols - 20; x += 17 )
+      points.push_back( Point2f( x + 0.25f, y + 0.5f ) );
+
+  std::vector<Mat> oldPyramid, newPyramid;
+  buildOpticalFlowPyramid( frames[0], oldPyramid, lkWinSize, lkMaxLevel, true );
+  buildOpticalFlowPyramid( frames[1], newPyramid, lkWinSize, lkMaxLevel, true );
+
+  // forward pass, then backward pass from the tracked points, as MedianFlow does
+  std::vector<Point2f> imagePoints, pyramidPoints, imageBack, pyramidBack;
+  std::vector<uchar> imageStatus, pyramidStatus;
+  std::vector<float> imageErrors, pyramidErrors;
+  calcOpticalFlowPyrLK( frames[0], frames[1], points, imagePoints, imageStatus, imageErrors, lkWinSize, lkMaxLevel, lkTermCrit, 0 );
+  calcOpticalFlowPyrLK( oldPyramid, newPyramid, points, pyramidPoints, pyramidStatus, pyramidErrors, lkWinSize, lkMaxLevel, lkTermCrit, 0 );
+  ASSERT_EQ( imageStatus, pyramidStatus );
+  EXPECT_LE( norm( imagePoints, pyramidPoints, NORM_INF ), 1e-5 );
+
+  calcOpticalFlowPyrLK( frames[1], frames[0], imagePoints, imageBack, imageStatus, imageErrors, lkWinSize, lkMaxLevel, lkTermCrit, 0 );
+  calcOpticalFlowPyrLK( newPyramid, oldPyramid, imagePoints, pyramidBack, pyramidStatus, pyramidErrors, lkWinSize, lkMaxLevel, lkTermCrit, 0 );
+  ASSERT_EQ( imageStatus, pyramidStatus );
+  EXPECT_LE( norm( imageBack, pyramidBack, NORM_INF ), 1e-5 );
+}
+
+TEST( TrackerMedianFlow, CachedPyramidsMatchReference )
+{
+  std::vector<Mat> frames;
+  std::vector<Rect2d> targets;
+  generateFrames( frames, targets, 8 );
+
+  std::vector<Rect2d> expected;
+  trackReference( frames, targets[0], expected );
+
+  Ptr<TrackerMedianFlow> tracker = TrackerMedianFlow::createTracker();
+  ASSERT_TRUE( tracker->init( frames[0], targets[0] ) );
+  for ( size_t f = 1; f < frames.size(); f++ )
+  {
+    Rect2d box;
+    ASSERT_TRUE( tracker->update( frames[f], box ) ) << "frame " << f;
+    expectBoxNear( box, expected[f - 1], format( "frame %d", (int)f ) );
+  }
+}
+
+TEST( TrackerMedianFlow, SharedPyramidsMatchReference )
+{
+  std::vector<Mat> frames;
+  std::vector<Rect2d> targets;
+  generateFrames( frames, targets, 8 );
+
+  std::vector<std::vector<Rect2d> > expected( targets.size() );
+  for ( size_t i = 0; i < targets.size(); i++ )
+    trackReference( frames, targets[i], expected[i] );
+
+  // the targets of MultiTracker are updated on the same frame and share its pyramid
+  MultiTracker trackers( "MEDIANFLOW" );
+  ASSERT_TRUE( trackers.add( frames[0], targets ) );
+  for ( size_t f = 1; f < frames.size(); f++ )
+  {
+    std::vector<Rect2d> boxes;
+    ASSERT_TRUE( trackers.update( frames[f], boxes ) );
+    ASSERT_EQ( boxes.size(), targets.size() );
+    for ( size_t i = 0; i < targets.size(); i++ )
+      expectBoxNear( boxes[i], expected[i][f - 1], format( "frame %d, target %d", (int)f, (int)i ) );
+  }
+}
@@ -0,0 +1,91 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+
+// target made of a few flat colored blocks, so that its histogram has only a few bins
+static void makeBlockTexture( Mat& texture )
+{
+  const Scalar colors[] = { Scalar( 200, 60, 30 ), Scalar( 30, 200, 60 ), Scalar( 60, 30, 200 ), Scalar( 40, 40, 40 ) };
+  int w = texture.cols / 2, h = texture.rows / 2;
+  for ( int i = 0; i < 4; i++ )
+    texture( Rect( ( i % 2 ) * w, ( i / 2 ) * h, w, h ) ).setTo( colors[i] );
+}
+
+// the sampler is created from the target in the first frame and has to find it moved in the second one
+static void checkMovedTarget( Size frameSize, bool blocks )
+{
+  cvtest::SyntheticSequence sequence( frameSize, CV_8UC3, 7 );
+  sequence.addTarget( Size( 40, 40 ) );
+  if( blocks )
+    makeBlockTexture( sequence.textures[0] );
+
+  Rect target( frameSize.width / 2 - 40, frameSize.height / 2 - 30, 40, 40 );
+  Rect moved = target + Point( 6, 4 );
+  Mat first = sequence.render( target ), second = sequence.render( moved );
+
+  TrackerSamplerPF sampler( first( target ) );
+  std::vector<Mat> samples;
+  ASSERT_TRUE( sampler.sampling( second, target, samples ) );
+  ASSERT_EQ( 1u, samples.size() );
+
+  Size wholeSize;
+  Point ofs;
+  samples[0].locateROI( wholeSize, ofs );
+  Rect found( ofs, samples[0].size() );
+  EXPECT_LE( std::abs( found.x + found.width / 2 - ( moved.x + moved.width / 2 ) ), 5 ) << found;
+  EXPECT_LE( std::abs( found.y + found.height / 2 - ( moved.y + moved.height / 2 ) ), 5 ) << found;
+}
+
+// the few bins of the target fit the integral histogram of the frame
+TEST( TrackerSamplerPF, FindsMovedTarget )
+{
+  checkMovedTarget( Size( 320, 240 ), true );
+}
+
+// the textured target fills too many bins for the integral histogram of a VGA frame,
+// so the patches are counted pixel by pixel
+TEST( TrackerSamplerPF, FindsMovedTexturedTarget )
+{
+  checkMovedTarget( Size( 640, 480 ), false );
+}
@@ -432,3 +432,111 @@ TEST(UKF, ungm_mean_squared_error)
 
     ASSERT_GE( mse_treshold, average_error );
 }
+
+// UNGM model propagating all sigma points in one call
+class UnivariateNonstationaryGrowthBatchModel: public UnivariateNonstationaryGrowthModel
+{
+public:
+    void stateConversionFunctionBatch(const Mat& x_k, const Mat& u_k, const Mat& v_k, Mat& x_kplus1)
+    {
+        double n = u_k.at<double>(0, 0);
+        double u = u_k.at<double>(0, 0);
+        const double* x = x_k.ptr<double>(0);
+        const double* q = v_k.ptr<double>(0);
+        double* x1 = x_kplus1.ptr<double>(0);
+        for (int i = 0; i < x_k.cols; i++)
+            x1[i] = 0.5*x[i] + 25*( x[i]/(x[i]*x[i] + 1) ) + 8*cos( 1.2*(n-1) ) + q[i] + u;
+    }
+    void measurementFunctionBatch(const Mat& x_k, const Mat& n_k, Mat& z_k)
+    {
+        const double* x = x_k.ptr<double>(0);
+        const double* r = n_k.ptr<double>(0);
+        double* y = z_k.ptr<double>(0);
+        for (int i = 0; i < x_k.cols; i++)
+            y[i] = x[i]*x[i]/20.0 + r[i];
+    }
+};
+
+static void createUNGMFilters( const Ptr<UkfSystemModel>& model, double initState, Ptr<UnscentedKalmanFilter>& ukf,
+                               Ptr<UnscentedKalmanFilter>& aukf )
+{
+    UnscentedKalmanFilterParams params( 1, 1, 0, 1.0, 1.0, model );
+    params.stateInit.at<double>(0, 0) = initState;
+    params.alpha = 1.5;
+    ukf = createUnscentedKalmanFilter( params );
+
+    AugmentedUnscentedKalmanFilterParams augParams( 1, 1, 0, 1.0, 1.0, model );
+    augParams.stateInit.at<double>(0, 0) = initState;
+    augParams.alpha = 1.5;
+    aukf = createAugmentedUnscentedKalmanFilter( augParams );
+}
+
+TEST(UKF, batched_model)
+{
+    Ptr<UnscentedKalmanFilter> ukf, aukf, ukfBatch, aukfBatch;
+    createUNGMFilters( makePtr<UnivariateNonstationaryGrowthModel>(), 0.0, ukf, aukf );
+    createUNGMFilters( makePtr<UnivariateNonstationaryGrowthBatchModel>(), 0.0, ukfBatch, aukfBatch );
+
+    RNG rng( 216 );
+    Mat u( 1, 1, CV_64F ), measurement( 1, 1, CV_64F );
+    for (int i = 0; i < 100; i++)
+    {
+        u.at<double>(0, 0) = (double)i;
+        measurement.at<double>(0, 0) = rng.gaussian( 10.0 );
+
+        ukf->predict( u );
+        ukfBatch->predict( u );
+        aukf->predict( u );
+        aukfBatch->predict( u );
+
+        ASSERT_LE( norm( ukf->correct( measurement ), ukfBatch->correct( measurement ), NORM_INF ), 1e-12 );
+        ASSERT_LE( norm( aukf->correct( measurement ), aukfBatch->correct( measurement ), NORM_INF ), 1e-12 );
+        ASSERT_LE( norm( ukf->getErrorCov(), ukfBatch->getErrorCov(), NORM_INF ), 1e-12 );
+        ASSERT_LE( norm( aukf->getErrorCov(), aukfBatch->getErrorCov(), NORM_INF ), 1e-12 );
+    }
+}
+
+TEST(UKF, multi_filter)
+{
+    const int numFilters = 64;
+    Ptr<UkfSystemModel> model = makePtr<UnivariateNonstationaryGrowthBatchModel>();
+
+    MultiUnscentedKalmanFilter multiFilter;
+    std::vector<Ptr<UnscentedKalmanFilter> > filters;
+    for (int j = 0; j < numFilters; j++)
+    {
+        Ptr<UnscentedKalmanFilter> ukf, aukf, ukfRef, aukfRef;
+        createUNGMFilters( model, 0.1*j, ukf, aukf );
+        createUNGMFilters( model, 0.1*j, ukfRef, aukfRef );
+        ASSERT_EQ( 2*j, multiFilter.add( ukf ) );
+        ASSERT_EQ( 2*j+1, multiFilter.add( aukf ) );
+        filters.push_back( ukfRef );
+        filters.push_back( aukfRef );
+    }
+    ASSERT_EQ( 2*numFilters, multiFilter.size() );
+
+    RNG rng( 117 );
+    std::vector<Mat> controls( filters.size() ), measurements( filters.size() );
+    for (int i = 0; i < 50; i++)
+    {
+        for (size_t j = 0; j < filters.size(); j++)
+        {
+            controls[j] = Mat( 1, 1, CV_64F, Scalar( (double)i ) );
+            // every third filter misses the measurement
+            measurements[j] = ( i + j ) % 3 ? Mat( 1, 1, CV_64F, Scalar( rng.gaussian( 10.0 ) ) ) : Mat();
+        }
+
+        multiFilter.predict( controls );
+        multiFilter.correct( measurements );
+
+        const std::vector<Mat>& states = multiFilter.getStates();
+        ASSERT_EQ( filters.size(), states.size() );
+        for (size_t j = 0; j < filters.size(); j++)
+        {
+            Mat state = filters[j]->predict( controls[j] );
+            if ( !measurements[j].empty() )
+                state = filters[j]->correct( measurements[j] );
+            ASSERT_EQ( 0.0, norm( state, states[j], NORM_INF ) ) << "filter " << j << ", step " << i;
+        }
+    }
+}